@@ -0,0 +1,156 @@
+/*
+ * Source for bit-packed alpha masks
+ */
+#include <cstdio>
+#include <vector>
+
+#include "sdl.h"
+#include "alpha_mask.h"
+
+using namespace ssg;
+
+
+/*
+ * Mask Levels
+ */
+
+void AlphaMask::Level::init(int w, int h){
+	width = w;
+	height = h;
+	wordsPerRow = (w + 31) / 32;
+	bits.assign(wordsPerRow * h, 0);
+}
+
+bool AlphaMask::Level::get(int x, int y) const {
+	Uint32 word = bits[y * wordsPerRow + (x >> 5)];
+	return (word >> (x & 31)) & 1;
+}
+
+void AlphaMask::Level::set(int x, int y){
+	bits[y * wordsPerRow + (x >> 5)] |= (Uint32) 1 << (x & 31);
+}
+
+
+
+/*
+ * AlphaMask
+ */
+
+AlphaMask *AlphaMask::createFromSurface(SDL_Surface *surface, Uint8 threshold){
+	/**
+	 * Builds a mask from the alpha channel of the provided surface.  A texel is
+	 * considered opaque if its alpha value is at least the provided threshold.
+	 * The surface itself is not modified.
+	 *
+	 * @return a new mask, or NULL if the surface could not be read.
+	 */
+	if(surface == NULL || surface->w < 1 || surface->h < 1) return NULL;
+
+	// Read the surface as RGBA8888, so that the alpha is always the low byte
+	SDL_Surface *converted = surface;
+	if(surface->format->format != SDL_PIXELFORMAT_RGBA8888){
+		converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA8888, 0);
+		if(converted == NULL){
+			printf("Unable to read surface for alpha mask.\n");
+			return NULL;
+		}
+	}
+
+	AlphaMask *mask = new AlphaMask(converted->w, converted->h);
+	Level &base = mask->levels[0];
+
+	if(SDL_MUSTLOCK(converted)) SDL_LockSurface(converted);
+	for(int y = 0; y < converted->h; y++){
+		const Uint32 *row = (const Uint32*) ((const Uint8*) converted->pixels + y * converted->pitch);
+		for(int x = 0; x < converted->w; x++){
+			if((row[x] & 0xff) >= threshold) base.set(x, y);
+		}
+	}
+	if(SDL_MUSTLOCK(converted)) SDL_UnlockSurface(converted);
+
+	if(converted != surface) SDL_FreeSurface(converted);
+
+	mask->buildPyramid();
+	return mask;
+}
+
+
+AlphaMask::AlphaMask(int w, int h):
+	width(w),
+	height(h)
+{
+	levels.resize(1);
+	levels[0].init(w, h);
+}
+
+
+void AlphaMask::buildPyramid(){
+	/*
+	 * The first coarse level covers blocks of texels; every level after that
+	 * halves the resolution until only a single bit is left.
+	 */
+	int shift = COARSE_BLOCK_SHIFT;
+	while(true){
+		const Level &below = levels.back();
+		if(below.width == 1 && below.height == 1) break;
+
+		Level level;
+		level.init(
+			((below.width - 1) >> shift) + 1,
+			((below.height - 1) >> shift) + 1
+		);
+		for(int y = 0; y < below.height; y++){
+			for(int x = 0; x < below.width; x++){
+				if(below.get(x, y)) level.set(x >> shift, y >> shift);
+			}
+		}
+		levels.push_back(level);
+		shift = 1;
+	}
+}
+
+
+bool AlphaMask::test(int x, int y) const {
+	/**
+	 * Checks whether or not the texel with the provided coordinates is opaque.
+	 * Coordinates outside of the mask are always transparent.
+	 */
+	if(x < 0 || y < 0 || x >= width || y >= height) return false;
+
+	// Quick rejection of empty blocks
+	if(levels.size() > 1){
+		if(!levels[1].get(x >> COARSE_BLOCK_SHIFT, y >> COARSE_BLOCK_SHIFT)) return false;
+	}
+
+	return levels[0].get(x, y);
+}
+
+
+bool AlphaMask::testLevel(int level, int x, int y) const {
+	/**
+	 * Checks whether or not any texel in the provided cell of the provided
+	 * pyramid level is opaque.  Level 0 has one cell per texel; level 1 has one
+	 * cell per 8x8 block and every level above that halves the resolution again.
+	 */
+	if(level < 0 || level >= (int) levels.size()) return false;
+	const Level &l = levels[level];
+	if(x < 0 || y < 0 || x >= l.width || y >= l.height) return false;
+	return l.get(x, y);
+}
+
+
+int AlphaMask::getLevelCount() const {
+	return levels.size();
+}
+
+
+size_t AlphaMask::getByteSize() const {
+	/**
+	 * @return the number of bytes of mask data, over all levels.
+	 */
+	size_t total = 0;
+	for(unsigned int i = 0; i < levels.size(); i++){
+		total += levels[i].bits.size() * sizeof(Uint32);
+	}
+	return total;
+}
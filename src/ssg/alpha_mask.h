@@ -0,0 +1,63 @@
+/*
+ * Declarations for bit-packed alpha masks.
+ *
+ * An AlphaMask stores one bit per texel of a texture, indicating whether or not
+ * that texel is (sufficiently) opaque.  It is used for pixel-accurate hit
+ * testing of textured components such as buttons, so that irregularly shaped
+ * images only respond to clicks on their visible parts.
+ *
+ * Level 0 of the mask has full texture resolution.  Above it is a pyramid of
+ * coarse levels, each of which ORs together 2x2 blocks of the level below,
+ * starting with 8x8 texel blocks.  These allow entire regions to be rejected
+ * quickly, and cost only a small fraction of the memory of level 0.
+ */
+#ifndef ALPHA_MASK_H
+#define ALPHA_MASK_H
+
+#include <vector>
+
+#include "shared_exports.h"
+#include "sdl.h"
+
+
+namespace ssg {
+
+	class SHARED_EXPORT AlphaMask {
+	public:
+		static AlphaMask *createFromSurface(SDL_Surface *surface, Uint8 threshold);
+
+		const int width, height;
+
+		bool test(int x, int y) const;
+		bool testLevel(int level, int x, int y) const;
+		int getLevelCount() const;
+
+		size_t getByteSize() const;
+
+	private:
+		/*
+		 * One level of the mask pyramid.  Rows are padded to a whole number of
+		 * 32-bit words.
+		 */
+		struct Level {
+			int width, height;
+			int wordsPerRow;
+			std::vector<Uint32> bits;
+
+			void init(int w, int h);
+			bool get(int x, int y) const;
+			void set(int x, int y);
+		};
+
+		// Side length (in texels) of the blocks of the first coarse level
+		static const int COARSE_BLOCK_SHIFT = 3;
+
+		std::vector<Level> levels;
+
+		AlphaMask(int w, int h);
+		void buildPyramid();
+	};
+
+}
+
+#endif
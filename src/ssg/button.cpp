@@ -33,6 +33,8 @@
 #include "button.h"
 #include "button_manager.h"
 #include "renderable.h"
+#include "texture.h"
+#include "alpha_mask.h"
 #include "vectormath.h"
 #include "geometry.h"
 
@@ -45,8 +47,11 @@ using namespace ssg;
  */
 
 ComponentButtonSimple2D::ComponentButtonSimple2D(Window *win):
-	overlayTexture(NULL),
-	pressedTexture(NULL)
+	overlayTexture(NULL, this),
+	pressedTexture(NULL, this),
+	hoverCursor(NULL, this),
+	hoverCursorX(0),
+	hoverCursorY(0)
 {
 	mainSprite = new ComponentSpriteSimple2D();
 	mainSprite->parent = this;
@@ -59,8 +64,13 @@ ComponentButtonSimple2D::ComponentButtonSimple2D(Window *win):
 }
 
 ComponentButtonSimple2D::~ComponentButtonSimple2D(){
-	if(overlayTexture != NULL) overlayTexture->removeOwner(this);
-	if(pressedTexture != NULL) pressedTexture->removeOwner(this);
+	// Do not leave the cursor of a deleted button on screen
+	if(hoverCursor.get() != NULL && mouseAlreadyOver){
+		Layer2D *layer = getLayer();
+		if(layer != NULL && layer->getWindow() != NULL){
+			layer->getWindow()->resetCursor();
+		}
+	}
 	
 	if(mainSprite != NULL) delete mainSprite;
 	if(textOverlay != NULL) delete textOverlay;
@@ -110,33 +120,40 @@ void ComponentButtonSimple2D::setTexture(Texture *tex){
 
 
 Texture *ComponentButtonSimple2D::getOverlayTexture() const {
-	return overlayTexture;
+	return overlayTexture.get();
 }
 
 Texture *ComponentButtonSimple2D::getPressedTexture() const {
-	return pressedTexture;
+	return pressedTexture.get();
 }
 
 void ComponentButtonSimple2D::setOverlayTexture(Texture *tex){
-	if(overlayTexture != NULL) overlayTexture->removeOwner(this);
-	if(tex != NULL) tex->addOwner(this);
-	overlayTexture = tex;
+	overlayTexture.reset(tex);
 }
 
 void ComponentButtonSimple2D::setPressedTexture(Texture *tex){
-	if(pressedTexture != NULL) pressedTexture->removeOwner(this);
-	if(tex != NULL) tex->addOwner(this);
-	pressedTexture = tex;
+	pressedTexture.reset(tex);
+}
+
+
+Texture *ComponentButtonSimple2D::getHoverCursor() const {
+	return hoverCursor.get();
+}
+
+void ComponentButtonSimple2D::setHoverCursor(Texture *tex, int hotX, int hotY){
+	/**
+	 * Sets a texture to be shown as the hardware cursor while the mouse is over
+	 * this button.  The hotspot is given in texels from the top left corner of
+	 * the texture.  Passing NULL restores the default cursor on hover.
+	 */
+	hoverCursor.reset(tex);
+	hoverCursorX = hotX;
+	hoverCursorY = hotY;
 }
 
 
 void ComponentButtonSimple2D::removeTextureReference(Texture *tex){
-	// Check the base texture
-	if(mainSprite != NULL) mainSprite->removeTextureReference(tex);
-	
-	// Check other textures
-	if(overlayTexture == tex) overlayTexture = NULL;
-	if(pressedTexture == tex) pressedTexture = NULL;
+	// The handles (and the main sprite's) have already been nulled out
 }
 
 
@@ -199,8 +216,8 @@ void ComponentButtonSimple2D::collectRenderables(
 	// Other Textures
 	RenderableSprite *overlaySprite, *pressedSprite;
 	
-	if(overlayTexture != NULL && mouseAlreadyOver){
-		overlaySprite = mainSprite->makeRenderableFromTexture(overlayTexture, viewport);
+	if(overlayTexture.get() != NULL && mouseAlreadyOver){
+		overlaySprite = mainSprite->makeRenderableFromTexture(overlayTexture.get(), viewport);
 		
 		if(overlaySprite != NULL){
 			overlaySprite->zMod = 1.0f;
@@ -208,8 +225,8 @@ void ComponentButtonSimple2D::collectRenderables(
 		}
 	}
 	
-	if(pressedTexture != NULL && pendingLeftClick){
-		pressedSprite = mainSprite->makeRenderableFromTexture(pressedTexture, viewport);
+	if(pressedTexture.get() != NULL && pendingLeftClick){
+		pressedSprite = mainSprite->makeRenderableFromTexture(pressedTexture.get(), viewport);
 		
 		if(pressedSprite != NULL){
 			pressedSprite->zMod = 2.0f;
@@ -258,10 +275,23 @@ void ComponentButtonSimple2D::processEvent(InputEvent *event, Layer2D *layer, fl
 
 
 
+void ComponentButtonSimple2D::lateLatch(Vector2f delta, bool shift){
+	ComponentButton2D::lateLatch(delta, shift);
+	
+	// The internal components are positioned relative to the button
+	shift = shift || isCursorBound();
+	if(mainSprite != NULL) mainSprite->lateLatch(delta, shift);
+	if(textOverlay != NULL) textOverlay->lateLatch(delta, shift);
+	if(virtualNode != NULL) virtualNode->lateLatch(delta, shift);
+}
+
+
+
 bool ComponentButtonSimple2D::isInside(float x, float y, Layer2D *layer){
 	/**
 	 * Check whether or not the provided coordinates (which use viewport coordinates)
-	 * are inside of the sprite's rectangle
+	 * are inside of the sprite's rectangle.  If the main texture has an alpha
+	 * mask, the coordinates must also land on an opaque texel.
 	 */
 	if(layer == NULL) return false;
 	Window *window = layer->getWindow();
@@ -324,7 +354,46 @@ bool ComponentButtonSimple2D::isInside(float x, float y, Layer2D *layer){
 
 	
 	Rect2f buttonRect(0, w * scaleAbsolute.x, h * scaleAbsolute.y, 0);
-	return calculate_intersection(buttonRect, eventCoordinates);
+	if(!calculate_intersection(buttonRect, eventCoordinates)) return false;
+
+
+	/*
+	 * If the texture has an alpha mask, the rectangle test is not enough; map
+	 * the event coordinates into texel space and check the mask.
+	 */
+	const AlphaMask *mask = texture != NULL ? texture->getAlphaMask() : NULL;
+	if(mask == NULL) return true;
+
+	float u = eventCoordinates.x / (w * scaleAbsolute.x);
+	float v = eventCoordinates.y / (h * scaleAbsolute.y);
+	int tx = (int) (u * mask->width);
+	int ty = (int) (v * mask->height);
+	if(tx >= mask->width) tx = mask->width - 1;
+	if(ty >= mask->height) ty = mask->height - 1;
+
+	return mask->test(tx, ty);
+}
+
+
+void ComponentButtonSimple2D::preStartMouseOver(MouseMotionEvent *event, float tpf){
+	if(hoverCursor.get() != NULL){
+		Layer2D *layer = getLayer();
+		if(layer != NULL && layer->getWindow() != NULL){
+			layer->getWindow()->setCursor(hoverCursor.get(), hoverCursorX, hoverCursorY);
+		}
+	}
+	ComponentButton2D::preStartMouseOver(event, tpf);
+}
+
+
+void ComponentButtonSimple2D::preEndMouseOver(MouseMotionEvent *event, float tpf){
+	if(hoverCursor.get() != NULL){
+		Layer2D *layer = getLayer();
+		if(layer != NULL && layer->getWindow() != NULL){
+			layer->getWindow()->resetCursor();
+		}
+	}
+	ComponentButton2D::preEndMouseOver(event, tpf);
 }
 
 
@@ -553,6 +622,12 @@ void ComponentDraggable2D::update(Layer2D *layer, float tpf){
 }
 
 
+bool ComponentDraggable2D::isCursorBound(){
+	// While being dragged, the component follows the cursor
+	return cursorBound || pendingLeftClick;
+}
+
+
 void ComponentDraggable2D::preLeftPress(MouseButtonEvent *event, float tpf){
 	// Choose a new anchor point
 	Layer2D *layer = getLayer();
@@ -147,6 +147,10 @@ namespace ssg {
 		void setOverlayTexture(Texture *tex);
 		void setPressedTexture(Texture *tex);
 		
+		// Hardware cursor shown while the mouse is over the button
+		Texture *getHoverCursor() const;
+		void setHoverCursor(Texture *tex, int hotX = 0, int hotY = 0);
+		
 	protected:
 		virtual void removeTextureReference(Texture *tex);
 	
@@ -164,12 +168,17 @@ namespace ssg {
 		virtual void update(Layer2D *layer, float tpf);
 		virtual void collectRenderables(std::list<Renderable*> &r, Viewport2D &v);
 		virtual void processEvent(InputEvent *event, Layer2D *layer, float tpf);
+		virtual void lateLatch(Vector2f delta, bool shift);
 
 	protected:
 		virtual bool isInside(float x, float y, Layer2D *layer);
+		virtual void preStartMouseOver(MouseMotionEvent *event, float tpf);
+		virtual void preEndMouseOver(MouseMotionEvent *event, float tpf);
 
 	private:
-		Texture *overlayTexture, *pressedTexture;
+		TextureRef overlayTexture, pressedTexture;
+		TextureRef hoverCursor;
+		int hoverCursorX, hoverCursorY;
 	
 		ComponentSpriteSimple2D *mainSprite;
 		ComponentSpriteText2D *textOverlay;
@@ -191,6 +200,7 @@ namespace ssg {
 		
 	internal:
 		virtual void update(Layer2D *layer, float tpf);
+		virtual bool isCursorBound();
 	
 	protected:
 		virtual void preLeftPress(MouseButtonEvent *event, float tpf);
@@ -0,0 +1,195 @@
+/*
+ * Source for the font cache
+ */
+#include <cstdio>
+#include <climits>
+#include <string>
+#include <map>
+#include <vector>
+#include <mutex>
+#include <utility>
+
+#include "sdl.h"
+#include "font_cache.h"
+#include "text_layout.h"
+
+using namespace ssg;
+
+
+std::mutex FontCache::mutex;
+std::map<std::pair<std::string, int>, TTF_Font*> FontCache::fonts;
+std::map<std::string, FontCache::FontFile*> FontCache::files;
+
+
+
+/*
+ * Lookup
+ */
+
+TTF_Font *FontCache::getFont(std::string path, int size){
+	/**
+	 * Gets the font at the provided path in the provided point size, opening
+	 * it if it is not open yet.
+	 *
+	 * @return the font, which belongs to the cache, or NULL if it could not be
+	 *         opened.
+	 */
+	std::lock_guard<std::mutex> guard(mutex);
+
+	std::pair<std::string, int> key(path, size);
+	auto cached = fonts.find(key);
+	if(cached != fonts.end()) return cached->second;
+
+	FontFile *file = loadFile(path);
+	if(file == NULL) return NULL;
+
+	// The memory stays with the file; the font only reads from it.
+	SDL_RWops *rw = SDL_RWFromConstMem(&file->bytes[0], file->bytes.size());
+	TTF_Font *font = rw != NULL ? TTF_OpenFontRW(rw, 1, size) : NULL;
+	if(font == NULL){
+		printf("Could not load font: %s\n", TTF_GetError());
+		if(file->fontCount == 0){
+			files.erase(path);
+			delete file;
+		}
+		return NULL;
+	}
+
+	file->fontCount++;
+	fonts[key] = font;
+	return font;
+}
+
+
+FontCache::FontFile *FontCache::loadFile(std::string path){
+	/*
+	 * Reads the whole font file, unless it already has been.  The caller must
+	 * hold the mutex.
+	 */
+	auto cached = files.find(path);
+	if(cached != files.end()) return cached->second;
+
+	SDL_RWops *rw = SDL_RWFromFile(path.c_str(), "rb");
+	if(rw == NULL){
+		printf("Could not load font: %s\n", SDL_GetError());
+		return NULL;
+	}
+
+	Sint64 size = SDL_RWsize(rw);
+	if(size <= 0){
+		printf("Could not load font: \"%s\" is empty.\n", path.c_str());
+		SDL_RWclose(rw);
+		return NULL;
+	}
+
+	FontFile *file = new FontFile();
+	file->bytes.resize(size);
+	file->fontCount = 0;
+	size_t read = SDL_RWread(rw, &file->bytes[0], 1, size);
+	SDL_RWclose(rw);
+	if(read != (size_t) size){
+		printf("Could not read font \"%s\".\n", path.c_str());
+		delete file;
+		return NULL;
+	}
+
+	files[path] = file;
+	return file;
+}
+
+
+
+/*
+ * Eviction
+ */
+
+void FontCache::evictFont(std::string path, int size){
+	/**
+	 * Closes one size of a font.  The file's bytes are freed along with its
+	 * last open size.
+	 */
+	std::lock_guard<std::mutex> guard(mutex);
+
+	auto font = fonts.find(std::pair<std::string, int>(path, size));
+	if(font != fonts.end()) closeFont(font);
+}
+
+
+void FontCache::evictFile(std::string path){
+	/**
+	 * Closes all sizes of a font, and frees the file's bytes.  The font's
+	 * metrics (see text_layout.h) are dropped with it.
+	 */
+	TextMetrics::evictFont(path);
+	
+	std::lock_guard<std::mutex> guard(mutex);
+
+	auto font = fonts.lower_bound(std::pair<std::string, int>(path, INT_MIN));
+	while(font != fonts.end() && font->first.first == path){
+		auto next = font;
+		next++;
+		closeFont(font);
+		font = next;
+	}
+}
+
+
+void FontCache::clear(){
+	/**
+	 * Closes all fonts.  Must happen before SDL_ttf shuts down.
+	 */
+	std::lock_guard<std::mutex> guard(mutex);
+
+	while(!fonts.empty()){
+		closeFont(fonts.begin());
+	}
+}
+
+
+void FontCache::closeFont(std::map<std::pair<std::string, int>, TTF_Font*>::iterator font){
+	/*
+	 * The caller must hold the mutex.
+	 */
+	std::string path = font->first.first;
+	TTF_CloseFont(font->second);
+	fonts.erase(font);
+
+	auto file = files.find(path);
+	if(file == files.end()) return;
+	file->second->fontCount--;
+	if(file->second->fontCount <= 0){
+		delete file->second;
+		files.erase(file);
+	}
+}
+
+
+
+/*
+ * Statistics
+ */
+
+int FontCache::getFontCount(){
+	std::lock_guard<std::mutex> guard(mutex);
+	return fonts.size();
+}
+
+
+int FontCache::getFileCount(){
+	std::lock_guard<std::mutex> guard(mutex);
+	return files.size();
+}
+
+
+size_t FontCache::getFileBytes(){
+	/**
+	 * @return the bytes of font files held in memory.
+	 */
+	std::lock_guard<std::mutex> guard(mutex);
+
+	size_t total = 0;
+	for(const auto &file : files){
+		total += file.second->bytes.size();
+	}
+	return total;
+}
@@ -0,0 +1,62 @@
+/*
+ * Declarations for the font cache.
+ *
+ * Opening a font with SDL_ttf reads and parses the whole font file.  Text
+ * textures and text layout need fonts constantly, so instead of opening their
+ * own, they get them from the FontCache, which keeps every font (path and
+ * size) open once it has been asked for.  The bytes of each font file are read
+ * only once, and shared by all sizes of the font.
+ *
+ * Notes:
+ * 1) Fonts belong to the cache; users must not close them.  A font stays valid
+ *    until it is evicted, so users should not keep it beyond the call in which
+ *    they got it.
+ * 2) The cache itself may be used from any thread.  As with SDL_ttf in general,
+ *    a single font must not be used by two threads at once.
+ * 3) The cache is cleared automatically when SDL shuts down, i.e. when the last
+ *    window is disposed.
+ */
+#ifndef FONT_CACHE_H
+#define FONT_CACHE_H
+
+#include <string>
+#include <map>
+#include <vector>
+#include <mutex>
+#include <utility>
+
+#include "shared_exports.h"
+#include "sdl.h"
+
+
+namespace ssg {
+
+	class SHARED_EXPORT FontCache {
+	public:
+		static TTF_Font *getFont(std::string path, int size);
+
+		static void evictFont(std::string path, int size);
+		static void evictFile(std::string path);
+		static void clear();
+
+		static int getFontCount();
+		static int getFileCount();
+		static size_t getFileBytes();
+
+	private:
+		struct FontFile {
+			std::vector<Uint8> bytes;
+			int fontCount;
+		};
+
+		static std::mutex mutex;
+		static std::map<std::pair<std::string, int>, TTF_Font*> fonts;
+		static std::map<std::string, FontFile*> files;
+
+		static FontFile *loadFile(std::string path);
+		static void closeFont(std::map<std::pair<std::string, int>, TTF_Font*>::iterator font);
+	};
+
+}
+
+#endif
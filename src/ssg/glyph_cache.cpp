@@ -0,0 +1,343 @@
+/*
+ * Source for glyph caching
+ */
+#include <cstdio>
+#include <string>
+#include <map>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <unordered_map>
+
+#include "sdl.h"
+#include "window.h"
+#include "font_cache.h"
+#include "glyph_cache.h"
+#include "text_layout.h"
+#include "texture_atlas.h"
+#include "texture_stats.h"
+
+using namespace ssg;
+
+
+// Size of the atlas pages glyphs are packed into
+static const int GLYPH_PAGE_SIZE = 512;
+
+// Memory used by each page
+static const size_t GLYPH_PAGE_BYTES = (size_t) GLYPH_PAGE_SIZE * GLYPH_PAGE_SIZE * 4;
+
+// Default number of pages a cache may have at once
+static const int DEFAULT_GLYPH_PAGE_LIMIT = 8;
+
+// Transparent gap kept to the right of and below every glyph
+static const int GLYPH_PADDING = 1;
+
+// Glyphs are rasterized in white, and tinted when drawn
+static const SDL_Color GLYPH_COLOR = {0xff, 0xff, 0xff, 0xff};
+
+
+
+/*
+ * GlyphRun
+ */
+
+GlyphRun::GlyphRun():
+	width(0),
+	height(0),
+	generation(-1)
+{}
+
+
+int GlyphRun::getWidth() const {return width;}
+
+int GlyphRun::getHeight() const {return height;}
+
+
+bool GlyphRun::isValid(const GlyphCache &cache) const {
+	/**
+	 * @return false if the run was never laid out, or the cache has been cleared
+	 *         since; its quads then refer to pages which no longer exist.
+	 */
+	return generation == cache.getGeneration();
+}
+
+
+
+/*
+ * Constructors and Destructors
+ */
+
+GlyphCache::GlyphCache(Window *win):
+	window(win),
+	glyphCount(0),
+	generation(0),
+	pageLimit(DEFAULT_GLYPH_PAGE_LIMIT),
+	full(false)
+{}
+
+
+GlyphCache::~GlyphCache(){
+	clear();
+}
+
+
+void GlyphCache::clear(){
+	/**
+	 * Frees all pages and forgets all glyphs.  Must be called before the
+	 * renderer which created the pages is destroyed.
+	 */
+	retirePages();
+	releaseRetiredPages();
+}
+
+
+void GlyphCache::retirePages(){
+	/*
+	 * Forgets all glyphs and pages, but keeps the textures of the pages until
+	 * releaseRetiredPages is called.
+	 */
+	for(auto &font : fonts){
+		delete font.second;
+	}
+	fonts.clear();
+
+	for(unsigned int i = 0; i < pages.size(); i++){
+		if(pages[i]->texture != NULL) retiredPages.push_back(pages[i]->texture);
+		delete pages[i];
+	}
+	pages.clear();
+
+	glyphCount = 0;
+	generation++;
+	full = false;
+}
+
+
+void GlyphCache::releaseRetiredPages(){
+	/**
+	 * Internal Method: Frees the pages left over from the cache starting over.
+	 * Called by the window at the end of every frame.
+	 */
+	for(unsigned int i = 0; i < retiredPages.size(); i++){
+		SDL_DestroyTexture(retiredPages[i]);
+		TextureStats::glyphPageDestroyed(GLYPH_PAGE_BYTES);
+	}
+	retiredPages.clear();
+}
+
+
+void GlyphCache::setPageLimit(int limit){
+	pageLimit = limit > 0 ? limit : 0;
+}
+
+
+int GlyphCache::getPageLimit() const {return pageLimit;}
+
+
+int GlyphCache::getPageCount() const {return pages.size();}
+
+int GlyphCache::getGlyphCount() const {return glyphCount;}
+
+int GlyphCache::getGeneration() const {return generation;}
+
+
+
+/*
+ * Layout
+ */
+
+bool GlyphCache::layout(std::string text, std::string font, int size, GlyphRun &run){
+	/**
+	 * Lays out a single line of text, rasterizing any glyphs not yet cached.
+	 *
+	 * @return false if the font could not be opened; the run is then empty.
+	 */
+	run.quads.clear();
+	run.width = 0;
+	run.height = 0;
+	run.generation = generation;
+
+	TTF_Font *ttf = FontCache::getFont(font, size);
+	if(ttf == NULL) return false;
+
+	const TextMetrics *metrics = TextMetrics::getMetrics(font, size);
+	if(metrics == NULL) return false;
+
+	/*
+	 * If the pages fill up, the cache starts over and the text is laid out
+	 * again, once; text which does not fit in all pages at once is left with
+	 * glyphs missing.
+	 */
+	std::pair<std::string, int> key(font, size);
+	for(int attempt = 0; attempt < 2; attempt++){
+		run.quads.clear();
+		run.generation = generation;
+
+		FontGlyphs *cached;
+		auto found = fonts.find(key);
+		if(found != fonts.end()){
+			cached = found->second;
+		}else{
+			cached = new FontGlyphs();
+			fonts[key] = cached;
+		}
+
+		// The pen moves just as TextMetrics::measure moves it
+		int pen = 0;
+		for(unsigned int i = 0; i < text.size(); i++){
+			unsigned char ch = text[i];
+			if(i > 0) pen += metrics->getKerning(text[i - 1], ch);
+
+			const Glyph *glyph = findGlyph(ttf, cached, ch);
+			if(glyph != NULL && glyph->page != NULL){
+				GlyphQuad quad;
+				quad.page = glyph->page;
+				quad.source = glyph->source;
+				quad.x = pen + glyph->offsetX;
+				quad.y = 0;
+				run.quads.push_back(quad);
+			}
+			pen += metrics->getAdvance(ch);
+		}
+
+		if(!full) break;
+		if(attempt == 0) retirePages();
+	}
+	full = false;
+
+	// Keep quads of the same page together, so that each page is drawn once
+	if(pages.size() > 1){
+		std::stable_sort(run.quads.begin(), run.quads.end(),
+			[](const GlyphQuad &a, const GlyphQuad &b){return a.page < b.page;});
+	}
+
+	run.width = metrics->measure(text);
+	run.height = metrics->getHeight();
+	return true;
+}
+
+
+const GlyphCache::Glyph *GlyphCache::findGlyph(TTF_Font *font, FontGlyphs *cached, Uint16 ch){
+	/*
+	 * Gets a glyph from the cache, rasterizing it on first use.  Returns NULL
+	 * if the font has no such glyph.
+	 */
+	auto found = cached->glyphs.find(ch);
+	if(found != cached->glyphs.end()) return &found->second;
+
+	int minX, maxX, minY, maxY, advance;
+	if(TTF_GlyphMetrics(font, ch, &minX, &maxX, &minY, &maxY, &advance) < 0){
+		return NULL;
+	}
+
+	Glyph glyph;
+	glyph.page = NULL;
+	glyph.source.x = 0;
+	glyph.source.y = 0;
+	glyph.source.w = 0;
+	glyph.source.h = 0;
+
+	// The cell is rendered like a one-character string, which starts left of
+	// the pen for glyphs which overhang to the left.
+	glyph.offsetX = minX < 0 ? minX : 0;
+
+	if(maxX > minX){
+		SDL_Surface *surface = TTF_RenderGlyph_Blended(font, ch, GLYPH_COLOR);
+		if(surface != NULL){
+			packGlyph(surface, glyph);
+			SDL_FreeSurface(surface);
+		}
+		
+		// Not cached, as the cache is about to start over
+		if(full) return NULL;
+	}
+
+	glyphCount++;
+	return &(cached->glyphs[ch] = glyph);
+}
+
+
+
+/*
+ * Pages
+ */
+
+bool GlyphCache::packGlyph(SDL_Surface *surface, Glyph &glyph){
+	/*
+	 * Copies a rasterized glyph into a page, starting a new one if none has
+	 * room.
+	 */
+	int w = surface->w + GLYPH_PADDING;
+	int h = surface->h + GLYPH_PADDING;
+	if(w > GLYPH_PAGE_SIZE || h > GLYPH_PAGE_SIZE){
+		printf("Glyph of size %dx%d does not fit in a glyph page.\n", surface->w, surface->h);
+		return false;
+	}
+
+	SDL_Rect slot;
+	Page *page = NULL;
+	for(unsigned int i = 0; i < pages.size() && page == NULL; i++){
+		if(pages[i]->packer.insert(w, h, slot)) page = pages[i];
+	}
+	if(page == NULL){
+		page = createPage();
+		if(page == NULL) return false;
+		page->packer.insert(w, h, slot);
+	}
+
+	SDL_Surface *converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+	if(converted == NULL){
+		printf("Unable to convert glyph: %s\n", SDL_GetError());
+		return false;
+	}
+
+	glyph.source.x = slot.x;
+	glyph.source.y = slot.y;
+	glyph.source.w = surface->w;
+	glyph.source.h = surface->h;
+
+	if(SDL_MUSTLOCK(converted)) SDL_LockSurface(converted);
+	SDL_UpdateTexture(page->texture, &glyph.source, converted->pixels, converted->pitch);
+	if(SDL_MUSTLOCK(converted)) SDL_UnlockSurface(converted);
+	SDL_FreeSurface(converted);
+
+	glyph.page = page->texture;
+	return true;
+}
+
+
+GlyphCache::Page *GlyphCache::createPage(){
+	if(pageLimit > 0 && (int) pages.size() >= pageLimit){
+		full = true;
+		return NULL;
+	}
+	
+	SDL_Renderer *renderer = window->getRenderer();
+	if(renderer == NULL){
+		printf("Cannot create glyph page; Window has no active renderer.\n");
+		return NULL;
+	}
+
+	SDL_Texture *texture = SDL_CreateTexture(
+		renderer,
+		SDL_PIXELFORMAT_ARGB8888,
+		SDL_TEXTUREACCESS_STATIC,
+		GLYPH_PAGE_SIZE,
+		GLYPH_PAGE_SIZE
+	);
+	if(texture == NULL){
+		printf("Cannot create glyph page: %s\n", SDL_GetError());
+		return NULL;
+	}
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+	// Static textures start out undefined; the padding must be transparent.
+	std::vector<Uint32> blank((size_t) GLYPH_PAGE_SIZE * GLYPH_PAGE_SIZE, 0);
+	SDL_UpdateTexture(texture, NULL, &blank[0], GLYPH_PAGE_SIZE * sizeof(Uint32));
+
+	Page *page = new Page(GLYPH_PAGE_SIZE, GLYPH_PAGE_SIZE);
+	page->texture = texture;
+	pages.push_back(page);
+	TextureStats::glyphPageCreated(GLYPH_PAGE_BYTES);
+	return page;
+}
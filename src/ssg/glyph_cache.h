@@ -0,0 +1,133 @@
+/*
+ * Declarations for glyph caching.
+ *
+ * Rendering a whole string into a texture means rasterizing every character
+ * again, and creating a new texture, whenever one character changes.  Instead,
+ * every Window has a GlyphCache, which rasterizes each glyph of each font and
+ * size once, into shared atlas pages (packed as in texture_atlas.h).  Glyphs
+ * are placed with the advances and kerning of the font's TextMetrics (see
+ * text_layout.h), so a run is exactly as wide as TextMetrics measures its text.
+ *
+ * Laying out a string then produces a GlyphRun: one quad per visible glyph,
+ * each a rectangle of an atlas page.  Runs are drawn with RenderableGlyphRun
+ * (see renderable.h), which draws all quads of a page with a single call to
+ * SDL_RenderGeometry.  Changing the text of a run costs only a new layout.
+ *
+ * Notes:
+ * 1) Glyphs are rasterized in white; runs are tinted by their vertex colors.
+ * 2) As with TTF_RenderText, strings are read as Latin-1.
+ * 3) Clearing the cache (also done when the window is disposed) invalidates
+ *    all runs laid out before; see GlyphRun::isValid.
+ * 4) The number of pages is limited.  When a glyph does not fit in any page
+ *    and no more may be made, the cache starts over: it is cleared, and the
+ *    layout which needed the glyph is redone.  Runs laid out before are laid
+ *    out again when next drawn.  The old pages are kept until the end of the
+ *    frame, as renderables already collected may still draw from them.
+ * 5) Page memory is reported by TextureStats::getGlyphPageBytes.
+ */
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include <string>
+#include <map>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+
+#include "shared_exports.h"
+#include "sdl.h"
+#include "texture_atlas.h"
+
+
+namespace ssg {
+
+	class Window;
+	class GlyphCache;
+	class TextMetrics;
+
+
+
+	struct GlyphQuad {
+		SDL_Texture *page;
+		SDL_Rect source;  // In the page
+		float x, y;       // Top-left corner, in pixels from the top-left of the run
+	};
+
+
+
+	class SHARED_EXPORT GlyphRun {
+	friend class GlyphCache;
+	public:
+		GlyphRun();
+
+		int getWidth() const;   // In pixels of the font
+		int getHeight() const;
+		bool isValid(const GlyphCache &cache) const;
+
+		// Quads of the same page are contiguous
+		std::vector<GlyphQuad> quads;
+
+	private:
+		int width, height;
+		int generation; // Of the cache which laid out the run; -1 if none
+	};
+
+
+
+	class SHARED_EXPORT GlyphCache {
+	public:
+		Window* const window;
+
+		GlyphCache(Window *win);
+		~GlyphCache();
+
+		bool layout(std::string text, std::string font, int size, GlyphRun &run);
+
+		void clear();
+
+		void setPageLimit(int limit); // 0 for no limit
+		int getPageLimit() const;
+
+		int getPageCount() const;
+		int getGlyphCount() const;
+		int getGeneration() const;
+
+	internal:
+		void releaseRetiredPages();
+
+	private:
+		struct Glyph {
+			SDL_Texture *page; // NULL for blank glyphs, e.g. spaces
+			SDL_Rect source;
+			int offsetX;       // Of the rasterized cell from the pen position
+		};
+
+		struct FontGlyphs {
+			std::unordered_map<Uint16, Glyph> glyphs;
+		};
+
+		struct Page {
+			SDL_Texture *texture;
+			SkylinePacker packer;
+
+			Page(int w, int h): texture(NULL), packer(w, h) {};
+		};
+
+		std::map<std::pair<std::string, int>, FontGlyphs*> fonts;
+		std::vector<Page*> pages;
+		int glyphCount;
+		int generation;
+
+		int pageLimit;
+		bool full; // A glyph found no room, and no page could be made
+		std::vector<SDL_Texture*> retiredPages;
+
+		const Glyph *findGlyph(TTF_Font *font, FontGlyphs *cached, Uint16 ch);
+		bool packGlyph(SDL_Surface *surface, Glyph &glyph);
+		Page *createPage();
+		void retirePages();
+	};
+
+}
+
+#endif
@@ -34,6 +34,9 @@ InputEvent *InputEvent::createInputEvent(SDL_Event event, Window *win){
 InputEvent::InputEvent(SDL_Event event, Window *win):
 	window(win),
 	sdlEvent(event),
+	timestamp(event.common.timestamp),
+	receiveTicks(SDL_GetTicks()),
+	receiveTime(SDL_GetPerformanceCounter()),
 	consumed(false)
 {}
 
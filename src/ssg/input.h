@@ -39,6 +39,11 @@ namespace ssg {
 		const SDL_Event sdlEvent;
 		
 	public:
+		// When the event happened (SDL ticks, in milliseconds)
+		const Uint32 timestamp;
+		// When the window received the event (SDL ticks and performance counter)
+		const Uint32 receiveTicks;
+		const Uint64 receiveTime;
 		
 		virtual std::string getType(){return "NONE";};
 	
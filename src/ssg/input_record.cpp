@@ -0,0 +1,239 @@
+/*
+ * Source for input recording and replay
+ */
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "sdl.h"
+#include "input_record.h"
+#include "window.h"
+
+using namespace ssg;
+
+
+static const char TRACE_MAGIC[4] = {'S', 'S', 'G', 'I'};
+static const Uint32 TRACE_VERSION = 1;
+
+
+static bool is_recordable(const SDL_Event &event){
+	/*
+	 * Some events carry pointers to memory owned by SDL or the application,
+	 * which would be meaningless when read back.
+	 */
+	if(event.type == SDL_DROPFILE || event.type == SDL_DROPTEXT) return false;
+	if(event.type == SDL_SYSWMEVENT) return false;
+	if(event.type >= SDL_USEREVENT) return false;
+	return true;
+}
+
+
+
+/*
+ * InputRecorder
+ */
+
+InputRecorder *InputRecorder::create(std::string path){
+	/**
+	 * Opens the provided file for writing and writes the trace header.
+	 * 
+	 * @return a new recorder, or NULL if the file could not be written.
+	 */
+	FILE *file = fopen(path.c_str(), "wb");
+	if(file == NULL){
+		printf("Unable to open input trace \"%s\" for writing.\n", path.c_str());
+		return NULL;
+	}
+	
+	Uint32 header[2] = {TRACE_VERSION, (Uint32) sizeof(SDL_Event)};
+	if(
+		fwrite(TRACE_MAGIC, sizeof(TRACE_MAGIC), 1, file) != 1 ||
+		fwrite(header, sizeof(header), 1, file) != 1
+	){
+		printf("Unable to write input trace \"%s\".\n", path.c_str());
+		fclose(file);
+		return NULL;
+	}
+	
+	return new InputRecorder(file);
+}
+
+
+InputRecorder::InputRecorder(FILE *f):
+	file(f),
+	frameOpen(false),
+	frameTpf(0.0f),
+	frameCount(0)
+{}
+
+
+InputRecorder::~InputRecorder(){
+	close();
+}
+
+
+void InputRecorder::beginFrame(float tpf){
+	/**
+	 * Starts recording a new frame, finishing the previous one.
+	 */
+	flushFrame();
+	frameOpen = true;
+	frameTpf = tpf;
+}
+
+
+void InputRecorder::recordEvent(const SDL_Event &event){
+	if(!frameOpen || !is_recordable(event)) return;
+	frameEvents.push_back(event);
+}
+
+
+void InputRecorder::flushFrame(){
+	if(!frameOpen || file == NULL) return;
+	
+	Uint32 count = frameEvents.size();
+	fwrite(&frameTpf, sizeof(float), 1, file);
+	fwrite(&count, sizeof(Uint32), 1, file);
+	if(count > 0) fwrite(&frameEvents[0], sizeof(SDL_Event), count, file);
+	
+	frameEvents.clear();
+	frameOpen = false;
+	frameCount++;
+}
+
+
+void InputRecorder::close(){
+	/**
+	 * Writes the last frame and closes the file.  Nothing more is recorded
+	 * afterwards.
+	 */
+	flushFrame();
+	if(file != NULL){
+		fclose(file);
+		file = NULL;
+	}
+}
+
+
+int InputRecorder::getFrameCount() const {return frameCount;}
+
+
+
+/*
+ * InputReplayer
+ */
+
+InputReplayer *InputReplayer::create(std::string path){
+	/**
+	 * Opens a trace written by an InputRecorder.
+	 * 
+	 * @return a new replayer, or NULL if the file is missing or was not
+	 * recorded on a compatible platform.
+	 */
+	FILE *file = fopen(path.c_str(), "rb");
+	if(file == NULL){
+		printf("Unable to open input trace \"%s\".\n", path.c_str());
+		return NULL;
+	}
+	
+	char magic[4];
+	Uint32 header[2];
+	if(
+		fread(magic, sizeof(magic), 1, file) != 1 ||
+		fread(header, sizeof(header), 1, file) != 1 ||
+		std::string(magic, 4) != std::string(TRACE_MAGIC, 4) ||
+		header[0] != TRACE_VERSION ||
+		header[1] != sizeof(SDL_Event)
+	){
+		printf("\"%s\" is not a compatible input trace.\n", path.c_str());
+		fclose(file);
+		return NULL;
+	}
+	
+	return new InputReplayer(file);
+}
+
+
+InputReplayer::InputReplayer(FILE *f): file(f) {}
+
+
+InputReplayer::~InputReplayer(){
+	if(file != NULL) fclose(file);
+}
+
+
+bool InputReplayer::readFrame(std::vector<SDL_Event> &events, float &tpf){
+	/**
+	 * Reads the next frame of the trace.
+	 * 
+	 * @param events a vector which is overwritten with the frame's events
+	 * @param tpf a float where the frame's tpf will be stored
+	 * @return false if the end of the trace has been reached.
+	 */
+	events.clear();
+	if(file == NULL) return false;
+	
+	Uint32 count;
+	if(fread(&tpf, sizeof(float), 1, file) != 1 || fread(&count, sizeof(Uint32), 1, file) != 1){
+		return false;
+	}
+	
+	events.resize(count);
+	if(count > 0 && fread(&events[0], sizeof(SDL_Event), count, file) != count){
+		printf("Input trace is truncated.\n");
+		events.clear();
+		return false;
+	}
+	
+	return true;
+}
+
+
+bool InputReplayer::playFrame(Window *window, bool realTime){
+	/**
+	 * Replays the next frame of the trace through the provided window, which
+	 * ignores live input while doing so.  The wall-clock time taken by the
+	 * frame is recorded (see getFrameTimes()).
+	 * 
+	 * @param window the window to replay the frame on
+	 * @param realTime if true, waits out the remainder of the recorded tpf so
+	 * that the trace plays at its original speed; otherwise, frames are played
+	 * back as fast as possible.
+	 * @return false if the trace has ended or the window is no longer active.
+	 * Once the trace has ended, the window goes back to live input.
+	 */
+	if(window == NULL || !window->isActive()) return false;
+	
+	std::vector<SDL_Event> events;
+	float tpf;
+	if(!readFrame(events, tpf)){
+		window->endReplay();
+		return false;
+	}
+	
+	Uint64 start = SDL_GetPerformanceCounter();
+	window->replayFrame(events, tpf);
+	float elapsed = (float) (SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+	frameTimes.push_back(elapsed);
+	
+	if(realTime && elapsed < tpf){
+		SDL_Delay((Uint32) ((tpf - elapsed) * 1000));
+	}
+	
+	return true;
+}
+
+
+int InputReplayer::getFrameCount() const {
+	/**
+	 * @return the number of frames played so far.
+	 */
+	return frameTimes.size();
+}
+
+const std::vector<float> &InputReplayer::getFrameTimes() const {
+	/**
+	 * @return the time (in seconds) taken by each frame played so far.
+	 */
+	return frameTimes;
+}
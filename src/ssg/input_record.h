@@ -0,0 +1,78 @@
+/*
+ * Declarations for deterministic input recording and replay.
+ *
+ * An InputRecorder (see Window::startRecording()) writes the raw SDL_Event
+ * stream received by a window, along with the tpf of every frame, to a compact
+ * binary file.  An InputReplayer feeds such a file back through a window, one
+ * frame at a time, in place of live input.  Combined with a headless video
+ * driver (see use_headless_video()), this allows the same interaction trace to
+ * be run against different builds and their frame times compared.
+ *
+ * File format: a header (magic "SSGI", format version, sizeof(SDL_Event)),
+ * followed by one record per frame: the frame's tpf (float), the number of
+ * events (Uint32) and then the raw events.  Events are stored in native byte
+ * order, so traces are only portable between identical platforms.
+ */
+#ifndef INPUT_RECORD_H
+#define INPUT_RECORD_H
+
+#include "shared_exports.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "sdl.h"
+
+
+namespace ssg {
+
+	class Window;
+
+
+	class SHARED_EXPORT InputRecorder {
+	public:
+		static InputRecorder *create(std::string path);
+	
+		~InputRecorder();
+	
+		void beginFrame(float tpf);
+		void recordEvent(const SDL_Event &event);
+		void close();
+	
+		int getFrameCount() const;
+	
+	private:
+		FILE *file;
+		bool frameOpen;
+		float frameTpf;
+		std::vector<SDL_Event> frameEvents;
+		int frameCount;
+	
+		InputRecorder(FILE *f);
+		void flushFrame();
+	};
+
+
+	class SHARED_EXPORT InputReplayer {
+	public:
+		static InputReplayer *create(std::string path);
+	
+		~InputReplayer();
+	
+		bool readFrame(std::vector<SDL_Event> &events, float &tpf);
+		bool playFrame(Window *window, bool realTime);
+	
+		int getFrameCount() const;
+		const std::vector<float> &getFrameTimes() const;
+	
+	private:
+		FILE *file;
+		std::vector<float> frameTimes;
+	
+		InputReplayer(FILE *f);
+	};
+
+}
+
+#endif
@@ -0,0 +1,215 @@
+/*
+ * Source for label placement
+ */
+#include <list>
+#include <vector>
+#include <algorithm>
+
+#include "geometry.h"
+#include "renderable.h"
+#include "label_placer.h"
+
+using namespace ssg;
+
+
+// Most cells along either side of the grid; larger areas get larger cells
+static const int GRID_MAX_CELLS = 128;
+
+
+
+LabelPlacer::LabelPlacer():
+	enabled(true),
+	padding(2.0f),
+	cellSize(32),
+	lastPixelSize(0.0f),
+	lastPadding(0.0f),
+	placedCount(0),
+	hiddenCount(0),
+	cached(false)
+{}
+
+
+LabelPlacer::~LabelPlacer(){
+	// Labels considered, but never placed
+	for(unsigned int i = 0; i < candidates.size(); i++){
+		delete candidates[i].renderable;
+	}
+}
+
+
+int LabelPlacer::getPlacedCount() const {return placedCount;}
+
+int LabelPlacer::getHiddenCount() const {return hiddenCount;}
+
+bool LabelPlacer::isCached() const {return cached;}
+
+
+void LabelPlacer::considerLabel(
+	const void *label,
+	Renderable *renderable,
+	Rect2f bounds,
+	int priority
+){
+	/**
+	 * Internal Method: Hands over the renderable of a label, to be drawn if
+	 * there is room for it.  The bounds are in viewport coordinates.
+	 */
+	if(renderable == NULL) return;
+
+	Candidate candidate;
+	candidate.label = label;
+	candidate.renderable = renderable;
+	candidate.bounds = bounds;
+	candidate.priority = priority;
+	candidates.push_back(candidate);
+}
+
+
+void LabelPlacer::place(std::list<Renderable*> &render_list, int screenHeight){
+	/**
+	 * Internal Method: Adds the renderables of the labels which were placed to
+	 * the render list, and deletes the others.  Called once all labels of the
+	 * frame have been considered.
+	 */
+	float pixelSize = screenHeight > 0 ? 2.0f / screenHeight : 0.0f;
+
+	if(!enabled){
+		lastPlaced.assign(candidates.size(), true);
+		lastCandidates.clear();
+		cached = false;
+	}else{
+		cached = matchesLast(pixelSize);
+		if(!cached){
+			computePlacement(pixelSize);
+			lastCandidates = candidates;
+			lastPixelSize = pixelSize;
+			lastPadding = padding;
+		}
+	}
+
+	placedCount = 0;
+	hiddenCount = 0;
+	for(unsigned int i = 0; i < candidates.size(); i++){
+		if(lastPlaced[i]){
+			render_list.push_back(candidates[i].renderable);
+			placedCount++;
+		}else{
+			delete candidates[i].renderable;
+			hiddenCount++;
+		}
+	}
+	candidates.clear();
+}
+
+
+bool LabelPlacer::matchesLast(float pixelSize) const {
+	/*
+	 * Whether the labels of this frame are those of the last placement, in the
+	 * same order, with the same bounds and priorities.
+	 */
+	if(pixelSize != lastPixelSize || padding != lastPadding) return false;
+	if(candidates.size() != lastCandidates.size()) return false;
+
+	for(unsigned int i = 0; i < candidates.size(); i++){
+		const Candidate &a = candidates[i];
+		const Candidate &b = lastCandidates[i];
+		if(a.label != b.label || a.priority != b.priority || !(a.bounds == b.bounds)){
+			return false;
+		}
+	}
+	return true;
+}
+
+
+static bool compare_priority(
+	const std::pair<int, int> &a,
+	const std::pair<int, int> &b
+){
+	return a.first > b.first;
+}
+
+
+static bool overlaps(const Rect2f &a, const Rect2f &b){
+	return a.xMin < b.xMax && b.xMin < a.xMax && a.yMin < b.yMax && b.yMin < a.yMax;
+}
+
+
+void LabelPlacer::computePlacement(float pixelSize){
+	/*
+	 * Places the labels from the highest priority down, skipping those which
+	 * overlap one placed before.  Every placed label is listed in the grid cells
+	 * it covers, so a label is only tested against those in its own cells.
+	 */
+	int count = candidates.size();
+	lastPlaced.assign(count, false);
+	if(count == 0) return;
+
+	// (priority, index), highest priority first; ties keep their order
+	std::vector<std::pair<int, int> > order(count);
+	for(int i = 0; i < count; i++) order[i] = std::make_pair(candidates[i].priority, i);
+	std::stable_sort(order.begin(), order.end(), compare_priority);
+
+	// Labels keep half of the padding each
+	float pad = 0.5f * padding * pixelSize;
+	std::vector<Rect2f> padded(count);
+	Rect2f area;
+	for(int i = 0; i < count; i++){
+		Rect2f r = candidates[i].bounds;
+		r.set(r.xMin - pad, r.xMax + pad, r.yMin - pad, r.yMax + pad);
+		padded[i] = r;
+
+		if(i == 0){
+			area = r;
+		}else{
+			area.set(
+				std::min(area.xMin, r.xMin),
+				std::max(area.xMax, r.xMax),
+				std::min(area.yMin, r.yMin),
+				std::max(area.yMax, r.yMax)
+			);
+		}
+	}
+
+	// Grid covering all labels
+	float cell = (cellSize > 0 ? cellSize : 1) * pixelSize;
+	if(cell <= 0) cell = 0.05f;
+	float cellW = std::max(cell, area.getWidth() / GRID_MAX_CELLS);
+	float cellH = std::max(cell, area.getHeight() / GRID_MAX_CELLS);
+	int columns = (int) (area.getWidth() / cellW) + 1;
+	int rows = (int) (area.getHeight() / cellH) + 1;
+
+	grid.resize(columns * rows);
+	for(unsigned int i = 0; i < grid.size(); i++) grid[i].clear();
+
+
+	for(int k = 0; k < count; k++){
+		int index = order[k].second;
+		const Rect2f &r = padded[index];
+
+		int c0 = std::min(columns - 1, (int) ((r.xMin - area.xMin) / cellW));
+		int c1 = std::min(columns - 1, (int) ((r.xMax - area.xMin) / cellW));
+		int r0 = std::min(rows - 1, (int) ((r.yMin - area.yMin) / cellH));
+		int r1 = std::min(rows - 1, (int) ((r.yMax - area.yMin) / cellH));
+
+		bool blocked = false;
+		for(int row = r0; row <= r1 && !blocked; row++){
+			for(int column = c0; column <= c1 && !blocked; column++){
+				const std::vector<int> &placed = grid[row * columns + column];
+				for(unsigned int j = 0; j < placed.size(); j++){
+					if(overlaps(r, padded[placed[j]])){
+						blocked = true;
+						break;
+					}
+				}
+			}
+		}
+		if(blocked) continue;
+
+		lastPlaced[index] = true;
+		for(int row = r0; row <= r1; row++){
+			for(int column = c0; column <= c1; column++){
+				grid[row * columns + column].push_back(index);
+			}
+		}
+	}
+}
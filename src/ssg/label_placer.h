@@ -0,0 +1,74 @@
+/*
+ * Declarations for label placement.
+ *
+ * Text sprites with declutter set are labels: rather than being drawn
+ * directly, their renderables are handed to the LabelPlacer of their layer.
+ * Once the whole scene graph is collected, labels are placed in order of
+ * priority (ties in the order they were collected), and a label is only drawn
+ * if it does not overlap one placed before it.  Overlaps are found with a grid
+ * of screen cells, so that each label is only tested against the labels near
+ * it.
+ *
+ * The result is kept for as long as the same labels are collected with the
+ * same bounds and priorities, e.g. while neither the viewport nor the labels
+ * move; the grid is then not built at all.
+ */
+#ifndef LABEL_PLACER_H
+#define LABEL_PLACER_H
+
+#include <list>
+#include <vector>
+
+#include "shared_exports.h"
+#include "geometry.h"
+
+
+namespace ssg {
+
+	class Renderable;
+
+
+
+	class SHARED_EXPORT LabelPlacer {
+	public:
+		bool enabled;   // If not, every label is drawn
+		float padding;  // Pixels kept clear around every label
+		int cellSize;   // Of the grid, in pixels
+
+		LabelPlacer();
+		~LabelPlacer();
+
+		int getPlacedCount() const;
+		int getHiddenCount() const;
+		bool isCached() const; // Whether the last placement was reused
+
+	internal:
+		void considerLabel(const void *label, Renderable *renderable, Rect2f bounds, int priority);
+		void place(std::list<Renderable*> &render_list, int screenHeight);
+
+	private:
+		struct Candidate {
+			const void *label;
+			Renderable *renderable;
+			Rect2f bounds; // Viewport coordinates
+			int priority;
+		};
+
+		std::vector<Candidate> candidates;
+
+		// The last placement, for reuse; its renderables are long gone
+		std::vector<Candidate> lastCandidates;
+		std::vector<bool> lastPlaced;
+		float lastPixelSize, lastPadding;
+		int placedCount, hiddenCount;
+		bool cached;
+
+		std::vector<std::vector<int> > grid;
+
+		bool matchesLast(float pixelSize) const;
+		void computePlacement(float pixelSize);
+	};
+
+}
+
+#endif
@@ -0,0 +1,151 @@
+/*
+ * Source for input latency instrumentation
+ */
+#include <cmath>
+#include <algorithm>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "sdl.h"
+#include "latency.h"
+#include "input.h"
+
+using namespace ssg;
+
+
+/*
+ * LatencyRecord
+ */
+
+LatencyRecord::LatencyRecord(int size):
+	samples(size > 0 ? size : 1, 0.0f),
+	next(0),
+	count(0)
+{}
+
+
+void LatencyRecord::addSample(float ms){
+	/**
+	 * Adds a sample, replacing the oldest one if the record is full.
+	 */
+	samples[next] = ms;
+	next = (next + 1) % samples.size();
+	if(count < (int) samples.size()) count++;
+}
+
+
+static float percentile(const std::vector<float> &sorted, float p){
+	// Nearest-rank percentile of an already sorted, non-empty list
+	int rank = (int) std::ceil(p * sorted.size());
+	if(rank < 1) rank = 1;
+	return sorted[rank - 1];
+}
+
+
+LatencyStats LatencyRecord::computeStats() const {
+	/**
+	 * Computes the 50th, 95th and 99th percentiles of the samples currently in
+	 * the record.  If there are no samples, all percentiles are zero.
+	 */
+	LatencyStats stats;
+	stats.sampleCount = count;
+	stats.p50 = 0.0f;
+	stats.p95 = 0.0f;
+	stats.p99 = 0.0f;
+	if(count == 0) return stats;
+	
+	std::vector<float> sorted(samples.begin(), samples.begin() + count);
+	std::sort(sorted.begin(), sorted.end());
+	
+	stats.p50 = percentile(sorted, 0.50f);
+	stats.p95 = percentile(sorted, 0.95f);
+	stats.p99 = percentile(sorted, 0.99f);
+	return stats;
+}
+
+
+int LatencyRecord::getSampleCount() const {return count;}
+
+
+
+/*
+ * LatencyTracker
+ */
+
+LatencyTracker::LatencyTracker(int size): recordSize(size) {}
+
+
+void LatencyTracker::eventReceived(InputEvent *event){
+	/**
+	 * Notes an event which has just been processed; it will be resolved when
+	 * the next frame is presented.
+	 */
+	if(event == NULL) return;
+	
+	PendingEvent entry;
+	entry.type = event->getType();
+	entry.receiveTime = event->receiveTime;
+	
+	// Spoofed events may not have a (sensible) SDL timestamp
+	if(event->timestamp != 0 && event->receiveTicks >= event->timestamp){
+		entry.queueDelay = (float) (event->receiveTicks - event->timestamp);
+	}else{
+		entry.queueDelay = 0.0f;
+	}
+	
+	pending.push_back(entry);
+}
+
+
+void LatencyTracker::framePresented(){
+	/**
+	 * Should be called right after a frame is presented.  Records the latency
+	 * of every event received since the previous frame.
+	 */
+	if(pending.empty()) return;
+	
+	Uint64 now = SDL_GetPerformanceCounter();
+	float msPerCount = 1000.0f / (float) SDL_GetPerformanceFrequency();
+	
+	for(unsigned int i = 0; i < pending.size(); i++){
+		const PendingEvent &entry = pending[i];
+		
+		std::map<std::string, LatencyRecord>::iterator record = records.find(entry.type);
+		if(record == records.end()){
+			record = records.insert(std::make_pair(entry.type, LatencyRecord(recordSize))).first;
+		}
+		
+		float latency = entry.queueDelay + (now - entry.receiveTime) * msPerCount;
+		record->second.addSample(latency);
+	}
+	
+	pending.clear();
+}
+
+
+LatencyStats LatencyTracker::getStats(std::string eventType) const {
+	std::map<std::string, LatencyRecord>::const_iterator record = records.find(eventType);
+	if(record == records.end()){
+		LatencyRecord empty(1);
+		return empty.computeStats();
+	}
+	return record->second.computeStats();
+}
+
+
+std::list<std::string> LatencyTracker::getEventTypes() const {
+	std::list<std::string> types;
+	std::map<std::string, LatencyRecord>::const_iterator iter;
+	for(iter = records.begin(); iter != records.end(); iter++){
+		types.push_back(iter->first);
+	}
+	return types;
+}
+
+
+void LatencyTracker::reset(){
+	pending.clear();
+	records.clear();
+}
@@ -0,0 +1,83 @@
+/*
+ * Declarations for input latency instrumentation.
+ *
+ * Every input event carries the SDL timestamp of when it happened and a
+ * high-resolution timestamp of when the window received it.  When the first
+ * frame reflecting an event is presented, the time elapsed since the event
+ * happened is recorded per event type.  Rolling percentiles of these latencies
+ * are available from Window::getInputLatency().
+ */
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include "shared_exports.h"
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "sdl.h"
+
+
+namespace ssg {
+
+	class InputEvent;
+
+
+	/*
+	 * Latency percentiles, in milliseconds
+	 */
+	struct SHARED_EXPORT LatencyStats {
+		int sampleCount;
+		float p50, p95, p99;
+	};
+
+
+	/*
+	 * A rolling window of latency samples
+	 */
+	class SHARED_EXPORT LatencyRecord {
+	public:
+		LatencyRecord(int size = 256);
+	
+		void addSample(float ms);
+		LatencyStats computeStats() const;
+		int getSampleCount() const;
+	
+	private:
+		std::vector<float> samples;
+		int next;
+		int count;
+	};
+
+
+	/*
+	 * Matches input events to the frames which present them
+	 */
+	class SHARED_EXPORT LatencyTracker {
+	public:
+		LatencyTracker(int recordSize = 256);
+	
+		void eventReceived(InputEvent *event);
+		void framePresented();
+	
+		LatencyStats getStats(std::string eventType) const;
+		std::list<std::string> getEventTypes() const;
+		void reset();
+	
+	private:
+		struct PendingEvent {
+			std::string type;
+			Uint64 receiveTime;
+			float queueDelay;  // milliseconds between the event and its receipt
+		};
+	
+		int recordSize;
+		std::vector<PendingEvent> pending;
+		std::map<std::string, LatencyRecord> records;
+	};
+
+}
+
+#endif
@@ -68,6 +68,22 @@ void Layer2D::update(float tpf){
 }
 
 
+void Layer2D::lateLatch(int dx, int dy){
+	/**
+	 * Moves cursor-bound components by the provided cursor motion (in screen
+	 * pixels) since the update step.
+	 */
+	if(rootNode == NULL || window == NULL) return;
+	
+	// Screen pixels -> viewport coordinates -> world coordinates
+	float pixelFactor = 2.0f / window->getScreenHeight();
+	Vector2f delta(dx * pixelFactor, -dy * pixelFactor);
+	delta.scale(viewport.getRadiusY());
+	
+	rootNode->lateLatch(delta, false);
+}
+
+
 void Layer2D::render(SDL_Renderer *renderer){
 	if(window == NULL){
 		printf("Cannot render layer \"%s\"; ", id.c_str());
@@ -84,10 +100,16 @@ void Layer2D::render(SDL_Renderer *renderer){
 		return;
 	}
 	
+	// Keep track of camera motion, for prefetching textures
+	viewport.trackMotion();
+	
 	// Construct list of rendererables by recursively traversing the scene graph
 	renderables.clear();
 	rootNode->collectRenderables(renderables, viewport);
 	
+	// Labels which were held back are only drawn where there is room
+	labelPlacer.place(renderables, window->getScreenHeight());
+	
 	// Sort the render list by z value
 	sort_renderables_by_z_level(renderables);
 	
@@ -95,11 +117,15 @@ void Layer2D::render(SDL_Renderer *renderer){
 	while(!renderables.empty()){
 		Renderable *renderable = renderables.front();
 		if(renderable != NULL){
+			// Batched geometry must be drawn before anything above it
+			if(!renderable->isBatched()) flush_geometry_batch(renderer);
+			
 			renderable->render(renderer, window);
 			delete renderable;
 		}
 		renderables.pop_front();
 	}
+	flush_geometry_batch(renderer);
 }
 
 void Layer2D::processEvent(InputEvent *event, float tpf){
@@ -12,6 +12,7 @@
 #include "viewport.h"
 #include "callback.h"
 #include "button_manager.h"
+#include "label_placer.h"
 
 
 namespace ssg {
@@ -36,6 +37,7 @@ namespace ssg {
 	internal:
 	
 		virtual void update(float tpf){};
+		virtual void lateLatch(int dx, int dy){};
 		virtual void render(SDL_Renderer *renderer) = 0;
 		virtual void processEvent(InputEvent *event, float tpf);
 	
@@ -77,6 +79,7 @@ namespace ssg {
 	public:
 		Viewport2D viewport;
 		ButtonManager buttonManager;
+		LabelPlacer labelPlacer;
 	
 	
 		Layer2D(std::string id);
@@ -84,6 +87,7 @@ namespace ssg {
 		
 	internal:
 		virtual void update(float tpf);
+		virtual void lateLatch(int dx, int dy);
 		virtual void render(SDL_Renderer *renderer);
 		virtual void processEvent(InputEvent *event, float tpf);
 		
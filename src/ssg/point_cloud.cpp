@@ -0,0 +1,317 @@
+/*
+ * Source for point cloud components
+ */
+#include <cmath>
+#include <list>
+#include <vector>
+#include <algorithm>
+
+#include "sdl.h"
+#include "point_cloud.h"
+#include "renderable.h"
+#include "viewport.h"
+#include "layer.h"
+#include "window.h"
+#include "geometry.h"
+
+using namespace ssg;
+
+
+
+ComponentPointCloud2D::ComponentPointCloud2D():
+	colorRed(0xff),
+	colorGreen(0xff),
+	colorBlue(0xff),
+	colorAlpha(0xff),
+	pointSize(1.0f),
+	worldSize(false),
+	maxSize(0.0f),
+	hasBounds(false),
+	uniformColor(true),
+	drawnPointCount(0)
+{}
+
+
+
+/*
+ * Points
+ */
+
+void ComponentPointCloud2D::addPoint(float x, float y){
+	SDL_Color color = {colorRed, colorGreen, colorBlue, colorAlpha};
+	addPoint(x, y, color, pointSize);
+}
+
+
+void ComponentPointCloud2D::addPoint(float x, float y, SDL_Color color, float size){
+	extendColors(color);
+	xPositions.push_back(x);
+	yPositions.push_back(y);
+	colors.push_back(color);
+	sizes.push_back(size);
+	extendBounds(x, y, size);
+}
+
+
+void ComponentPointCloud2D::addPoints(int count, const float *x, const float *y){
+	/**
+	 * Appends a block of points, of the default color and size.
+	 */
+	if(count <= 0 || x == NULL || y == NULL) return;
+
+	SDL_Color color = {colorRed, colorGreen, colorBlue, colorAlpha};
+	extendColors(color);
+	xPositions.insert(xPositions.end(), x, x + count);
+	yPositions.insert(yPositions.end(), y, y + count);
+	colors.insert(colors.end(), count, color);
+	sizes.insert(sizes.end(), count, pointSize);
+	for(int i = 0; i < count; i++) extendBounds(x[i], y[i], pointSize);
+}
+
+
+void ComponentPointCloud2D::addPoints(
+	int count,
+	const float *x,
+	const float *y,
+	const SDL_Color *c,
+	const float *s
+){
+	/**
+	 * Appends a block of points.  Each array holds count entries.
+	 */
+	if(count <= 0 || x == NULL || y == NULL || c == NULL || s == NULL) return;
+
+	for(int i = 0; i < count && uniformColor; i++) extendColors(c[i]);
+	xPositions.insert(xPositions.end(), x, x + count);
+	yPositions.insert(yPositions.end(), y, y + count);
+	colors.insert(colors.end(), c, c + count);
+	sizes.insert(sizes.end(), s, s + count);
+	for(int i = 0; i < count; i++) extendBounds(x[i], y[i], s[i]);
+}
+
+
+void ComponentPointCloud2D::reserve(int count){
+	if(count <= 0) return;
+	xPositions.reserve(count);
+	yPositions.reserve(count);
+	colors.reserve(count);
+	sizes.reserve(count);
+}
+
+
+void ComponentPointCloud2D::clearPoints(){
+	xPositions.clear();
+	yPositions.clear();
+	colors.clear();
+	sizes.clear();
+	bounds = Rect2f();
+	maxSize = 0.0f;
+	hasBounds = false;
+	uniformColor = true;
+}
+
+
+int ComponentPointCloud2D::getPointCount() const {return xPositions.size();}
+
+
+Vector2f ComponentPointCloud2D::getPosition(int index) const {
+	if(index < 0 || index >= (int) xPositions.size()) return Vector2f();
+	return Vector2f(xPositions[index], yPositions[index]);
+}
+
+
+SDL_Color ComponentPointCloud2D::getColor(int index) const {
+	if(index < 0 || index >= (int) colors.size()){
+		SDL_Color none = {0, 0, 0, 0};
+		return none;
+	}
+	return colors[index];
+}
+
+
+float ComponentPointCloud2D::getSize(int index) const {
+	if(index < 0 || index >= (int) sizes.size()) return 0.0f;
+	return sizes[index];
+}
+
+
+int ComponentPointCloud2D::getDrawnPointCount() const {return drawnPointCount;}
+
+
+void ComponentPointCloud2D::extendBounds(float x, float y, float size){
+	if(!hasBounds){
+		bounds.set(x, x, y, y);
+		hasBounds = true;
+	}else{
+		bounds.set(
+			std::min(bounds.xMin, x),
+			std::max(bounds.xMax, x),
+			std::min(bounds.yMin, y),
+			std::max(bounds.yMax, y)
+		);
+	}
+	if(size > maxSize) maxSize = size;
+}
+
+
+void ComponentPointCloud2D::extendColors(SDL_Color color){
+	/*
+	 * Must be called before the color is added.
+	 */
+	if(!uniformColor) return;
+	const SDL_Color &first = colors.empty() ? color : colors[0];
+	uniformColor = color.r == first.r && color.g == first.g &&
+	               color.b == first.b && color.a == first.a;
+}
+
+
+
+/*
+ * Rendering
+ */
+
+void ComponentPointCloud2D::collectRenderables(std::list<Renderable*> &render_list, Viewport2D &v){
+	int lastDrawn = drawnPointCount;
+	drawnPointCount = 0;
+	if(isHidden()) return;
+	if(xPositions.empty() || maxSize <= 0) return;
+
+	Layer2D *layer = getLayer();
+	if(layer == NULL) return;
+	Window *window = layer->getWindow();
+	if(window == NULL || window->getScreenHeight() <= 0) return;
+
+
+	// Linear part, and offset, of the transformation into viewport coordinates
+	float inverseRadius = v.getInverseRadiusY();
+	float cosine = std::cos(rotationAbsolute);
+	float sine = std::sin(rotationAbsolute);
+	float xx = cosine * scaleAbsolute.x * inverseRadius;
+	float xy = -sine * scaleAbsolute.y * inverseRadius;
+	float yx = sine * scaleAbsolute.x * inverseRadius;
+	float yy = cosine * scaleAbsolute.y * inverseRadius;
+	Vector2f offset = v.worldToViewport(positionAbsolute);
+
+	// Half of the width of a point of size 1, in viewport coordinates
+	float sizeFactor;
+	if(worldSize){
+		sizeFactor = 0.5f * std::fabs(scaleAbsolute.y) * inverseRadius;
+	}else{
+		sizeFactor = 1.0f / window->getScreenHeight();
+	}
+
+
+	// The whole cloud is skipped if its bounds are out of view
+	Rect2f cullRect = v.getViewportRect();
+	Vector2f corners[4] = {
+		Vector2f(bounds.xMin, bounds.yMin),
+		Vector2f(bounds.xMax, bounds.yMin),
+		Vector2f(bounds.xMax, bounds.yMax),
+		Vector2f(bounds.xMin, bounds.yMax)
+	};
+	for(int i = 0; i < 4; i++){
+		Vector2f c = corners[i];
+		corners[i] = Vector2f(xx * c.x + xy * c.y + offset.x, yx * c.x + yy * c.y + offset.y);
+	}
+	Rect2f cloudRect = Rect2f::boundPoints(corners, 4);
+	float reach = maxSize * sizeFactor;
+	cloudRect.set(
+		cloudRect.xMin - reach,
+		cloudRect.xMax + reach,
+		cloudRect.yMin - reach,
+		cloudRect.yMax + reach
+	);
+	if(!calculate_intersection(cloudRect, cullRect)) return;
+
+
+	/*
+	 * Points of one color, none of them wider than a pixel, are drawn as pixels
+	 * straight from the buffer, transformed directly into screen coordinates.
+	 */
+	int count = xPositions.size();
+	if(uniformColor && maxSize * sizeFactor * window->getScreenHeight() <= 1.0f){
+		float screen = 0.5f * window->getScreenHeight();
+		float aspect = window->getAspectRatio();
+		pixels.clear();
+
+		SDL_FPoint pixel;
+		for(int i = 0; i < count; i++){
+			if(sizes[i] <= 0) continue;
+			float x = xx * xPositions[i] + xy * yPositions[i] + offset.x;
+			float y = yx * xPositions[i] + yy * yPositions[i] + offset.y;
+			if(x < cullRect.xMin || x > cullRect.xMax || y < cullRect.yMin || y > cullRect.yMax){
+				continue;
+			}
+			pixel.x = screen * (x + aspect);
+			pixel.y = screen * (1 - y);
+			pixels.push_back(pixel);
+		}
+		drawnPointCount = pixels.size();
+
+		RenderablePixels *renderable = RenderablePixels::createRenderablePixels(
+			zLevelAbsolute,
+			&pixels,
+			colors[0]
+		);
+		if(renderable != NULL){
+			renderable->colorMod = colorModAbsolute;
+			render_list.push_back(renderable);
+		}
+		return;
+	}
+
+
+	/*
+	 * Each point is transformed, culled and, if in view, made into a square of
+	 * two triangles, in a single pass.
+	 */
+	std::vector<SDL_Vertex> vertices;
+	std::vector<int> indices;
+	// About as many points are in view as in the last frame
+	vertices.reserve(4 * lastDrawn);
+	indices.reserve(6 * lastDrawn);
+
+	SDL_Vertex vertex;
+	vertex.tex_coord.x = 0;
+	vertex.tex_coord.y = 0;
+
+	for(int i = 0; i < count; i++){
+		float x = xx * xPositions[i] + xy * yPositions[i] + offset.x;
+		float y = yx * xPositions[i] + yy * yPositions[i] + offset.y;
+		float half = sizes[i] * sizeFactor;
+		if(half <= 0) continue;
+		if(
+			x + half < cullRect.xMin || x - half > cullRect.xMax ||
+			y + half < cullRect.yMin || y - half > cullRect.yMax
+		){
+			continue;
+		}
+
+		int base = vertices.size();
+		vertex.color = colors[i];
+		vertex.position.x = x - half;
+		vertex.position.y = y + half;
+		vertices.push_back(vertex);
+		vertex.position.x = x + half;
+		vertices.push_back(vertex);
+		vertex.position.y = y - half;
+		vertices.push_back(vertex);
+		vertex.position.x = x - half;
+		vertices.push_back(vertex);
+
+		int quad[6] = {base, base + 1, base + 2, base, base + 2, base + 3};
+		indices.insert(indices.end(), quad, quad + 6);
+	}
+	drawnPointCount = vertices.size() / 4;
+
+	RenderableGeometry *geometry = RenderableGeometry::createRenderableGeometry(
+		zLevelAbsolute,
+		vertices,
+		indices,
+		cullRect
+	);
+	if(geometry != NULL){
+		geometry->colorMod = colorModAbsolute;
+		render_list.push_back(geometry);
+	}
+}
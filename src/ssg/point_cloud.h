@@ -0,0 +1,91 @@
+/*
+ * Declarations for point cloud components.
+ *
+ * A ComponentPointCloud2D holds any number of points, each with its own color
+ * and size, in one component.  Positions, colors and sizes are kept in
+ * separate arrays, so the points can be transformed and culled in a single
+ * pass over tightly packed positions.  Points in view are drawn as small
+ * squares of untextured geometry (see RenderableGeometry in renderable.h),
+ * all in one renderable, and so in as few draw calls as the batch allows.
+ * Clouds of a single color, whose points are no wider than a pixel, are drawn
+ * as pixels instead (see RenderablePixels), from a buffer kept between frames.
+ *
+ * Points are appended one at a time or in blocks.  Appending never touches
+ * the points already held, so clouds may grow every frame as data streams
+ * in; the bounds of the cloud are kept up to date as points are added, so
+ * a cloud entirely out of view costs no more than one test per frame.
+ *
+ * Notes:
+ * 1) Sizes are widths in pixels, or in world units if worldSize is set.
+ * 2) Points are squares aligned to the screen, whatever the rotation of the
+ *    component; their positions rotate with it.
+ */
+#ifndef POINT_CLOUD_H
+#define POINT_CLOUD_H
+
+#include <list>
+#include <vector>
+
+#include "shared_exports.h"
+#include "sdl.h"
+#include "geometry.h"
+#include "scene_graph.h"
+
+
+namespace ssg {
+
+	class Renderable;
+	class Viewport2D;
+
+
+
+	class SHARED_EXPORT ComponentPointCloud2D : public Component2D {
+	public:
+		// Defaults for points added without a color or size
+		Uint8 colorRed, colorGreen, colorBlue, colorAlpha;
+		float pointSize;
+
+		bool worldSize;
+
+		ComponentPointCloud2D();
+
+		void addPoint(float x, float y);
+		void addPoint(float x, float y, SDL_Color color, float size);
+		void addPoints(int count, const float *x, const float *y);
+		void addPoints(int count, const float *x, const float *y, const SDL_Color *colors, const float *sizes);
+		void reserve(int count);
+		void clearPoints();
+
+		int getPointCount() const;
+		Vector2f getPosition(int index) const;
+		SDL_Color getColor(int index) const;
+		float getSize(int index) const;
+		int getDrawnPointCount() const; // In the last frame
+
+	internal:
+		virtual void collectRenderables(std::list<Renderable*> &render_list, Viewport2D &v);
+
+	private:
+		// One entry per point; relative to the component
+		std::vector<float> xPositions, yPositions;
+		std::vector<SDL_Color> colors;
+		std::vector<float> sizes;
+
+		// Of all points, kept as they are added
+		Rect2f bounds;
+		float maxSize;
+		bool hasBounds;
+		bool uniformColor; // Whether all points have the color of the first
+
+		int drawnPointCount;
+
+		// Points in view, in screen coordinates, when drawn as pixels
+		std::vector<SDL_FPoint> pixels;
+
+		void extendBounds(float x, float y, float size);
+		void extendColors(SDL_Color color);
+	};
+
+}
+
+#endif
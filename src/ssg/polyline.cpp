@@ -0,0 +1,420 @@
+/*
+ * Source for polyline components
+ */
+#include <cmath>
+#include <list>
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+#include "sdl.h"
+#include "polyline.h"
+#include "renderable.h"
+#include "viewport.h"
+#include "layer.h"
+#include "window.h"
+#include "geometry.h"
+
+using namespace ssg;
+
+
+// Most levels of simplification; the last always holds every point
+static const int MAX_LEVELS = 24;
+
+
+
+ComponentPolyline2D::ComponentPolyline2D():
+	colorRed(0xff),
+	colorGreen(0xff),
+	colorBlue(0xff),
+	colorAlpha(0xff),
+	lineWidth(1.0f),
+	worldWidth(false),
+	closed(false),
+	miterLimit(4.0f),
+	simplifyTolerance(0.5f),
+	levelsValid(false),
+	currentLevel(-1),
+	drawnPointCount(0)
+{}
+
+
+
+/*
+ * Points
+ */
+
+void ComponentPolyline2D::addPoint(float x, float y){
+	points.push_back(Vector2f(x, y));
+	invalidateLevels();
+}
+
+
+void ComponentPolyline2D::addPoint(Vector2f point){
+	points.push_back(point);
+	invalidateLevels();
+}
+
+
+void ComponentPolyline2D::setPoint(int index, Vector2f point){
+	if(index < 0 || index >= (int) points.size()) return;
+	points[index] = point;
+	invalidateLevels();
+}
+
+
+void ComponentPolyline2D::setPoints(const std::vector<Vector2f> &p){
+	points = p;
+	invalidateLevels();
+}
+
+
+void ComponentPolyline2D::clearPoints(){
+	points.clear();
+	invalidateLevels();
+}
+
+
+int ComponentPolyline2D::getPointCount() const {return points.size();}
+
+
+Vector2f ComponentPolyline2D::getPoint(int index) const {
+	if(index < 0 || index >= (int) points.size()) return Vector2f();
+	return points[index];
+}
+
+
+
+/*
+ * Simplification
+ */
+
+void ComponentPolyline2D::invalidateLevels(){
+	levelsValid = false;
+	currentLevel = -1;
+}
+
+
+// Distance from p to the segment from a to b
+static float segment_distance(const Vector2f &p, const Vector2f &a, const Vector2f &b){
+	Vector2f ab = b - a;
+	Vector2f ap = p - a;
+	float lengthSquared = ab.dot(ab);
+	if(lengthSquared <= 0) return ap.norm();
+
+	float t = ap.dot(ab) / lengthSquared;
+	if(t < 0) t = 0;
+	if(t > 1) t = 1;
+	return (ap - ab * t).norm();
+}
+
+
+// Orders indices of points by rank, most significant first
+struct CompareRank {
+	const std::vector<float> &ranks;
+	CompareRank(const std::vector<float> &r): ranks(r) {}
+	bool operator()(int a, int b) const {return ranks[a] > ranks[b];}
+};
+
+
+void ComponentPolyline2D::buildLevels(){
+	/**
+	 * Builds the hierarchy of simplified lines, if the points have changed
+	 * since it was last built.  Called when the polyline is drawn, but may be
+	 * called earlier, e.g. right after the points are loaded, to keep the work
+	 * out of the first frame.
+	 */
+	if(levelsValid) return;
+	levelsValid = true;
+	currentLevel = -1;
+
+	int count = points.size();
+	pointsByRank.resize(count);
+	levelTolerances.clear();
+	levelSizes.clear();
+	if(count == 0) return;
+
+
+	/*
+	 * The rank of each point is the largest tolerance at which Douglas-Peucker
+	 * still keeps it: its distance from the segment it splits, but no more than
+	 * the rank of the point which split that segment in turn.  The ends are
+	 * always kept.  Segments are split with a stack rather than recursion, as
+	 * lines may hold millions of points.
+	 */
+	const float infinity = std::numeric_limits<float>::infinity();
+	std::vector<float> ranks(count, 0.0f);
+	ranks[0] = infinity;
+	ranks[count - 1] = infinity;
+
+	struct Span {int first, last; float rank;};
+	std::vector<Span> stack;
+	Span whole = {0, count - 1, infinity};
+	stack.push_back(whole);
+
+	float largest = 0.0f;
+	float smallest = infinity;
+	while(!stack.empty()){
+		Span span = stack.back();
+		stack.pop_back();
+		if(span.last - span.first < 2) continue;
+
+		const Vector2f &a = points[span.first];
+		const Vector2f &b = points[span.last];
+		int split = span.first + 1;
+		float distance = -1.0f;
+		for(int i = span.first + 1; i < span.last; i++){
+			float d = segment_distance(points[i], a, b);
+			if(d > distance){
+				distance = d;
+				split = i;
+			}
+		}
+
+		float rank = std::min(distance, span.rank);
+		ranks[split] = rank;
+		if(rank > largest) largest = rank;
+		if(rank > 0 && rank < smallest) smallest = rank;
+
+		Span left = {span.first, split, rank};
+		Span right = {split, span.last, rank};
+		stack.push_back(left);
+		stack.push_back(right);
+	}
+
+	for(int i = 0; i < count; i++) pointsByRank[i] = i;
+	std::stable_sort(pointsByRank.begin(), pointsByRank.end(), CompareRank(ranks));
+
+
+	// Levels halve the tolerance from the largest rank down to the smallest
+	int ranked = 0;
+	float tolerance = largest;
+	while(tolerance >= smallest && tolerance > 0 && (int) levelTolerances.size() < MAX_LEVELS - 1){
+		while(ranked < count && ranks[pointsByRank[ranked]] >= tolerance) ranked++;
+		levelTolerances.push_back(tolerance);
+		levelSizes.push_back(ranked);
+		tolerance *= 0.5f;
+	}
+	levelTolerances.push_back(0.0f);
+	levelSizes.push_back(count);
+}
+
+
+int ComponentPolyline2D::getLevelCount() const {return levelTolerances.size();}
+
+
+float ComponentPolyline2D::getLevelTolerance(int level) const {
+	if(level < 0 || level >= (int) levelTolerances.size()) return 0.0f;
+	return levelTolerances[level];
+}
+
+
+int ComponentPolyline2D::getDrawnPointCount() const {return drawnPointCount;}
+
+
+int ComponentPolyline2D::selectLevel(Viewport2D &viewport, Window *window){
+	/*
+	 * Index of the coarsest level whose tolerance, in the units of the points,
+	 * is within simplifyTolerance pixels on screen; -1 for every point.
+	 */
+	if(simplifyTolerance <= 0) return -1;
+
+	buildLevels();
+	if(levelTolerances.size() < 2) return -1;
+
+	float scale = std::max(std::fabs(scaleAbsolute.x), std::fabs(scaleAbsolute.y));
+	if(scale <= 0 || window->getScreenHeight() <= 0) return -1;
+
+	// Size of a pixel in world units, then in the units of the points
+	float pixelSize = 2.0f / (window->getScreenHeight() * viewport.getInverseRadiusY());
+	float tolerance = simplifyTolerance * pixelSize / scale;
+
+	int level = 0;
+	while(levelTolerances[level] > tolerance) level++;
+	return level;
+}
+
+
+
+/*
+ * Rendering
+ */
+
+void ComponentPolyline2D::collectRenderables(std::list<Renderable*> &render_list, Viewport2D &v){
+	if(isHidden()) return;
+	if(points.size() < 2 || lineWidth <= 0) return;
+
+	Layer2D *layer = getLayer();
+	if(layer == NULL) return;
+	Window *window = layer->getWindow();
+	if(window == NULL) return;
+
+
+	transformPoints(v, selectLevel(v, window));
+	int count = transformed.size();
+	drawnPointCount = count;
+
+	float halfWidth;
+	if(worldWidth){
+		halfWidth = 0.5f * lineWidth * std::fabs(scaleAbsolute.y) * v.getInverseRadiusY();
+	}else{
+		halfWidth = lineWidth / window->getScreenHeight();
+	}
+	float reach = halfWidth * (miterLimit > 1 ? miterLimit : 1);
+
+
+	// Directions of the segments; those of zero length take the last one
+	directions.resize(count - 1);
+	Vector2f last(1, 0);
+	for(int i = 0; i + 1 < count; i++){
+		Vector2f d = transformed[i + 1] - transformed[i];
+		float length = d.norm();
+		if(length > 0){
+			d.scale(1.0f / length);
+			last = d;
+		}
+		directions[i] = last;
+	}
+
+
+	/*
+	 * Each run of segments in view becomes a strip, with two vertices (one on
+	 * either side of the line) for every point.
+	 */
+	Rect2f cullRect = v.getViewportRect();
+	Rect2f reachRect(
+		cullRect.xMin - reach,
+		cullRect.xMax + reach,
+		cullRect.yMin - reach,
+		cullRect.yMax + reach
+	);
+
+	std::vector<SDL_Vertex> vertices;
+	std::vector<int> indices;
+
+	SDL_Vertex vertex;
+	vertex.color.r = colorRed;
+	vertex.color.g = colorGreen;
+	vertex.color.b = colorBlue;
+	vertex.color.a = colorAlpha;
+	vertex.tex_coord.x = 0;
+	vertex.tex_coord.y = 0;
+
+	int segment = 0;
+	while(segment < count - 1){
+		// Skip to the next segment in view
+		const Vector2f &a = transformed[segment];
+		const Vector2f &b = transformed[segment + 1];
+		Rect2f bounds(std::min(a.x, b.x), std::max(a.x, b.x), std::min(a.y, b.y), std::max(a.y, b.y));
+		if(!calculate_intersection(bounds, reachRect)){
+			segment++;
+			continue;
+		}
+
+		int first = segment;
+		for(segment++; segment < count - 1; segment++){
+			const Vector2f &c = transformed[segment];
+			const Vector2f &d = transformed[segment + 1];
+			Rect2f next(std::min(c.x, d.x), std::max(c.x, d.x), std::min(c.y, d.y), std::max(c.y, d.y));
+			if(!calculate_intersection(next, reachRect)) break;
+		}
+
+		// Points first to segment (inclusive) make up the run
+		for(int i = first; i <= segment; i++){
+			Vector2f miter = getMiter(i, halfWidth);
+			Vector2f left = transformed[i] + miter;
+			Vector2f right = transformed[i] - miter;
+
+			int base = vertices.size();
+			vertex.position.x = left.x;
+			vertex.position.y = left.y;
+			vertices.push_back(vertex);
+			vertex.position.x = right.x;
+			vertex.position.y = right.y;
+			vertices.push_back(vertex);
+
+			if(i == first) continue;
+			int quad[6] = {base - 2, base - 1, base, base - 1, base + 1, base};
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+
+	RenderableGeometry *geometry = RenderableGeometry::createRenderableGeometry(
+		zLevelAbsolute,
+		vertices,
+		indices,
+		cullRect
+	);
+	if(geometry != NULL){
+		geometry->colorMod = colorModAbsolute;
+		render_list.push_back(geometry);
+	}
+}
+
+
+void ComponentPolyline2D::transformPoints(Viewport2D &viewport, int level){
+	/*
+	 * Transforms the points of the provided level (or every point, if -1) into
+	 * viewport coordinates at once: scaled, rotated and moved with the
+	 * component, then into the viewport.  Closed polylines repeat their first
+	 * point at the end.
+	 */
+	float inverseRadius = viewport.getInverseRadiusY();
+	float cosine = std::cos(rotationAbsolute);
+	float sine = std::sin(rotationAbsolute);
+
+	// Linear part, and offset, of the whole transformation
+	float xx = cosine * scaleAbsolute.x * inverseRadius;
+	float xy = -sine * scaleAbsolute.y * inverseRadius;
+	float yx = sine * scaleAbsolute.x * inverseRadius;
+	float yy = cosine * scaleAbsolute.y * inverseRadius;
+	Vector2f offset = viewport.worldToViewport(positionAbsolute);
+
+	// The points of a level are kept, in order, until it changes
+	if(level >= 0 && level != currentLevel){
+		levelPoints.assign(pointsByRank.begin(), pointsByRank.begin() + levelSizes[level]);
+		std::sort(levelPoints.begin(), levelPoints.end());
+	}
+	currentLevel = level;
+
+	int count = level >= 0 ? levelPoints.size() : points.size();
+	transformed.resize(closed ? count + 1 : count);
+	for(int i = 0; i < count; i++){
+		const Vector2f &p = points[level >= 0 ? levelPoints[i] : i];
+		transformed[i].x = xx * p.x + xy * p.y + offset.x;
+		transformed[i].y = yx * p.x + yy * p.y + offset.y;
+	}
+	if(closed) transformed[count] = transformed[0];
+}
+
+
+Vector2f ComponentPolyline2D::getMiter(int index, float halfWidth) const {
+	/*
+	 * Offset from the point of the provided index to the left edge of the line.
+	 * At joins, this is along the bisector of the two segments, long enough to
+	 * keep the width of both, up to the miter limit.
+	 */
+	int segments = directions.size();
+	bool hasPrevious = index > 0 || closed;
+	bool hasNext = index < segments || closed;
+
+	Vector2f in = directions[index > 0 ? index - 1 : segments - 1];
+	Vector2f out = directions[index < segments ? index : 0];
+	if(!hasPrevious) in = out;
+	if(!hasNext) out = in;
+
+	Vector2f normalIn(-in.y, in.x);
+	Vector2f normalOut(-out.y, out.x);
+	Vector2f miter = normalIn + normalOut;
+	float length = miter.norm();
+	if(length < 1e-6f){
+		// The line turns back on itself
+		return normalOut * halfWidth;
+	}
+	miter.scale(1.0f / length);
+
+	float cosine = miter.dot(normalOut);
+	float limit = miterLimit > 1 ? miterLimit : 1;
+	float scale = cosine * limit > 1 ? halfWidth / cosine : halfWidth * limit;
+	return miter * scale;
+}
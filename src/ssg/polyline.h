@@ -0,0 +1,105 @@
+/*
+ * Declarations for polyline components.
+ *
+ * A ComponentPolyline2D holds any number of vertices in a single array, and
+ * draws all of them as one piece of untextured geometry (see
+ * RenderableGeometry in renderable.h): a triangle strip with real line widths
+ * and mitered joins.  Vertices are transformed in one pass, and runs of
+ * segments out of view are skipped before any triangles are made for them.
+ *
+ * Large polylines are simplified to the resolution of the screen.  When the
+ * points change, every point is ranked by the Douglas-Peucker tolerance below
+ * which it is kept, and the points are sorted by that rank; this forms a
+ * hierarchy of levels, each tolerance half that of the last.  When drawn, the
+ * coarsest level within simplifyTolerance pixels of the full line is used, so
+ * the number of points drawn follows the resolution of the screen rather than
+ * that of the data.
+ *
+ * Notes:
+ * 1) Widths are in pixels, or in world units if worldWidth is set.
+ * 2) Joins sharper than the miter limit are cut off at the limit.
+ * 3) The hierarchy is built the first time the polyline is drawn after its
+ *    points change, or by calling buildLevels.  It takes O(n log n) time for
+ *    most lines, and O(n) memory.
+ */
+#ifndef POLYLINE_H
+#define POLYLINE_H
+
+#include <list>
+#include <vector>
+
+#include "shared_exports.h"
+#include "sdl.h"
+#include "scene_graph.h"
+
+
+namespace ssg {
+
+	class Renderable;
+	class Viewport2D;
+	class Window;
+
+
+
+	class SHARED_EXPORT ComponentPolyline2D : public Component2D {
+	public:
+		Uint8 colorRed, colorGreen, colorBlue, colorAlpha;
+
+		float lineWidth;
+		bool worldWidth;
+
+		// Whether the last vertex is joined back to the first
+		bool closed;
+
+		// Longest miter, as a multiple of half of the line width
+		float miterLimit;
+
+		// Largest error allowed by simplification, in pixels; 0 to draw every point
+		float simplifyTolerance;
+
+		ComponentPolyline2D();
+
+		void addPoint(float x, float y);
+		void addPoint(Vector2f point);
+		void setPoint(int index, Vector2f point);
+		void setPoints(const std::vector<Vector2f> &points);
+		void clearPoints();
+
+		int getPointCount() const;
+		Vector2f getPoint(int index) const;
+
+		void buildLevels();
+		int getLevelCount() const;
+		float getLevelTolerance(int level) const; // In the units of the points
+		int getDrawnPointCount() const;           // In the last frame
+
+	internal:
+		virtual void collectRenderables(std::list<Renderable*> &render_list, Viewport2D &v);
+
+	private:
+		std::vector<Vector2f> points; // Relative to the component
+
+		// Simplification hierarchy; empty until built
+		std::vector<int> pointsByRank;      // Most significant first
+		std::vector<float> levelTolerances; // Decreasing, down to 0
+		std::vector<int> levelSizes;        // Points of pointsByRank in each level
+		bool levelsValid;
+
+		// Points of the level last drawn, in order
+		int currentLevel;
+		std::vector<int> levelPoints;
+		int drawnPointCount;
+
+		// Reused between frames
+		std::vector<Vector2f> transformed; // Viewport coordinates
+		std::vector<Vector2f> directions;  // Of each segment
+
+		void invalidateLevels();
+		int selectLevel(Viewport2D &viewport, Window *window);
+		void transformPoints(Viewport2D &viewport, int level);
+		Vector2f getMiter(int index, float halfWidth) const;
+	};
+
+}
+
+#endif
@@ -1,6 +1,7 @@
 #include <cmath>
 #include <cstdio>
 #include <string>
+#include <vector>
 
 #include "sdl.h"
 #include "renderable.h"
@@ -8,6 +9,7 @@
 #include "vectormath.h"
 #include "geometry.h"
 #include "texture.h"
+#include "glyph_cache.h"
 
 
 using namespace ssg;
@@ -64,7 +66,13 @@ void RenderableLine::render(SDL_Renderer *renderer, Window *window){
 	window->viewportToScreen(x2, y2, px2, py2);
 	
 	// Draw Color
-	SDL_SetRenderDrawColor(renderer, colorRed, colorGreen, colorBlue, colorAlpha);
+	SDL_SetRenderDrawColor(
+		renderer,
+		modulate_color(colorRed, colorMod.r),
+		modulate_color(colorGreen, colorMod.g),
+		modulate_color(colorBlue, colorMod.b),
+		modulate_color(colorAlpha, colorMod.a)
+	);
 	
 	SDL_RenderDrawLine(renderer, px1, py1, px2, py2);
 	
@@ -118,19 +126,74 @@ void RenderablePoint::render(SDL_Renderer *renderer, Window *window){
 	window->viewportToScreen(xPosition, yPosition, pixelX, pixelY);
 	
 	// Set render draw color
-	SDL_SetRenderDrawColor(renderer, 0xff, 0x00, 0x00, 0x00);
-	//SDL_SetRenderDrawColor(renderer, colorRed, colorGreen, colorBlue, colorAlpha);
+	SDL_SetRenderDrawColor(
+		renderer,
+		modulate_color(colorRed, colorMod.r),
+		modulate_color(colorGreen, colorMod.g),
+		modulate_color(colorBlue, colorMod.b),
+		modulate_color(colorAlpha, colorMod.a)
+	);
 	
 	SDL_RenderDrawPoint(renderer, pixelX, pixelY);
 }
 
 
+/*
+ * RenderablePixels
+ */
+
+RenderablePixels *RenderablePixels::createRenderablePixels(
+	float z,
+	const std::vector<SDL_FPoint> *pixels,
+	SDL_Color color
+){
+	// Culling is left to the component, which does it as it fills the pixels
+	if(pixels == NULL || pixels->empty() || color.a == 0) return NULL;
+	return new RenderablePixels(z, pixels, color);
+}
+
+
+RenderablePixels::RenderablePixels(float z, const std::vector<SDL_FPoint> *p, SDL_Color c):
+	Renderable(z),
+	pixels(p),
+	color(c)
+{}
+
+
+void RenderablePixels::render(SDL_Renderer *renderer, Window *window){
+	SDL_Color drawn = modulate_color(color, colorMod);
+	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+	SDL_SetRenderDrawColor(renderer, drawn.r, drawn.g, drawn.b, drawn.a);
+	SDL_RenderDrawPointsF(renderer, &(*pixels)[0], pixels->size());
+}
+
+
+
 /*
  * RenderableSprite
  */
 
-// Helper function for culling sprites
-static bool shouldCullSprite(
+static bool set_texture_mod(SDL_Texture *texture, SDL_Color mod){
+	/*
+	 * Applies the modulation of a renderable to its texture.
+	 *
+	 * @return false if there is none to apply.
+	 */
+	if(mod.r == 0xff && mod.g == 0xff && mod.b == 0xff && mod.a == 0xff) return false;
+	
+	SDL_SetTextureColorMod(texture, mod.r, mod.g, mod.b);
+	SDL_SetTextureAlphaMod(texture, mod.a);
+	return true;
+}
+
+
+static void reset_texture_mod(SDL_Texture *texture){
+	SDL_SetTextureColorMod(texture, 0xff, 0xff, 0xff);
+	SDL_SetTextureAlphaMod(texture, 0xff);
+}
+
+
+bool ssg::should_cull_sprite(
 	float x,
 	float y,
 	float w,
@@ -165,17 +228,29 @@ RenderableSprite *RenderableSprite::createRenderableSprite(
 	float z,
 	float r,
 	Texture *tex,
-	Rect2f cullRect
+	Rect2f cullRect,
+	const Rect2f *prefetchRect
 ){
 	if(tex == NULL){
 		return NULL;	
 	}
-	if(!tex->isLoaded()){
+	
+	// Quick check to make sure the sprite is onscreen
+	if(should_cull_sprite(x, y, w, h, r, cullRect)){
+		// Textures of sprites about to come onscreen are loaded ahead of time
+		if(prefetchRect != NULL && tex->window != NULL){
+			if(!should_cull_sprite(x, y, w, h, r, *prefetchRect)){
+				tex->window->textureResidency.prefetch(tex);
+			}
+		}
 		return NULL;
 	}
 	
-	// Quick check to make sure the sprite is onscreen
-	if(shouldCullSprite(x, y, w, h, r, cullRect)) return NULL;
+	if(!tex->isLoaded()){
+		// Textures evicted to save memory come back when they are needed
+		if(tex->window != NULL) tex->window->textureResidency.request(tex);
+		return NULL;
+	}
 	
 	// Otherwise, make the renderable
 	return new RenderableSprite(x, y, w, h, z, r, tex);
@@ -196,6 +271,7 @@ float r, Texture *tex):
 
 void RenderableSprite::render(SDL_Renderer *renderer, Window *window){
 	SDL_Texture *sdlTexture = texture->getSdlTexture();
+	window->textureResidency.touch(texture);
 	float deg = rotation * RAD_2_DEG;
 	
 	SDL_Rect dstrect;
@@ -207,7 +283,10 @@ void RenderableSprite::render(SDL_Renderer *renderer, Window *window){
 	//dstrect.h = 50;
 	
 	
-	render_copy_clip(renderer, sdlTexture, NULL, &dstrect, -deg);
+	// Textures may be shared, so their modulation only lasts for this copy
+	bool modulated = set_texture_mod(sdlTexture, colorMod);
+	render_copy_clip(renderer, sdlTexture, texture->getSourceRect(), &dstrect, -deg);
+	if(modulated) reset_texture_mod(sdlTexture);
 	
 	
 	/*SDL_Point center;
@@ -236,6 +315,7 @@ RenderableSpriteFixed *RenderableSpriteFixed::createRenderableSpriteFixed(
 		return NULL;	
 	}
 	if(!tex->isLoaded()){
+		if(tex->window != NULL) tex->window->textureResidency.request(tex);
 		return NULL;
 	}
 	
@@ -293,16 +373,241 @@ void RenderableSpriteFixed::render(SDL_Renderer *renderer, Window *window){
 	
 	if(!calculate_intersection(checkRect, cullRect)) return;
 	
+	window->textureResidency.touch(texture);
+	bool modulated = set_texture_mod(sdlTexture, colorMod);
+	SDL_RenderCopy(renderer, sdlTexture, texture->getSourceRect(), &dstrect);
+	if(modulated) reset_texture_mod(sdlTexture);
+}
 	
-	SDL_RenderCopy(renderer, sdlTexture, NULL, &dstrect);
+
+
+/*
+ * RenderableGlyphRun
+ */
+
+RenderableGlyphRun *RenderableGlyphRun::createRenderableGlyphRun(
+	float x,
+	float y,
+	float w,
+	float h,
+	float z,
+	float r,
+	const GlyphRun *run,
+	Uint8 cr,
+	Uint8 cg,
+	Uint8 cb,
+	Uint8 ca,
+	Rect2f cullRect
+){
+	if(run == NULL || run->quads.empty() || run->getWidth() < 1 || run->getHeight() < 1){
+		return NULL;
+	}
+	if(should_cull_sprite(x, y, w, h, r, cullRect)) return NULL;
+	
+	return new RenderableGlyphRun(x, y, w, h, z, r, run, cr, cg, cb, ca);
 }
+
+
+RenderableGlyphRun::RenderableGlyphRun(float x, float y, float w, float h, float z,
+float r, const GlyphRun *gr, Uint8 cr, Uint8 cg, Uint8 cb, Uint8 ca):
+	Renderable(z),
+	xPosition(x),
+	yPosition(y),
+	width(w),
+	height(h),
+	rotation(r),
+	colorRed(cr),
+	colorGreen(cg),
+	colorBlue(cb),
+	colorAlpha(ca),
+	run(gr)
+{}
+
+
+void RenderableGlyphRun::render(SDL_Renderer *renderer, Window *window){
+	/**
+	 * Draws the quads of the run, one SDL_RenderGeometry call per glyph page.
+	 * Like sprites, runs are rotated about their top-left corner.
+	 */
+	
+	// Reused between calls; rendering happens on the main thread only
+	static std::vector<SDL_Vertex> vertices;
+	static std::vector<int> indices;
+	
+	// Screen pixels per viewport unit, and viewport units per pixel of the run
+	float pixels = 0.5f * window->getScreenHeight();
+	float scaleX = width / run->getWidth();
+	float scaleY = height / run->getHeight();
+	
+	float cosine = std::cos(rotation);
+	float sine = std::sin(rotation);
+	float originX = pixels * (xPosition + window->getAspectRatio());
+	float originY = pixels * (1 - yPosition);
+	
+	SDL_Color color;
+	color.r = modulate_color(colorRed, colorMod.r);
+	color.g = modulate_color(colorGreen, colorMod.g);
+	color.b = modulate_color(colorBlue, colorMod.b);
+	color.a = modulate_color(colorAlpha, colorMod.a);
+	
+	const std::vector<GlyphQuad> &quads = run->quads;
+	unsigned int start = 0;
+	while(start < quads.size()){
+		SDL_Texture *page = quads[start].page;
+		int pageW, pageH;
+		SDL_QueryTexture(page, NULL, NULL, &pageW, &pageH);
+		
+		vertices.clear();
+		indices.clear();
+		
+		unsigned int end = start;
+		for(; end < quads.size() && quads[end].page == page; end++){
+			const GlyphQuad &quad = quads[end];
+			int base = vertices.size();
+			
+			for(int corner = 0; corner < 4; corner++){
+				float dx = corner == 1 || corner == 2 ? quad.source.w : 0;
+				float dy = corner >= 2 ? quad.source.h : 0;
+				
+				// Offset from the run's corner, in screen pixels (y down)
+				float px = (quad.x + dx) * scaleX * pixels;
+				float py = (quad.y + dy) * scaleY * pixels;
+				
+				SDL_Vertex vertex;
+				vertex.position.x = originX + cosine * px + sine * py;
+				vertex.position.y = originY - sine * px + cosine * py;
+				vertex.color = color;
+				vertex.tex_coord.x = (float) (quad.source.x + dx) / pageW;
+				vertex.tex_coord.y = (float) (quad.source.y + dy) / pageH;
+				vertices.push_back(vertex);
+			}
+			
+			indices.push_back(base);
+			indices.push_back(base + 1);
+			indices.push_back(base + 2);
+			indices.push_back(base);
+			indices.push_back(base + 2);
+			indices.push_back(base + 3);
+		}
+		
+		SDL_RenderGeometry(renderer, page, &vertices[0], vertices.size(), &indices[0], indices.size());
+		start = end;
+	}
+}
+
+
+
+/*
+ * RenderableGeometry
+ */
+
+// Geometry gathered for the next flush; rendering happens on the main thread only
+static std::vector<SDL_Vertex> batchVertices;
+static std::vector<int> batchIndices;
+
+// Batches are flushed early once they grow this large
+static const unsigned int BATCH_MAX_VERTICES = 65536;
+
+
+RenderableGeometry *RenderableGeometry::createRenderableGeometry(
+	float z,
+	std::vector<SDL_Vertex> &vertices,
+	std::vector<int> &indices,
+	Rect2f cullRect
+){
+	if(vertices.empty() || indices.size() < 3) return NULL;
+	
+	Rect2f bounds;
+	bounds.set(vertices[0].position.x, vertices[0].position.x,
+	           vertices[0].position.y, vertices[0].position.y);
+	for(unsigned int i = 1; i < vertices.size(); i++){
+		const SDL_FPoint &p = vertices[i].position;
+		if(p.x < bounds.xMin) bounds.xMin = p.x;
+		if(p.x > bounds.xMax) bounds.xMax = p.x;
+		if(p.y < bounds.yMin) bounds.yMin = p.y;
+		if(p.y > bounds.yMax) bounds.yMax = p.y;
+	}
+	if(!calculate_intersection(bounds, cullRect)) return NULL;
 	
+	RenderableGeometry *geometry = new RenderableGeometry(z);
+	geometry->vertices.swap(vertices);
+	geometry->indices.swap(indices);
+	return geometry;
+}
+
+
+RenderableGeometry::RenderableGeometry(float z):
+	Renderable(z)
+{}
+
+
+void RenderableGeometry::render(SDL_Renderer *renderer, Window *window){
+	/**
+	 * Adds the triangles to the batch, in screen coordinates.
+	 */
+	if(batchVertices.size() + vertices.size() > BATCH_MAX_VERTICES){
+		flush_geometry_batch(renderer);
+	}
+	
+	float pixels = 0.5f * window->getScreenHeight();
+	float aspect = window->getAspectRatio();
+	bool modulated = colorMod.r != 0xff || colorMod.g != 0xff ||
+	                 colorMod.b != 0xff || colorMod.a != 0xff;
+	
+	int base = batchVertices.size();
+	for(unsigned int i = 0; i < vertices.size(); i++){
+		SDL_Vertex vertex = vertices[i];
+		vertex.position.x = pixels * (vertex.position.x + aspect);
+		vertex.position.y = pixels * (1 - vertex.position.y);
+		if(modulated) vertex.color = modulate_color(vertex.color, colorMod);
+		batchVertices.push_back(vertex);
+	}
+	for(unsigned int i = 0; i < indices.size(); i++){
+		batchIndices.push_back(base + indices[i]);
+	}
+}
+
 
 
 /*
  * Helper Functions
  */
 
+void ssg::flush_geometry_batch(SDL_Renderer *renderer){
+	if(batchIndices.empty()){
+		batchVertices.clear();
+		return;
+	}
+	
+	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+	SDL_RenderGeometry(
+		renderer,
+		NULL,
+		&batchVertices[0],
+		batchVertices.size(),
+		&batchIndices[0],
+		batchIndices.size()
+	);
+	batchVertices.clear();
+	batchIndices.clear();
+}
+
+
+Uint8 ssg::modulate_color(Uint8 a, Uint8 b){
+	return (a * b + 127) / 255;
+}
+
+
+SDL_Color ssg::modulate_color(SDL_Color a, SDL_Color b){
+	SDL_Color product;
+	product.r = modulate_color(a.r, b.r);
+	product.g = modulate_color(a.g, b.g);
+	product.b = modulate_color(a.b, b.b);
+	product.a = modulate_color(a.a, b.a);
+	return product;
+}
+
+
 static bool compare_zlevel(const Renderable* a, const Renderable* b){
 	if(a->zLevel == b->zLevel) return a->zMod < b->zMod;
 	return a->zLevel < b->zLevel;
@@ -17,6 +17,7 @@
 
 #include <string>
 #include <list>
+#include <vector>
 
 #include "shared_exports.h"
 
@@ -28,6 +29,7 @@ namespace ssg {
 
 	class Window;
 	class Texture;
+	class GlyphRun;
 
 
 	class Renderable {
@@ -37,15 +39,24 @@ namespace ssg {
 	public:
 		const float zLevel;
 		float zMod;  // Used to distinguish between identical z-Levels
+		SDL_Color colorMod; // Multiplied into the colors drawn; white for none
 	
 		virtual ~Renderable(){};
 	
 		virtual std::string getType() const {return "Renderable";};
 	
 		virtual void render(SDL_Renderer *renderer, Window *window) = 0;
+		
+		// Batched renderables only draw once flush_geometry_batch is called
+		virtual bool isBatched() const {return false;};
 
 	protected:
-		Renderable(float z): zLevel(z), zMod(0.0f) {};
+		Renderable(float z): zLevel(z), zMod(0.0f) {
+			colorMod.r = 0xff;
+			colorMod.g = 0xff;
+			colorMod.b = 0xff;
+			colorMod.a = 0xff;
+		};
 	};
 
 
@@ -113,6 +124,32 @@ namespace ssg {
 	};
 
 
+	class RenderablePixels : public Renderable {
+		/**
+		 * Class of renderable single pixels of one color, drawn with a single call
+		 * to SDL_RenderDrawPointsF.  The pixels are not copied; they belong to the
+		 * component which made the renderable, and must be kept until it is drawn.
+		 * Unlike other renderables, their positions are in screen coordinates.
+		 */
+	public:
+		static RenderablePixels *createRenderablePixels(
+			float z,
+			const std::vector<SDL_FPoint> *pixels,
+			SDL_Color color
+		);
+	
+		const std::vector<SDL_FPoint> *pixels;
+		const SDL_Color color;
+	
+		virtual std::string getType() const {return "RenderablePixels";};
+	
+		virtual void render(SDL_Renderer *renderer, Window *window);
+	
+	protected:
+		RenderablePixels(float z, const std::vector<SDL_FPoint> *p, SDL_Color c);
+	};
+
+
 
 	class RenderableSprite : public Renderable {
 		/**
@@ -127,7 +164,8 @@ namespace ssg {
 			float z,
 			float r,
 			Texture *tex,
-			Rect2f cullRect
+			Rect2f cullRect,
+			const Rect2f *prefetchRect = NULL
 		);
 	
 	
@@ -181,10 +219,90 @@ namespace ssg {
 
 
 
+	class RenderableGlyphRun : public Renderable {
+		/**
+		 * Class of renderable lines of text, drawn from the glyph cache (see
+		 * glyph_cache.h).
+		 */
+	public:
+		static RenderableGlyphRun *createRenderableGlyphRun(
+			float xp,
+			float yp,
+			float w,
+			float h,
+			float z,
+			float r,
+			const GlyphRun *run,
+			Uint8 cr,
+			Uint8 cg,
+			Uint8 cb,
+			Uint8 ca,
+			Rect2f cullRect
+		);
+	
+		const float xPosition, yPosition; // Viewport Coordinates
+		const float width, height;  // Viewport Coordinates
+		const float rotation;
+		const Uint8 colorRed, colorGreen, colorBlue, colorAlpha;
+	
+		// Must outlive the renderable; it belongs to the component
+		const GlyphRun *run;
+	
+		virtual std::string getType() const {return "RenderableGlyphRun";};
+	
+		virtual void render(SDL_Renderer *renderer, Window *window);
+	
+	protected:
+		RenderableGlyphRun(float xp, float yp, float w, float h, float z, float r,
+		                   const GlyphRun *run, Uint8 cr, Uint8 cg, Uint8 cb, Uint8 ca);
+	};
+
+
+
+	class RenderableGeometry : public Renderable {
+		/**
+		 * Class of renderable untextured triangles.  Rather than being drawn one
+		 * at a time, consecutive geometry renderables are gathered into a batch,
+		 * and drawn with a single call to SDL_RenderGeometry.
+		 */
+	public:
+		// Takes the contents of the vectors, which are left empty
+		static RenderableGeometry *createRenderableGeometry(
+			float z,
+			std::vector<SDL_Vertex> &vertices,
+			std::vector<int> &indices,
+			Rect2f cullRect
+		);
+	
+		// Positions in viewport coordinates; three indices per triangle
+		std::vector<SDL_Vertex> vertices;
+		std::vector<int> indices;
+	
+		virtual std::string getType() const {return "RenderableGeometry";};
+	
+		virtual void render(SDL_Renderer *renderer, Window *window);
+		virtual bool isBatched() const {return true;};
+	
+	protected:
+		RenderableGeometry(float z);
+	};
+
+
+
 	/*
 	 * Helper Functions
 	 */
 	void sort_renderables_by_z_level(std::list<Renderable*> &renderables);
+	
+	// Draws the geometry gathered since the last flush
+	void flush_geometry_batch(SDL_Renderer *renderer);
+	
+	// Product of two colors, as in SDL's color modulation
+	Uint8 modulate_color(Uint8 a, Uint8 b);
+	SDL_Color modulate_color(SDL_Color a, SDL_Color b);
+	
+	// Whether a rotated rectangle (in viewport coordinates) lies outside cullRect
+	bool should_cull_sprite(float x, float y, float w, float h, float r, Rect2f cullRect);
 }
 
 #endif
@@ -1,5 +1,7 @@
 #include <cstdio>
 #include <list>
+#include <vector>
+#include <algorithm>
 
 #include "scene_graph.h"
 #include "renderable.h"
@@ -27,6 +29,12 @@ Component2D::Component2D():
 	inheritRotation(true),
 	inheritScale(true),
 	inheritHidden(true),
+	colorModRed(0xff),
+	colorModGreen(0xff),
+	colorModBlue(0xff),
+	alphaMod(0xff),
+	inheritColorMod(true),
+	cursorBound(false),
 	positionAbsolute(0, 0),
 	zLevelAbsolute(0),
 	rotationAbsolute(0),
@@ -34,7 +42,12 @@ Component2D::Component2D():
 	locked(false),
 	parent(NULL),
 	hidden(false)
-{}
+{
+	colorModAbsolute.r = 0xff;
+	colorModAbsolute.g = 0xff;
+	colorModAbsolute.b = 0xff;
+	colorModAbsolute.a = 0xff;
+}
 
 Component2D::~Component2D(){
 	detachFromParent();
@@ -55,9 +68,17 @@ void Component2D::computeAbsolutePosition(Component2D *reference){
 	scaleAbsolute = scale;
 	rotationAbsolute = rotation;
 	positionAbsolute = position;
+	colorModAbsolute.r = colorModRed;
+	colorModAbsolute.g = colorModGreen;
+	colorModAbsolute.b = colorModBlue;
+	colorModAbsolute.a = alphaMod;
 	
 	if(reference == NULL) return;
 	
+	if(inheritColorMod){
+		colorModAbsolute = modulate_color(colorModAbsolute, reference->colorModAbsolute);
+	}
+	
 	if(inheritZLevel){
 		zLevelAbsolute += reference->zLevelAbsolute;
 	}
@@ -158,6 +179,20 @@ void Component2D::processEvent(InputEvent *event, Layer2D *layer, float tpf){
 }
 
 
+void Component2D::lateLatch(Vector2f delta, bool shift){
+	/**
+	 * Internal Method: Called after the update step, just before rendering, with
+	 * the (world coordinate) motion of the cursor since the update step.  If this
+	 * component is cursor-bound (or a descendant of one), its absolute position
+	 * is moved along with the cursor.
+	 * 
+	 * @param delta the cursor motion since the update step in world coordinates
+	 * @param shift whether or not an ancestor of this component was shifted
+	 */
+	if(shift || isCursorBound()) positionAbsolute += delta;
+}
+
+
 
 
 
@@ -193,6 +228,7 @@ void ComponentPoint2D::collectRenderables(std::list<Renderable*> &render_list, V
 		v.getViewportRect()
 	);
 	if(point != NULL){
+		point->colorMod = colorModAbsolute;
 		render_list.push_back(point);
 	}
 }
@@ -258,12 +294,154 @@ void ComponentLine2D::collectRenderables(std::list<Renderable*> &render_list, Vi
 		v.getViewportRect()
 	);
 	if(line != NULL){
+		line->colorMod = colorModAbsolute;
 		render_list.push_back(line);
 	}
 }
 
 
 
+/*
+ * ComponentRect2D
+ */
+
+ComponentRect2D::ComponentRect2D():
+	fixedSize(false),
+	width(1.0f),
+	height(1.0f),
+	filled(true),
+	colorRed(0xff),
+	colorGreen(0xff),
+	colorBlue(0xff),
+	colorAlpha(0xff),
+	outlined(false),
+	outlineWidth(1.0f),
+	outlineRed(0xff),
+	outlineGreen(0xff),
+	outlineBlue(0xff),
+	outlineAlpha(0xff)
+{}
+
+
+ComponentRect2D::ComponentRect2D(float w, float h):
+	fixedSize(false),
+	width(w),
+	height(h),
+	filled(true),
+	colorRed(0xff),
+	colorGreen(0xff),
+	colorBlue(0xff),
+	colorAlpha(0xff),
+	outlined(false),
+	outlineWidth(1.0f),
+	outlineRed(0xff),
+	outlineGreen(0xff),
+	outlineBlue(0xff),
+	outlineAlpha(0xff)
+{}
+
+
+static SDL_Vertex make_vertex(Vector2f position, Uint8 r, Uint8 g, Uint8 b, Uint8 a){
+	SDL_Vertex vertex;
+	vertex.position.x = position.x;
+	vertex.position.y = position.y;
+	vertex.color.r = r;
+	vertex.color.g = g;
+	vertex.color.b = b;
+	vertex.color.a = a;
+	vertex.tex_coord.x = 0;
+	vertex.tex_coord.y = 0;
+	return vertex;
+}
+
+
+void ComponentRect2D::collectRenderables(std::list<Renderable*> &render_list, Viewport2D &v){
+	if(isHidden()) return;
+	if(width <= 0 || height <= 0) return;
+	if(!filled && !outlined) return;
+	
+	Layer2D *layer = getLayer();
+	if(layer == NULL) return;
+	Window *window = layer->getWindow();
+	if(window == NULL) return;
+	
+	
+	// Edges of the rectangle, in viewport coordinates
+	Vector2f across(width * scaleAbsolute.x, 0);
+	Vector2f down(0, -height * scaleAbsolute.y);
+	if(!fixedSize){
+		across.scale(v.getInverseRadiusY());
+		down.scale(v.getInverseRadiusY());
+	}
+	across.rotate(rotationAbsolute);
+	down.rotate(rotationAbsolute);
+	
+	Vector2f outer[4];
+	outer[0] = v.worldToViewport(positionAbsolute);
+	outer[1] = outer[0] + across;
+	outer[2] = outer[1] + down;
+	outer[3] = outer[0] + down;
+	
+	
+	// The outline takes up to half of the rectangle from each side
+	Vector2f inner[4];
+	float inset = 0;
+	if(outlined && outlineWidth > 0){
+		inset = outlineWidth * 2.0f / window->getScreenHeight();
+		float limit = 0.5f * std::min(across.norm(), down.norm());
+		if(inset > limit) inset = limit;
+	}
+	Vector2f acrossInset = across * (inset / across.norm());
+	Vector2f downInset = down * (inset / down.norm());
+	inner[0] = outer[0] + acrossInset + downInset;
+	inner[1] = outer[1] - acrossInset + downInset;
+	inner[2] = outer[2] - acrossInset - downInset;
+	inner[3] = outer[3] + acrossInset - downInset;
+	
+	
+	std::vector<SDL_Vertex> vertices;
+	std::vector<int> indices;
+	
+	if(filled){
+		for(int i = 0; i < 4; i++){
+			vertices.push_back(make_vertex(inner[i], colorRed, colorGreen, colorBlue, colorAlpha));
+		}
+		int quad[6] = {0, 1, 2, 0, 2, 3};
+		indices.insert(indices.end(), quad, quad + 6);
+	}
+	
+	if(inset > 0){
+		int base = vertices.size();
+		for(int i = 0; i < 4; i++){
+			vertices.push_back(make_vertex(outer[i], outlineRed, outlineGreen, outlineBlue, outlineAlpha));
+		}
+		for(int i = 0; i < 4; i++){
+			vertices.push_back(make_vertex(inner[i], outlineRed, outlineGreen, outlineBlue, outlineAlpha));
+		}
+		
+		// One quad for each side, between the outer and inner corners
+		for(int i = 0; i < 4; i++){
+			int next = (i + 1) % 4;
+			int quad[6] = {i, next, 4 + next, i, 4 + next, 4 + i};
+			for(int j = 0; j < 6; j++) indices.push_back(base + quad[j]);
+		}
+	}
+	
+	RenderableGeometry *geometry = RenderableGeometry::createRenderableGeometry(
+		zLevelAbsolute,
+		vertices,
+		indices,
+		v.getViewportRect()
+	);
+	if(geometry != NULL){
+		geometry->colorMod = colorModAbsolute;
+		render_list.push_back(geometry);
+	}
+}
+
+
+
+
 /*
  * ComponentSpriteSimple2D
  */
@@ -273,7 +451,7 @@ ComponentSpriteSimple2D::ComponentSpriteSimple2D():
 	width(0.1),
 	height(0.1),
 	centerOffset(0, 0),
-	texture(NULL)
+	texture(NULL, this)
 {}
 
 
@@ -282,16 +460,12 @@ ComponentSpriteSimple2D::ComponentSpriteSimple2D(Texture *tex):
 	width(0.1),
 	height(0.1),
 	centerOffset(0, 0),
-	texture(NULL)
-{
-	setTexture(tex);
-}
+	texture(tex, this)
+{}
 
 
 ComponentSpriteSimple2D::~ComponentSpriteSimple2D(){
-	if(texture != NULL){
-		texture->removeOwner(this);
-	}
+	// The texture handle releases itself
 }
 
 
@@ -310,7 +484,7 @@ void ComponentSpriteSimple2D::collectRenderables(
 ){
 	if(isHidden()) return;
 	
-	RenderableSprite *sprite = makeRenderableFromTexture(texture, viewport);
+	RenderableSprite *sprite = makeRenderableFromTexture(texture.get(), viewport);
 	
 	if(sprite != NULL){
 		sprite->zMod = zmod;
@@ -323,38 +497,91 @@ RenderableSprite *ComponentSpriteSimple2D::makeRenderableFromTexture(
 	Texture *tex,
 	Viewport2D &viewport
 ){
+	if(tex == NULL) return NULL;
 	
-	/*
-	 * This method is a complicated mess.  Three different nearly unrelated
-	 * cases are treated with the same code, hence the unreadability.
-	 * TODO: Reorganize this and add liberal comment descriptions of what is being
-	 * done and for what cases.
-	 */
+	Vector2f corner;
+	float w, h;
+	if(!placeRectangle(tex->width, tex->height, viewport, corner, w, h)) return NULL;
 	
-	if(tex == NULL) return NULL;
+	
+	// Only look ahead for textures if the window manages texture residency
+	Window *window = getLayer()->getWindow();
+	Rect2f prefetchRect;
+	bool prefetch = window->textureResidency.getBudget() != 0;
+	if(prefetch) prefetchRect = viewport.getPrefetchRect();
+	
+	
+	// Finally make the renderable
+	RenderableSprite *sprite;
+	sprite = RenderableSprite::createRenderableSprite(
+		corner.x,
+		corner.y,
+		w,
+		h,
+		zLevel,
+		rotationAbsolute,
+		tex,
+		viewport.getViewportRect(),
+		prefetch ? &prefetchRect : NULL
+	);
+	if(sprite != NULL) sprite->colorMod = colorModAbsolute;
+	
+	
+	return sprite;
+	
+}
+
+
+bool ComponentSpriteSimple2D::placeRectangle(
+	float contentWidth,
+	float contentHeight,
+	Viewport2D &viewport,
+	Vector2f &corner,
+	float &w,
+	float &h
+){
+	/**
+	 * Computes where the sprite's rectangle is drawn, for contents (e.g. a
+	 * texture) of the provided size in pixels.
+	 * 
+	 * There are three cases:
+	 * 1) Neither width nor height is set (both negative): the contents are drawn
+	 *    pixel for pixel, at their own size.
+	 * 2) One of them is set: the other follows from the contents' aspect ratio.
+	 * 3) Both are set: the contents are stretched to fill the rectangle.
+	 * The rectangle is in world coordinates, or in viewport coordinates if the
+	 * sprite has fixedSize.
+	 * 
+	 * @param corner receives the upper-left corner, in viewport coordinates
+	 * @param w receives the width, in viewport coordinates
+	 * @param h receives the height, in viewport coordinates
+	 * @return false if the sprite is not in a layer of a window.
+	 */
 	
 	Layer2D *layer = getLayer();
-	if(layer == NULL) return NULL;
+	if(layer == NULL) return false;
 	Window *window = layer->getWindow();
-	if(window == NULL) return NULL;
+	if(window == NULL) return false;
 	
 	
 	bool fixedPixel = false;
-	float w = width, h = height;
+	float aspectRatio = contentWidth / contentHeight;
+	w = width;
+	h = height;
 	if(width < 0){
 		if(height < 0){
-			w = tex->width;
-			h = tex->height;
+			w = contentWidth;
+			h = contentHeight;
 			fixedPixel = true;
 		}else{
-			w = h * tex->getAspectRatio();
+			w = h * aspectRatio;
 		}
 	}else if(height < 0){
-		h = w / tex->getAspectRatio();
+		h = w / aspectRatio;
 	}
 	
 	
-	
+	// The center offset is in pixels for pixel-sized sprites
 	Vector2f offset(-centerOffset.x, centerOffset.y);
 	if(fixedPixel){
 		offset.scale(2.0f / window->getScreenHeight());
@@ -369,16 +596,16 @@ RenderableSprite *ComponentSpriteSimple2D::makeRenderableFromTexture(
 	float scaleFactorX = scaleAbsolute.x;
 	float scaleFactorY = scaleAbsolute.y;
 	
-	Vector2f vc;
 	if(!fixedSize){
-		vc = viewport.worldToViewport(positionAbsolute + offset);
+		// World-sized sprites move and zoom with the viewport
+		corner = viewport.worldToViewport(positionAbsolute + offset);
 		if(!fixedPixel){
 			scaleFactorX *= viewport.getInverseRadiusY();
 			scaleFactorY *= viewport.getInverseRadiusY();	
 		}
 	}else{
 		// Fixed Size Sprites
-		vc = viewport.worldToViewport(positionAbsolute) + offset;
+		corner = viewport.worldToViewport(positionAbsolute) + offset;
 	}
 	
 	
@@ -388,38 +615,22 @@ RenderableSprite *ComponentSpriteSimple2D::makeRenderableFromTexture(
 		scaleFactorY /= pixelFactor;
 	}
 	
-	
-	// Finally make the renderable
-	RenderableSprite *sprite;
-	sprite = RenderableSprite::createRenderableSprite(
-		vc.x,
-		vc.y,
-		scaleFactorX * w,
-		scaleFactorY * h,
-		zLevel,
-		rotationAbsolute,
-		tex,
-		viewport.getViewportRect()
-	);
-	
-	
-	return sprite;
-	
+	w *= scaleFactorX;
+	h *= scaleFactorY;
+	return true;
 }
 
 
 
-Texture *ComponentSpriteSimple2D::getTexture() const {return texture;}
+Texture *ComponentSpriteSimple2D::getTexture() const {return texture.get();}
 
 void ComponentSpriteSimple2D::setTexture(Texture *tex){
-	if(texture != NULL) texture->removeOwner(this);
-	if(tex != NULL) tex->addOwner(this);
-	texture = tex;
+	texture.reset(tex);
 }
 
 // Internal Use Only!  Called when a texture is manually deleted on its owners
 void ComponentSpriteSimple2D::removeTextureReference(Texture *tex){
-	if(texture == tex) texture = NULL;
+	// The handle has already been nulled out by the texture
 }
 
 
@@ -465,6 +676,21 @@ void Node2D::processEvent(InputEvent *event, Layer2D *layer, float tpf){
 
 
 
+void Node2D::lateLatch(Vector2f delta, bool shift){
+	Component2D::lateLatch(delta, shift);
+	
+	// Children of shifted nodes move with them
+	shift = shift || isCursorBound();
+	
+	std::list<Component2D*>::iterator iter;
+	for(iter = children.begin(); iter != children.end(); iter++){
+		Component2D *child = *iter;
+		child->lateLatch(delta, shift);
+	}
+}
+
+
+
 void Node2D::updateChildren(Layer2D *layer, float tpf){
 	// Update all children
 	std::list<Component2D*> iterlist = children;
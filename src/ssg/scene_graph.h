@@ -48,6 +48,21 @@ namespace ssg {
 		bool inheritScale;
 		bool inheritHidden;
 		
+		/*
+		 * Tint and opacity, multiplied into the colors of everything the
+		 * component draws, without changing its textures.  Children also take
+		 * those of their parent, unless inheritColorMod is unset.
+		 */
+		Uint8 colorModRed, colorModGreen, colorModBlue, alphaMod;
+		bool inheritColorMod;
+		
+		/*
+		 * Cursor-bound components (e.g. sprites which follow the mouse) have their
+		 * world positions patched with the latest cursor motion just before
+		 * rendering, without re-running onUpdate().
+		 */
+		bool cursorBound;
+		
 		Component2D();
 		virtual ~Component2D(); // Detaches itself from the parent first
 		
@@ -58,6 +73,8 @@ namespace ssg {
 		virtual void update(Layer2D *layer, float tpf);
 		virtual void collectRenderables(std::list<Renderable*> &render_list, Viewport2D &v) = 0;
 		virtual void processEvent(InputEvent *event, Layer2D *layer, float tpf);
+		virtual void lateLatch(Vector2f delta, bool shift);
+		virtual bool isCursorBound(){ return cursorBound; };
 	
 	
 	public:
@@ -91,6 +108,7 @@ namespace ssg {
 		float zLevelAbsolute;
 		float rotationAbsolute;
 		Vector2f scaleAbsolute;
+		SDL_Color colorModAbsolute;
 		
 		bool locked;
 		
@@ -144,6 +162,34 @@ namespace ssg {
 
 
 
+	class SHARED_EXPORT ComponentRect2D : public Component2D {
+		/**
+		 * 2D components which are rendered as a flat rectangle, filled and/or
+		 * outlined.  No texture is needed: rectangles are drawn as untextured
+		 * triangles, batched with other such geometry.  Like sprites, they are
+		 * rotated about their upper-left corner.
+		 */
+	public:
+		bool fixedSize;
+		float width, height;  // Either world or viewport, depending on fixedSize
+		
+		bool filled;
+		Uint8 colorRed, colorGreen, colorBlue, colorAlpha;
+		
+		// The outline is drawn inside of the rectangle
+		bool outlined;
+		float outlineWidth; // Pixels
+		Uint8 outlineRed, outlineGreen, outlineBlue, outlineAlpha;
+	
+		ComponentRect2D();
+		ComponentRect2D(float w, float h);
+		
+	internal:
+		virtual void collectRenderables(std::list<Renderable*> &render_list, Viewport2D &v);
+	};
+
+
+
 	class SHARED_EXPORT ComponentSpriteSimple2D:
 		public Component2D,
 		public TextureOwner
@@ -172,9 +218,17 @@ namespace ssg {
 		virtual void removeTextureReference(Texture *tex);
 		
 		RenderableSprite *makeRenderableFromTexture(Texture *tex, Viewport2D &viewport);
+		bool placeRectangle(
+			float contentWidth,
+			float contentHeight,
+			Viewport2D &viewport,
+			Vector2f &corner,
+			float &w,
+			float &h
+		);
 		
 	private:
-		Texture *texture;
+		TextureRef texture;
 		// For internal use
 		ComponentPoint2D corner;
 	};
@@ -207,6 +261,7 @@ namespace ssg {
 		virtual void update(Layer2D *layer, float tpf);
 		virtual void collectRenderables(std::list<Renderable*> &render_list, Viewport2D &v);
 		virtual void processEvent(InputEvent *event, Layer2D *layer, float tpf);
+		virtual void lateLatch(Vector2f delta, bool shift);
 	
 	protected:
 		void updateChildren(Layer2D *layer, float tpf);
@@ -6,6 +6,8 @@
 #include "sdl.h"
 #include "vectormath.h"
 #include "geometry.h"
+#include "font_cache.h"
+#include "text_layout.h"
 
 using namespace ssg;
 
@@ -39,6 +41,10 @@ static int init(){
 
 
 static void quit(){
+	// Fonts must be closed while SDL_ttf is still running
+	TextMetrics::clear();
+	FontCache::clear();
+	
 	SDL_Quit();
 	IMG_Quit();
 	TTF_Quit();
@@ -46,6 +52,21 @@ static void quit(){
 
 
 
+int ssg::use_headless_video(const char *driver){
+	/**
+	 * Selects an SDL video driver which needs no display (e.g. "dummy" or
+	 * "offscreen"), for headless runs such as input trace replays.  This must be
+	 * called before the first window is created.  Windows created this way
+	 * should not use hardware acceleration.
+	 */
+	if(SDL_ACTIVE){
+		printf("[Error] Cannot change video driver; SDL is already initialized.\n");
+		return -1;
+	}
+	return SDL_setenv("SDL_VIDEODRIVER", driver, 1);
+}
+
+
 int ssg::create_SDL_window(SDL_Window **win, const char *window_name, int sx, int sy){
 	/**
 	 * Attempts to create a new SDL window and place a pointer to it in the
@@ -106,6 +127,111 @@ SDL_Renderer *ssg::create_SDL_renderer(SDL_Window *window, int hardware_accelera
 }
 
 
+Uint32 ssg::choose_texture_format(SDL_Renderer *renderer){
+	/**
+	 * Picks the pixel format for textures made by the provided renderer: the
+	 * first (i.e. most preferred) 32-bit format with alpha which the renderer
+	 * supports natively, so that uploads need no conversion by SDL.
+	 */
+	SDL_RendererInfo info;
+	if(renderer != NULL && SDL_GetRendererInfo(renderer, &info) == 0){
+		for(Uint32 i = 0; i < info.num_texture_formats; i++){
+			Uint32 format = info.texture_formats[i];
+			if(SDL_BITSPERPIXEL(format) == 32 && SDL_ISPIXELFORMAT_ALPHA(format)){
+				return format;
+			}
+		}
+	}
+	return SDL_PIXELFORMAT_RGBA32;
+}
+
+
+SDL_Texture *ssg::create_texture_from_surface(
+	SDL_Renderer *renderer,
+	SDL_Surface *surface,
+	Uint32 format
+){
+	/**
+	 * Creates a texture of the provided format from a surface, writing the
+	 * pixels straight into the texture's memory.  If the surface already has
+	 * that format, this is a single copy; otherwise the pixels are converted on
+	 * the way, without an intermediate surface.
+	 */
+	if(renderer == NULL || surface == NULL) return NULL;
+	
+	SDL_Texture *texture = SDL_CreateTexture(
+		renderer,
+		format,
+		SDL_TEXTUREACCESS_STREAMING,
+		surface->w,
+		surface->h
+	);
+	if(texture == NULL) return NULL;
+	
+	if(copy_surface_to_texture(texture, surface) < 0){
+		SDL_DestroyTexture(texture);
+		return NULL;
+	}
+	return texture;
+}
+
+
+int ssg::copy_surface_to_texture(SDL_Texture *texture, SDL_Surface *surface){
+	/**
+	 * Writes a surface into the upper-left corner of a streaming texture, which
+	 * must be at least as large.  The pixels are copied straight into the
+	 * texture's memory, and converted on the way if the formats differ.
+	 *
+	 * @return 0 on success, or a negative number on failure.
+	 */
+	if(texture == NULL || surface == NULL) return -1;
+	
+	Uint32 format;
+	SDL_QueryTexture(texture, &format, NULL, NULL, NULL);
+	
+	SDL_Rect rect;
+	rect.x = 0;
+	rect.y = 0;
+	rect.w = surface->w;
+	rect.h = surface->h;
+	
+	void *pixels;
+	int pitch;
+	if(SDL_LockTexture(texture, &rect, &pixels, &pitch) < 0) return -1;
+	
+	if(SDL_MUSTLOCK(surface)) SDL_LockSurface(surface);
+	int result = 0;
+	if(surface->format->format == format){
+		int rowBytes = surface->w * surface->format->BytesPerPixel;
+		for(int y = 0; y < surface->h; y++){
+			SDL_memcpy(
+				(Uint8*) pixels + y * pitch,
+				(const Uint8*) surface->pixels + y * surface->pitch,
+				rowBytes
+			);
+		}
+	}else{
+		result = SDL_ConvertPixels(
+			surface->w, surface->h,
+			surface->format->format, surface->pixels, surface->pitch,
+			format, pixels, pitch
+		);
+	}
+	if(SDL_MUSTLOCK(surface)) SDL_UnlockSurface(surface);
+	SDL_UnlockTexture(texture);
+	
+	if(result < 0){
+		// e.g. palettized images, which SDL_ConvertPixels cannot read
+		SDL_Surface *converted = SDL_ConvertSurfaceFormat(surface, format, 0);
+		if(converted == NULL) return -1;
+		result = copy_surface_to_texture(texture, converted);
+		SDL_FreeSurface(converted);
+	}
+	
+	return result;
+}
+
+
 
 /*
  * SDL Wrapper methods
@@ -21,10 +21,19 @@
 
 namespace ssg {
 
+	int use_headless_video(const char *driver = "dummy");
+
 	int create_SDL_window(SDL_Window **win, const char *window_name, int sx, int sy);
 	void remove_SDL_window(SDL_Window *window);
 
 	SDL_Renderer *create_SDL_renderer(SDL_Window *window, int hardware_accelerated);
+	Uint32 choose_texture_format(SDL_Renderer *renderer);
+	SDL_Texture *create_texture_from_surface(
+		SDL_Renderer *renderer,
+		SDL_Surface *surface,
+		Uint32 format
+	);
+	int copy_surface_to_texture(SDL_Texture *texture, SDL_Surface *surface);
 
 	int render_copy_clip(
 		SDL_Renderer * renderer,
@@ -17,15 +17,31 @@ namespace ssg {};
 
 #include "window.h"
 #include "layer.h"
+#include "label_placer.h"
 #include "viewport.h"
 #include "texture.h"
+#include "alpha_mask.h"
+#include "texture_atlas.h"
+#include "texture_loader.h"
+#include "texture_registry.h"
+#include "texture_residency.h"
+#include "texture_pool.h"
+#include "texture_stats.h"
+#include "font_cache.h"
+#include "glyph_cache.h"
+#include "text_layout.h"
 
 #include "scene_graph.h"
+#include "polyline.h"
+#include "point_cloud.h"
 #include "text.h"
+#include "text_view.h"
 #include "button.h"
 
 #include "callback.h"
 #include "input.h"
+#include "latency.h"
+#include "input_record.h"
 
 
 // Hopefully this can be engineered out later
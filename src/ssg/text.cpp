@@ -1,4 +1,3 @@
-#include <cstdlib>
 #include <string>
 #include <list>
 
@@ -9,10 +8,24 @@
 #include "viewport.h"
 #include "texture.h"
 #include "scene_graph.h"
+#include "font_cache.h"
+#include "glyph_cache.h"
+#include "text_layout.h"
+#include "layer.h"
 
 using namespace ssg;
 
 
+/*
+ * Font sizes at which text is rasterized for level of detail, each about 1.4
+ * times the last.  A size is kept until the text on screen is more than 10%
+ * larger than it, or more than 10% smaller than the size below it.
+ */
+static const int LOD_SIZES[] = {6, 8, 11, 16, 23, 32, 45, 64, 91, 128};
+static const int LOD_SIZE_COUNT = sizeof(LOD_SIZES) / sizeof(LOD_SIZES[0]);
+static const float LOD_HYSTERESIS = 0.1f;
+
+
 
 /*
  * TextObject
@@ -42,10 +55,23 @@ TextObject::TextObject():
  */
 
 ComponentSpriteText2D::ComponentSpriteText2D(Window *win):
-	window(win)
+	useGlyphCache(true),
+	levelOfDetail(true),
+	minimumPixelHeight(4.0f),
+	drawPlaceholder(true),
+	declutter(false),
+	labelPriority(0),
+	window(win),
+	glyphMode(false),
+	rasterSize(12),
+	lodSize(0),
+	forcedSize(0)
 {}
 
 
+int ComponentSpriteText2D::getRasterSize() const {return rasterSize;}
+
+
 void ComponentSpriteText2D::collectRenderables(
 	std::list<Renderable*> &render_list,
 	Viewport2D &viewport
@@ -59,25 +85,42 @@ void ComponentSpriteText2D::collectRenderables(
 	Viewport2D &viewport,
 	float zmod
 ){
+	// Hidden text is not rasterized until it is shown
+	if(isHidden()) return;
+	
+	// Pick the size to rasterize at from the height of the text on screen
+	int size = forcedSize > 0 ? forcedSize : selectRasterSize(viewport);
+	if(size == 0){
+		if(drawPlaceholder) collectPlaceholder(render_list, viewport, zmod);
+		return;
+	}
+	
+	// Nor is text which would be culled anyway; it stays stale until in view
+	bool stale = isStale(size);
+	if(stale && isEstimatedOffscreen(size, viewport)) return;
+	
+	if(useGlyphCache && window != NULL){
+		collectGlyphRun(render_list, viewport, zmod, size, stale);
+		return;
+	}
+	
 	// Check to see if we need to replace the texture
-	if(
-		text.compare(oldText) != 0 ||
-		fontPath.compare(oldFontPath) != 0 ||
-		fontSize != oldFontSize ||
-		colorRed != oldColor.r ||
-		colorGreen != oldColor.g ||
-		colorBlue != oldColor.b ||
-		colorAlpha != oldColor.a
-	){
+	if(stale){
+		glyphMode = false;
+		
+		// Let go of the old texture first, so that its SDL texture can be reused
+		setTexture(NULL);
+		
+		// Rendered in white, and tinted when drawn
 		Texture *newTexture = Texture::createFromText(
 			text,
 			fontPath,
-			fontSize,
+			size,
 			window,
-			colorRed,
-			colorGreen,
-			colorBlue,
-			colorAlpha
+			0xff,
+			0xff,
+			0xff,
+			0xff
 		);
 		setTexture(newTexture);
 		
@@ -86,24 +129,11 @@ void ComponentSpriteText2D::collectRenderables(
 			width = height * ratio;
 		}
 		
-		// Update Archived Values
-		oldText = text;
-		oldFontPath = fontPath;
-		oldFontSize = fontSize;
-		oldColor.r = colorRed;
-		oldColor.g = colorGreen;
-		oldColor.b = colorBlue;
-		oldColor.a = colorAlpha;
+		rasterSize = size;
+		updateArchivedValues();
 	}
 	
 	
-	/*
-	 * Instead of calling the sprite super method, we handle things directly here,
-	 * though a bit differently.
-	 */
-	
-	if(isHidden()) return;
-	
 	RenderableSprite *sprite = NULL;
 	
 	
@@ -114,54 +144,15 @@ void ComponentSpriteText2D::collectRenderables(
 	 * Special Handling for selected Rectangles
 	 */
 	if(width > 0 && height > 0){
-		Layer2D *layer = getLayer();
-		if(layer == NULL) return;
-		Window *win = layer->getWindow();
-		if(win == NULL) return;
-		
-		
-		float targetRatio = width / height;
-		float sourceRatio = texture->getAspectRatio();
-		
-		
-		float pixelRatio;
-		Vector2f offset;
-		if(sourceRatio > targetRatio){
-			pixelRatio = width / texture->width;
-			offset.set(0, -0.5f * (height - texture->height * pixelRatio));
-		}else{
-			pixelRatio = height / texture->height;
-			offset.set(0.5f * (width - texture->width * pixelRatio), 0);
-		}
-		
-		offset.add(-centerOffset.x, centerOffset.y);
-		offset.rotate(rotationAbsolute);
-		
-		
-		Vector2f vc;
-		float scaleFactorX = scaleAbsolute.x;
-		float scaleFactorY = scaleAbsolute.y;
-		
-		if(fixedSize){
-			vc = viewport.worldToViewport(positionAbsolute) + offset;
-		}else{
-			vc = viewport.worldToViewport(positionAbsolute + offset);
-			scaleFactorX *= viewport.getInverseRadiusY();
-			scaleFactorY *= viewport.getInverseRadiusY();
-		}
-		
-		
-		// Compute base width and height of text rectangle in viewport coordinates.
-		float w = pixelRatio * texture->width;
-		float h = pixelRatio * texture->height;
-		
+		Vector2f corner;
+		float w, h;
+		if(!placeText(width, texture->width, texture->height, viewport, corner, w, h)) return;
 		
-		// Finally, make the renderable
 		sprite = RenderableSprite::createRenderableSprite(
-			vc.x,
-			vc.y,
-			scaleFactorX * w,
-			scaleFactorY * h,
+			corner.x,
+			corner.y,
+			w,
+			h,
 			zLevel,
 			rotationAbsolute,
 			texture,
@@ -175,9 +166,353 @@ void ComponentSpriteText2D::collectRenderables(
 	
 	if(sprite != NULL){
 		sprite->zMod = zmod;
-		render_list.push_back(sprite);
+		sprite->colorMod = getTextColor();
+		emitRenderable(
+			render_list,
+			sprite,
+			sprite->xPosition,
+			sprite->yPosition,
+			sprite->width,
+			sprite->height
+		);
+	}
+	
+}
+
+
+void ComponentSpriteText2D::collectGlyphRun(
+	std::list<Renderable*> &render_list,
+	Viewport2D &viewport,
+	float zmod,
+	int size,
+	bool stale
+){
+	/*
+	 * Draws the text from the window's glyph cache.  A change of text only
+	 * needs a new layout; changes of color none at all.  The cache keeps the
+	 * glyphs of every size, so changing the level of detail back and forth
+	 * rasterizes nothing new.
+	 */
+	GlyphCache &cache = window->glyphCache;
+	if(stale){
+		glyphMode = true;
+		setTexture(NULL); // Left over from texture rendering
+		
+		cache.layout(text, fontPath, size, glyphRun);
+		if(glyphRun.getHeight() > 0){
+			float ratio = (float) glyphRun.getWidth() / (float) glyphRun.getHeight();
+			width = height * ratio;
+		}
+		
+		rasterSize = size;
+		updateArchivedValues();
+	}
+	
+	if(glyphRun.getWidth() < 1 || glyphRun.getHeight() < 1) return;
+	
+	Vector2f corner;
+	float w, h;
+	if(!placeText(width, glyphRun.getWidth(), glyphRun.getHeight(), viewport, corner, w, h)) return;
+	
+	RenderableGlyphRun *renderable = RenderableGlyphRun::createRenderableGlyphRun(
+		corner.x,
+		corner.y,
+		w,
+		h,
+		zLevel,
+		rotationAbsolute,
+		&glyphRun,
+		colorRed,
+		colorGreen,
+		colorBlue,
+		colorAlpha,
+		viewport.getViewportRect()
+	);
+	
+	if(renderable != NULL){
+		renderable->zMod = zmod;
+		renderable->colorMod = colorModAbsolute;
+		emitRenderable(render_list, renderable, corner.x, corner.y, w, h);
+	}
+}
+
+
+void ComponentSpriteText2D::emitRenderable(
+	std::list<Renderable*> &render_list,
+	Renderable *renderable,
+	float x,
+	float y,
+	float w,
+	float h
+){
+	/*
+	 * Adds the renderable of the text, drawn from (x, y) down and to the right,
+	 * to the render list; or for labels, hands it to the layer's label placer
+	 * with the bounds of the rotated rectangle.
+	 */
+	Layer2D *layer = declutter ? getLayer() : NULL;
+	if(layer == NULL){
+		render_list.push_back(renderable);
+		return;
 	}
 	
+	Vector2f across(w, 0);
+	across.rotate(rotationAbsolute);
+	Vector2f down(0, -h);
+	down.rotate(rotationAbsolute);
+	
+	Vector2f corner(x, y);
+	Vector2f points[4] = {corner, corner + across, corner + down, corner + across + down};
+	Rect2f bounds = Rect2f::boundPoints(points, 4);
+	
+	layer->labelPlacer.considerLabel(this, renderable, bounds, labelPriority);
+}
+
+
+bool ComponentSpriteText2D::isStale(int size){
+	/*
+	 * Whether the text must be rasterized (or laid out) again before it is
+	 * drawn at the provided size.  Text is rasterized in white, and tinted
+	 * when drawn, so its color does not matter.
+	 */
+	bool glyphs = useGlyphCache && window != NULL;
+	if(glyphs){
+		if(!glyphMode || !glyphRun.isValid(window->glyphCache)) return true;
+	}else if(glyphMode){
+		return true;
+	}
+	
+	return
+		size != rasterSize ||
+		text.compare(oldText) != 0 ||
+		fontPath.compare(oldFontPath) != 0 ||
+		fontSize != oldFontSize;
+}
+
+
+bool ComponentSpriteText2D::isEstimatedOffscreen(int size, Viewport2D &viewport){
+	/*
+	 * Whether stale text would be culled once rasterized.  Its size is
+	 * estimated from the font's cached metrics, so nothing is rendered to find
+	 * out.  A box fit to the text is placed as rasterization would resize it,
+	 * but is left as it is until then.
+	 */
+	const TextMetrics *metrics = TextMetrics::getMetrics(fontPath, size);
+	if(metrics == NULL) return false;
+	int textWidth = metrics->measure(text);
+	int textHeight = metrics->getHeight();
+	if(textWidth < 1 || textHeight < 1) return false;
+	
+	float boxWidth = width;
+	if(height > 0) boxWidth = height * textWidth / textHeight;
+	
+	Vector2f corner;
+	float w, h;
+	if(!placeText(boxWidth, textWidth, textHeight, viewport, corner, w, h)) return false;
+	return should_cull_sprite(corner.x, corner.y, w, h, rotationAbsolute, viewport.getViewportRect());
+}
+
+
+void ComponentSpriteText2D::collectPlaceholder(
+	std::list<Renderable*> &render_list,
+	Viewport2D &viewport,
+	float zmod
+){
+	/*
+	 * Draws text too small to read as a line through the middle of where it
+	 * would be, measured with the font's cached metrics.  Labels are placed
+	 * with the bounds of the whole text, as if drawn in full.
+	 */
+	const TextMetrics *metrics = TextMetrics::getMetrics(fontPath, fontSize);
+	if(metrics == NULL) return;
+	int textWidth = metrics->measure(text);
+	if(textWidth < 1 || metrics->getHeight() < 1) return;
+	
+	Vector2f corner;
+	float w, h;
+	if(!placeText(width, textWidth, metrics->getHeight(), viewport, corner, w, h)) return;
+	
+	Vector2f down(0, -0.5f * h);
+	down.rotate(rotationAbsolute);
+	Vector2f along(w, 0);
+	along.rotate(rotationAbsolute);
+	Vector2f start = corner + down;
+	Vector2f end = start + along;
+	
+	RenderableLine *line = RenderableLine::createRenderableLine(
+		start.x,
+		start.y,
+		end.x,
+		end.y,
+		zLevel,
+		1,
+		colorRed,
+		colorGreen,
+		colorBlue,
+		colorAlpha,
+		viewport.getViewportRect()
+	);
+	
+	if(line != NULL){
+		line->zMod = zmod;
+		line->colorMod = colorModAbsolute;
+		emitRenderable(render_list, line, corner.x, corner.y, w, h);
+	}
+}
+
+
+int ComponentSpriteText2D::selectRasterSize(Viewport2D &viewport){
+	/*
+	 * The font size to rasterize the text at, following its height on screen
+	 * if level of detail is enabled; 0 if the text is too small to read.
+	 */
+	if(!levelOfDetail || height <= 0){
+		lodSize = 0;
+		return fontSize;
+	}
+	
+	float pixelHeight = getPixelHeight(viewport);
+	if(pixelHeight < 0) return fontSize;
+	if(pixelHeight < minimumPixelHeight) return 0;
+	return selectLodSize(pixelHeight);
+}
+
+
+float ComponentSpriteText2D::getPixelHeight(Viewport2D &viewport){
+	/*
+	 * Height of the text on screen, in pixels, or -1 if the sprite is not in a
+	 * layer of a window.
+	 */
+	Layer2D *layer = getLayer();
+	if(layer == NULL) return -1;
+	Window *win = layer->getWindow();
+	if(win == NULL) return -1;
+	
+	float h = height * scaleAbsolute.y;
+	if(h < 0) h = -h;
+	if(!fixedSize) h *= viewport.getInverseRadiusY();
+	return h * win->getScreenHeight() / 2;
+}
+
+
+int ComponentSpriteText2D::selectLodSize(float pixelHeight){
+	/*
+	 * The font size at which to rasterize text of the provided height on
+	 * screen.  Text at about its natural height keeps fontSize itself, so that
+	 * it looks just as it would without level of detail.  Otherwise, the
+	 * current size is kept while it is close enough, so that text at the
+	 * boundary between two sizes is not rasterized over and over.
+	 */
+	const TextMetrics *metrics = TextMetrics::getMetrics(fontPath, fontSize);
+	if(metrics == NULL || metrics->getHeight() < 1) return fontSize;
+	float wanted = fontSize * pixelHeight / metrics->getHeight();
+	
+	if(wanted >= fontSize * (1 - LOD_HYSTERESIS) && wanted <= fontSize * (1 + LOD_HYSTERESIS)){
+		lodSize = fontSize;
+		return lodSize;
+	}
+	
+	for(int i = 0; i < LOD_SIZE_COUNT && lodSize > 0; i++){
+		if(LOD_SIZES[i] != lodSize) continue;
+		
+		float lower = i > 0 ? LOD_SIZES[i - 1] : 0;
+		bool keep = wanted <= lodSize * (1 + LOD_HYSTERESIS);
+		keep = keep && wanted >= lower * (1 - LOD_HYSTERESIS);
+		if(keep) return lodSize;
+		break;
+	}
+	
+	// The smallest size at least as large as the text
+	lodSize = LOD_SIZES[LOD_SIZE_COUNT - 1];
+	for(int i = 0; i < LOD_SIZE_COUNT; i++){
+		if(LOD_SIZES[i] >= wanted){
+			lodSize = LOD_SIZES[i];
+			break;
+		}
+	}
+	return lodSize;
+}
+
+
+bool ComponentSpriteText2D::placeText(
+	float boxWidth,
+	float contentWidth,
+	float contentHeight,
+	Viewport2D &viewport,
+	Vector2f &corner,
+	float &w,
+	float &h
+){
+	/**
+	 * Like placeRectangle, except that when both width and height are set, the
+	 * text is fit inside of the rectangle rather than stretched to fill it.  The
+	 * provided box width stands in for the width of the component.
+	 */
+	if(!(boxWidth > 0 && height > 0)){
+		return placeRectangle(contentWidth, contentHeight, viewport, corner, w, h);
+	}
+	
+	Layer2D *layer = getLayer();
+	if(layer == NULL) return false;
+	Window *win = layer->getWindow();
+	if(win == NULL) return false;
+	
+	
+	float targetRatio = boxWidth / height;
+	float sourceRatio = contentWidth / contentHeight;
+	
+	
+	float pixelRatio;
+	Vector2f offset;
+	if(sourceRatio > targetRatio){
+		pixelRatio = boxWidth / contentWidth;
+		offset.set(0, -0.5f * (height - contentHeight * pixelRatio));
+	}else{
+		pixelRatio = height / contentHeight;
+		offset.set(0.5f * (boxWidth - contentWidth * pixelRatio), 0);
+	}
+	
+	offset.add(-centerOffset.x, centerOffset.y);
+	offset.rotate(rotationAbsolute);
+	
+	
+	float scaleFactorX = scaleAbsolute.x;
+	float scaleFactorY = scaleAbsolute.y;
+	
+	if(fixedSize){
+		corner = viewport.worldToViewport(positionAbsolute) + offset;
+	}else{
+		corner = viewport.worldToViewport(positionAbsolute + offset);
+		scaleFactorX *= viewport.getInverseRadiusY();
+		scaleFactorY *= viewport.getInverseRadiusY();
+	}
+	
+	
+	// Base width and height of text rectangle in viewport coordinates.
+	w = scaleFactorX * pixelRatio * contentWidth;
+	h = scaleFactorY * pixelRatio * contentHeight;
+	return true;
+}
+
+
+SDL_Color ComponentSpriteText2D::getTextColor() const {
+	SDL_Color color;
+	color.r = colorRed;
+	color.g = colorGreen;
+	color.b = colorBlue;
+	color.a = colorAlpha;
+	return modulate_color(color, colorModAbsolute);
+}
+
+
+void ComponentSpriteText2D::updateArchivedValues(){
+	oldText = text;
+	oldFontPath = fontPath;
+	oldFontSize = fontSize;
+	oldColor.r = colorRed;
+	oldColor.g = colorGreen;
+	oldColor.b = colorBlue;
+	oldColor.a = colorAlpha;
 }
 
 
@@ -192,7 +527,9 @@ ComponentTextBox2D::ComponentTextBox2D(Window *win):
 	oldLineCount(0),
 	oldSpacingRatio(1.0f),
 	oldWidth(-1.0f),
-	oldHeight(-1.0f)
+	oldHeight(-1.0f),
+	layoutSize(0),
+	oldLayoutSize(0)
 {
 	refreshTextures();
 }
@@ -234,35 +571,43 @@ void ComponentTextBox2D::collectRenderables(
 	if(width < 0 || height < 0) return;
 	
 	
+	/*
+	 * Lines are laid out at the size they are drawn at, as glyphs do not scale
+	 * exactly from one size to another; otherwise a line could be drawn wider
+	 * than the box.  The first line picks the size for all of them.
+	 */
+	ComponentSpriteText2D *first = lineList.empty() ? NULL : lineList.front();
+	int size = first != NULL ? first->selectRasterSize(viewport) : 0;
+	if(size > 0 && size != layoutSize){
+		layoutSize = size;
+		refreshTextures();
+	}
+	
 	// Collect renderables from line compoments
 	std::list<ComponentSpriteText2D*>::iterator iter;
 	for(iter = lineList.begin(); iter != lineList.end(); iter++){
 		ComponentSpriteText2D *line = *iter;
-		if(line != NULL) line->collectRenderables(render_list, viewport, zmod);
+		if(line == NULL) continue;
+		line->forcedSize = size;
+		line->collectRenderables(render_list, viewport, zmod);
 	}
 }
 
 
 
-static float size_text(std::string fontPath, int size, std::string text){
-	/**
-	 * This is a static helper method for estimating the ratio of the width of
-	 * a piece of rendered text to its height.  If the provided font is invalid
-	 * or rendering is otherwise not possible, this returns -1.  Note that no
-	 * actual rendering is done; just a call to TTF_SizeText();
-	 */
-	TTF_Font *font = TTF_OpenFont(fontPath.c_str(), size);
-	if(font == NULL) return -1;
-	
-	int w, h;
-	TTF_SizeText(font, text.c_str(), &w, &h);
+void ComponentTextBox2D::lateLatch(Vector2f delta, bool shift){
+	Component2D::lateLatch(delta, shift);
 	
-	TTF_CloseFont(font);
-	
-	return (float) w / (float) h;
+	shift = shift || isCursorBound();
+	std::list<ComponentSpriteText2D*>::iterator iter;
+	for(iter = lineList.begin(); iter != lineList.end(); iter++){
+		ComponentSpriteText2D *line = *iter;
+		if(line != NULL) line->lateLatch(delta, shift);
+	}
 }
 
 
+
 void ComponentTextBox2D::refreshTextures(){
 	/**
 	 * Checks to see if it is necessary to re-render the textures for the
@@ -293,8 +638,8 @@ void ComponentTextBox2D::refreshTextures(){
 		needsRefresh = true;
 	}
 	
+	// Changes of style or geometry apply to every line
 	if(
-		text.compare(oldText) != 0 ||
 		fontPath.compare(oldFontPath) != 0 ||
 		fontSize != oldFontSize ||
 		colorRed != oldColor.r ||
@@ -303,12 +648,12 @@ void ComponentTextBox2D::refreshTextures(){
 		colorAlpha != oldColor.a ||
 		width != oldWidth ||
 		height != oldHeight ||
-		spacingRatio != oldSpacingRatio
+		spacingRatio != oldSpacingRatio ||
+		layoutSize != oldLayoutSize
 	){
 		needsRefresh = true;
 		
 		// Update Archived Values
-		oldText = text;
 		oldFontPath = fontPath;
 		oldFontSize = fontSize;
 		oldColor.r = colorRed;
@@ -318,10 +663,15 @@ void ComponentTextBox2D::refreshTextures(){
 		oldWidth = width;
 		oldHeight = height;
 		oldSpacingRatio = spacingRatio;
+		oldLayoutSize = layoutSize;
 	}
 	
+	// Changes of text only to the lines they reflow
+	bool textChanged = text.compare(oldText) != 0;
+	oldText = text;
+	
 	
-	if(!needsRefresh) return;
+	if(!needsRefresh && !textChanged) return;
 	
 	/*
 	 * At this point, we know that a refresh is needed.
@@ -333,75 +683,52 @@ void ComponentTextBox2D::refreshTextures(){
 	// Make sure all line sprites have the proper settings
 	std::list<ComponentSpriteText2D*>::iterator iter;
 	int lineNumber = 0;
-	for(iter = lineList.begin(); iter != lineList.end(); iter++){
-		ComponentSpriteText2D *line = *iter;
-		if(line == NULL) continue;
-		
-		line->text.clear();
-		line->text = " ";
-		line->fontPath = fontPath;
-		line->fontSize = fontSize;
-		line->colorRed = colorRed;
-		line->colorGreen = colorGreen;
-		line->colorBlue = colorBlue;
-		line->colorAlpha = colorAlpha;
-		line->width = -1;
-		line->height = lineHeight;
-		line->position.set(0, -lineNumber * (1 + spacingRatio) * lineHeight);
-		
-		lineNumber++;
+	if(needsRefresh){
+		for(iter = lineList.begin(); iter != lineList.end(); iter++){
+			ComponentSpriteText2D *line = *iter;
+			if(line == NULL) continue;
+			
+			line->fontPath = fontPath;
+			line->fontSize = fontSize;
+			line->colorRed = colorRed;
+			line->colorGreen = colorGreen;
+			line->colorBlue = colorBlue;
+			line->colorAlpha = colorAlpha;
+			line->width = -1;
+			line->height = lineHeight;
+			line->position.set(0, -lineNumber * (1 + spacingRatio) * lineHeight);
+			
+			lineNumber++;
+		}
 	}
 	
 	
 	/*
-	 * Note:
-	 * Lest ye be tempted to merge the two loops, remember that the above actions
-	 * must be done for all lines, regardless of whether or not they are written
-	 * to.
+	 * Break the text into lines as wide as the box, in pixels of the font at
+	 * the size it is drawn at.  Lines before the first one the layout changed
+	 * keep their text.
 	 */
-	
-	
-	char *buffer = (char*) malloc((text.size() + 1) * sizeof(char));
-	strcpy(buffer, text.c_str());
-	
-	// First token
-	char *token = strtok(buffer, " ");
-	
-	std::string testString;
-	
-	for(iter = lineList.begin(); iter != lineList.end(); iter++){
+	int size = layoutSize > 0 ? layoutSize : fontSize;
+	const TextMetrics *metrics = TextMetrics::getMetrics(fontPath, size);
+	int maxWidth = 0;
+	if(metrics != NULL && lineHeight > 0 && width > 0){
+		maxWidth = width / lineHeight * metrics->getHeight();
+	}
+	layout.setFont(fontPath, size);
+	layout.setWidth(maxWidth);
+	layout.setText(text);
+	layout.update();
+	
+	int firstLine = needsRefresh ? 0 : layout.getFirstChangedLine();
+	lineNumber = 0;
+	for(iter = lineList.begin(); iter != lineList.end(); iter++, lineNumber++){
 		ComponentSpriteText2D *line = *iter;
-		if(line == NULL) continue;
-		
+		if(line == NULL || lineNumber < firstLine) continue;
 		
-		// First token
-		if(token == NULL) break;
-		
-		line->text.clear();
-		testString.clear();
-		
-		testString.append(" ");
-		testString.append(token);
-		
-		float testLength = 0;
-		while(testLength < width / lineHeight && testLength >= 0){
-			line->text.append(" ");
-			line->text.append(token);
-			
-			token = strtok(NULL, " ");
-			if(token == NULL) break;
-			
-			testString.append(" ");
-			testString.append(token);
-			
-			// estimate width ratio of test string
-			testLength = size_text(fontPath, fontSize, testString);
+		if(lineNumber < layout.getLineCount() && layout.getLine(lineNumber).length > 0){
+			line->text = layout.getLineText(lineNumber);
+		}else{
+			line->text = " ";
 		}
 	}
-	
-	free(buffer);
 }
-
-
-
-
@@ -9,6 +9,8 @@
 #include "sdl.h"
 
 #include "scene_graph.h"
+#include "glyph_cache.h"
+#include "text_layout.h"
 
 
 
@@ -48,7 +50,8 @@ namespace ssg {
 
 
 	/*
-	 * Class of single-line text sprites
+	 * Class of single-line text sprites.  Text is only rasterized when it is
+	 * drawn; hidden text, and text out of view, costs nothing to change.
 	 */
 
 	class SHARED_EXPORT ComponentSpriteText2D: 
@@ -57,15 +60,76 @@ namespace ssg {
 	{
 	friend class ComponentTextBox2D;
 	public:
+		/*
+		 * Whether the text is drawn from the window's glyph cache (see
+		 * glyph_cache.h), rather than rendered into a texture of its own.
+		 */
+		bool useGlyphCache;
+		
+		/*
+		 * Level of detail: text with a set height is rasterized at the font size
+		 * which matches its height on screen, taken from a fixed set of sizes,
+		 * rather than at fontSize.  Text less than minimumPixelHeight tall on
+		 * screen is not rasterized at all; if drawPlaceholder is set, it is drawn
+		 * as a line instead.
+		 */
+		bool levelOfDetail;
+		float minimumPixelHeight;
+		bool drawPlaceholder;
+		
+		/*
+		 * Labels are only drawn where they do not overlap labels of a higher
+		 * priority (see label_placer.h).
+		 */
+		bool declutter;
+		int labelPriority;
 	
 		ComponentSpriteText2D(Window *win);
 		
+		// Font size the text was last rasterized at
+		int getRasterSize() const;
+		
 	internal:
 		virtual void collectRenderables(std::list<Renderable*> &render_list, Viewport2D &v);
 		virtual void collectRenderables(std::list<Renderable*> &r, Viewport2D &v, float zm);
 	
 	protected:
 		Window *window;
+		
+		bool placeText(
+			float boxWidth,
+			float contentWidth,
+			float contentHeight,
+			Viewport2D &viewport,
+			Vector2f &corner,
+			float &w,
+			float &h
+		);
+	
+	private:
+		GlyphRun glyphRun;
+		bool glyphMode; // Whether the archived values describe glyphRun
+		int rasterSize;
+		int lodSize;    // Current level of detail; 0 if none
+		int forcedSize; // Set by text boxes for their lines; 0 if none
+		
+		void collectGlyphRun(std::list<Renderable*> &r, Viewport2D &v, float zm, int size, bool stale);
+		bool isStale(int size);
+		SDL_Color getTextColor() const; // Including the color modulation
+		bool isEstimatedOffscreen(int size, Viewport2D &viewport);
+		void emitRenderable(
+			std::list<Renderable*> &render_list,
+			Renderable *renderable,
+			float x,
+			float y,
+			float w,
+			float h
+		);
+		void collectPlaceholder(std::list<Renderable*> &r, Viewport2D &v, float zm);
+		int selectRasterSize(Viewport2D &viewport);
+		float getPixelHeight(Viewport2D &viewport);
+		int selectLodSize(float pixelHeight);
+		void updateArchivedValues();
 	};
 
 
@@ -111,6 +175,8 @@ namespace ssg {
 			Viewport2D &viewport,
 			float zmod
 		);
+		
+		virtual void lateLatch(Vector2f delta, bool shift);
 	
 	protected:
 		Window *window;
@@ -118,6 +184,9 @@ namespace ssg {
 	private:
 		int oldLineCount;
 		float oldSpacingRatio, oldWidth, oldHeight;
+		
+		// Font size the lines are drawn, and so laid out, at; 0 until drawn
+		int layoutSize, oldLayoutSize;
 		/*
 		 * List of text sprites to serve as the lines.  If lineCount changes, members
 		 * are added and removed to this list.  Note that these lines are also child
@@ -125,6 +194,9 @@ namespace ssg {
 		 * deleted.
 		 */
 		std::list<ComponentSpriteText2D*> lineList;
+		
+		// Breaks the text into the lines (see text_layout.h)
+		TextLayout layout;
 	
 		void refreshTextures();
 	};
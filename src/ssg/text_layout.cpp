@@ -0,0 +1,455 @@
+/*
+ * Source for text measurement and layout
+ */
+#include <string>
+#include <climits>
+#include <map>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <unordered_map>
+
+#include "sdl.h"
+#include "font_cache.h"
+#include "text_layout.h"
+
+using namespace ssg;
+
+
+std::map<std::pair<std::string, int>, TextMetrics*> TextMetrics::metrics;
+int TextMetrics::generation = 0;
+
+
+static bool is_space(char c){
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+
+
+/*
+ * TextMetrics
+ */
+
+const TextMetrics *TextMetrics::getMetrics(std::string font, int size){
+	/**
+	 * @return the metrics of the provided font, or NULL if it cannot be opened.
+	 *         Metrics are kept until their font file is evicted.
+	 */
+	std::pair<std::string, int> key(font, size);
+	auto cached = metrics.find(key);
+	if(cached != metrics.end()) return cached->second;
+
+	TTF_Font *ttf = FontCache::getFont(font, size);
+	if(ttf == NULL) return NULL;
+
+	TextMetrics *result = new TextMetrics(font, size, ttf);
+	metrics[key] = result;
+	return result;
+}
+
+
+void TextMetrics::evictFont(std::string font){
+	/**
+	 * Drops the metrics of all sizes of the provided font.
+	 */
+	auto cached = metrics.lower_bound(std::pair<std::string, int>(font, INT_MIN));
+	if(cached == metrics.end() || cached->first.first != font) return;
+
+	while(cached != metrics.end() && cached->first.first == font){
+		delete cached->second;
+		cached = metrics.erase(cached);
+	}
+	generation++;
+}
+
+
+void TextMetrics::clear(){
+	/**
+	 * Drops all metrics.
+	 */
+	for(auto &cached : metrics){
+		delete cached.second;
+	}
+	metrics.clear();
+	generation++;
+}
+
+
+int TextMetrics::getGeneration(){return generation;}
+
+
+int TextMetrics::measure(std::string text, std::string font, int size){
+	/**
+	 * @return the width of the provided text in pixels, or -1 if the font
+	 *         cannot be opened.
+	 */
+	const TextMetrics *fontMetrics = getMetrics(font, size);
+	if(fontMetrics == NULL) return -1;
+	return fontMetrics->measure(text);
+}
+
+
+TextMetrics::TextMetrics(std::string font, int size, TTF_Font *ttf):
+	fontPath(font),
+	fontSize(size),
+	height(TTF_FontHeight(ttf))
+{
+	/*
+	 * A glyph's cell reaches from the pen to its advance, or further if the
+	 * glyph does; this is how far the glyph cache draws it, and how far
+	 * TTF_SizeText counts it.
+	 */
+	for(int ch = 0; ch < 256; ch++){
+		int minX, maxX, advance;
+		if(TTF_GlyphMetrics(ttf, ch, &minX, &maxX, NULL, NULL, &advance) < 0){
+			advance = 0;
+			maxX = 0;
+		}
+		advances[ch] = advance;
+		rights[ch] = std::max(advance, maxX);
+	}
+}
+
+
+int TextMetrics::getHeight() const {return height;}
+
+int TextMetrics::getAdvance(unsigned char ch) const {return advances[ch];}
+
+int TextMetrics::getRight(unsigned char ch) const {return rights[ch];}
+
+
+int TextMetrics::getKerning(unsigned char previous, unsigned char ch) const {
+	Uint16 pair = (previous << 8) | ch;
+	auto cached = kerningPairs.find(pair);
+	if(cached != kerningPairs.end()) return cached->second;
+
+	TTF_Font *ttf = FontCache::getFont(fontPath, fontSize);
+	int kerning = ttf != NULL ? TTF_GetFontKerningSizeGlyphs(ttf, previous, ch) : 0;
+	kerningPairs[pair] = kerning;
+	return kerning;
+}
+
+
+int TextMetrics::measure(const std::string &text) const {
+	return measure(text.c_str(), text.size());
+}
+
+
+int TextMetrics::measure(const char *text, int length) const {
+	int pen = 0;
+	int width = 0;
+	for(int i = 0; i < length; i++){
+		unsigned char ch = text[i];
+		if(i > 0) pen += getKerning(text[i - 1], ch);
+		width = std::max(width, pen + rights[ch]);
+		pen += advances[ch];
+	}
+	return std::max(width, pen);
+}
+
+
+int TextMetrics::measureAdvance(const char *text, int length) const {
+	int pen = 0;
+	for(int i = 0; i < length; i++){
+		unsigned char ch = text[i];
+		if(i > 0) pen += getKerning(text[i - 1], ch);
+		pen += advances[ch];
+	}
+	return pen;
+}
+
+
+
+/*
+ * TextLayout
+ */
+
+TextLayout::TextLayout():
+	fontSize(12),
+	maxWidth(0),
+	metrics(NULL),
+	metricsGeneration(0),
+	textChanged(false),
+	fontChanged(false),
+	widthChanged(false),
+	firstChanged(0),
+	lastChanged(0)
+{}
+
+
+void TextLayout::setText(const std::string &t){
+	if(t == newText) return;
+	newText = t;
+	textChanged = true;
+}
+
+
+void TextLayout::setFont(std::string font, int size){
+	if(font == fontPath && size == fontSize && metrics != NULL) return;
+	fontPath = font;
+	fontSize = size;
+	metrics = TextMetrics::getMetrics(font, size);
+	metricsGeneration = TextMetrics::getGeneration();
+	fontChanged = true;
+}
+
+
+void TextLayout::setWidth(int width){
+	if(width < 0) width = 0;
+	if(width == maxWidth) return;
+	maxWidth = width;
+	widthChanged = true;
+}
+
+
+bool TextLayout::update(){
+	/**
+	 * Brings the lines up to date with the text, font and width.
+	 *
+	 * @return true if any line changed; see getFirstChangedLine and
+	 *         getLastChangedLine for which.
+	 */
+	if(!textChanged && !fontChanged && !widthChanged) return false;
+
+	// The same font measures the same once its metrics are fetched again
+	if(metricsGeneration != TextMetrics::getGeneration()){
+		metrics = TextMetrics::getMetrics(fontPath, fontSize);
+		metricsGeneration = TextMetrics::getGeneration();
+	}
+
+	int reusedWords = 0;
+	int suffixWord = 0;
+	int wordDelta = 0;
+	int charDelta = 0;
+	if(textChanged || fontChanged){
+		tokenize(reusedWords, suffixWord, wordDelta, charDelta);
+	}
+
+	// Lines up to the last one with no changed words stay.  The one before
+	// the first change is reflowed too, as its successor may have shrunk.
+	int firstLine = 0;
+	if(!fontChanged && !widthChanged){
+		firstLine = std::max(0, findLine(reusedWords) - 1);
+	}else{
+		suffixWord = words.size(); // Everything moves
+	}
+
+	reflow(firstLine, suffixWord, wordDelta, charDelta);
+
+	textChanged = false;
+	fontChanged = false;
+	widthChanged = false;
+	return true;
+}
+
+
+void TextLayout::tokenize(int &reusedWords, int &suffixWord, int &wordDelta, int &charDelta){
+	/*
+	 * Splits the new text into words.  Words in the unchanged beginning and end
+	 * of the text keep their old widths; the others are measured.
+	 *
+	 * reusedWords receives the number of unchanged leading words, suffixWord
+	 * the index of the first word of the unchanged end, and wordDelta and
+	 * charDelta how far that end has moved.
+	 */
+	int oldLength = text.size();
+	int newLength = newText.size();
+	int shorter = std::min(oldLength, newLength);
+
+	// Unchanged beginning and end of the text
+	int prefix = 0;
+	if(!fontChanged){
+		while(prefix < shorter && text[prefix] == newText[prefix]) prefix++;
+	}
+	int suffix = 0;
+	if(!fontChanged){
+		while(
+			suffix < shorter - prefix &&
+			text[oldLength - 1 - suffix] == newText[newLength - 1 - suffix]
+		) suffix++;
+	}
+	charDelta = newLength - oldLength;
+
+	std::vector<Word> oldWords;
+	oldWords.swap(words);
+
+	// Old words entirely in the unchanged end, including their delimiter
+	int oldSuffixWord = oldWords.size();
+	while(oldSuffixWord > 0 && oldWords[oldSuffixWord - 1].start > oldLength - suffix){
+		oldSuffixWord--;
+	}
+
+	reusedWords = 0;
+	suffixWord = -1;
+	int i = 0;
+	while(i < newLength){
+		char c = newText[i];
+		if(is_space(c)){
+			i++;
+			continue;
+		}
+
+		Word word;
+		word.start = i;
+		word.newline = c == '\n';
+		if(word.newline){
+			word.length = 1;
+		}else{
+			while(i < newLength && !is_space(newText[i]) && newText[i] != '\n') i++;
+			word.length = i - word.start;
+		}
+		if(word.newline) i++;
+
+		int index = words.size();
+		if(word.start + word.length < prefix && index < (int) oldWords.size()){
+			// Unchanged beginning; the delimiters on both sides are unchanged too
+			word.width = oldWords[index].width;
+			word.advance = oldWords[index].advance;
+			reusedWords = index + 1;
+		}else if(word.start > newLength - suffix){
+			// Unchanged end
+			if(suffixWord < 0){
+				suffixWord = index;
+				wordDelta = index - oldSuffixWord;
+			}
+			word.width = oldWords[index - wordDelta].width;
+			word.advance = oldWords[index - wordDelta].advance;
+		}else if(word.newline || metrics == NULL){
+			word.width = 0;
+			word.advance = 0;
+		}else{
+			word.width = metrics->measure(newText.c_str() + word.start, word.length);
+			word.advance = metrics->measureAdvance(newText.c_str() + word.start, word.length);
+		}
+		words.push_back(word);
+	}
+	if(suffixWord < 0){
+		suffixWord = words.size();
+		wordDelta = words.size() - oldSuffixWord;
+	}
+
+	text = newText;
+}
+
+
+int TextLayout::findLine(int word) const {
+	/*
+	 * The line containing the provided word; the number of lines if it is past
+	 * the end of the last one.
+	 */
+	int low = 0;
+	int high = lines.size();
+	while(low < high){
+		int middle = (low + high) / 2;
+		const TextLine &line = lines[middle];
+		if(word < line.firstWord){
+			high = middle;
+		}else if(word >= line.firstWord + line.wordCount){
+			low = middle + 1;
+		}else{
+			return middle;
+		}
+	}
+	return low;
+}
+
+
+void TextLayout::reflow(int firstLine, int suffixWord, int wordDelta, int charDelta){
+	/*
+	 * Breaks the words into lines, starting at the provided line.  Once a line
+	 * starts at a word of the unchanged end where an old line did, the old
+	 * lines from there on are kept.
+	 */
+	if(firstLine > (int) lines.size()) firstLine = lines.size();
+	std::vector<TextLine> oldLines(lines.begin() + firstLine, lines.end());
+	lines.resize(firstLine);
+
+	int wordCount = words.size();
+	int w = lines.empty() ? 0 : lines.back().firstWord + lines.back().wordCount;
+	unsigned int old = 0;
+
+	firstChanged = firstLine;
+	lastChanged = -1;
+	while(w < wordCount){
+		if(w >= suffixWord){
+			int oldWord = w - wordDelta;
+			while(old < oldLines.size() && oldLines[old].firstWord < oldWord) old++;
+			if(old < oldLines.size() && oldLines[old].firstWord == oldWord){
+				lastChanged = lines.size();
+				for(; old < oldLines.size(); old++){
+					TextLine line = oldLines[old];
+					line.firstWord += wordDelta;
+					line.start += charDelta;
+					lines.push_back(line);
+				}
+				return;
+			}
+		}
+
+		TextLine line;
+		line.firstWord = w;
+		line.wordCount = 0;
+		line.width = 0;
+		line.start = words[w].start;
+		line.length = 0;
+
+		/*
+		 * The pen is where the last word ends.  Each word moves it by the
+		 * spaces before it (with kerning on both sides) and its own advance;
+		 * the line is as wide as the pen, or as the widest reach of a word past
+		 * its end.
+		 */
+		int regular = 0;
+		int pen = 0;
+		while(w < wordCount){
+			const Word &word = words[w];
+			if(word.newline){
+				line.wordCount++;
+				w++;
+				break;
+			}
+
+			int end = word.advance;
+			if(regular > 0) end += pen + measureGap(words[w - 1], word);
+			int width = std::max(regular == 0 ? 0 : line.width, end - word.advance + word.width);
+			if(regular > 0 && maxWidth > 0 && width > maxWidth) break;
+
+			pen = end;
+			line.width = width;
+			line.length = word.start + word.length - line.start;
+			line.wordCount++;
+			regular++;
+			w++;
+		}
+		lines.push_back(line);
+	}
+	lastChanged = lines.size();
+}
+
+
+int TextLayout::measureGap(const Word &previous, const Word &next) const {
+	/*
+	 * How far the pen moves from the end of one word to the start of the next:
+	 * the spaces between them, and kerning with the words on either side.
+	 */
+	if(metrics == NULL) return 0;
+
+	int first = previous.start + previous.length - 1;
+	int length = next.start - first + 1;
+	int advance = metrics->measureAdvance(text.c_str() + first, length);
+	return advance - metrics->getAdvance(text[first]) - metrics->getAdvance(text[next.start]);
+}
+
+
+int TextLayout::getLineCount() const {return lines.size();}
+
+const TextLine &TextLayout::getLine(int index) const {return lines[index];}
+
+std::string TextLayout::getLineText(int index) const {
+	const TextLine &line = lines[index];
+	return text.substr(line.start, line.length);
+}
+
+int TextLayout::getFirstChangedLine() const {return firstChanged;}
+
+int TextLayout::getLastChangedLine() const {return lastChanged;}
@@ -0,0 +1,137 @@
+/*
+ * Declarations for text measurement and layout.
+ *
+ * TextMetrics caches the advance of every glyph of a font (path and size), so
+ * that strings can be measured without SDL_ttf: a word costs one table lookup
+ * per character, plus kerning pairs, which are cached as they are met.
+ * Strings are read as Latin-1, as with TTF_RenderText.  It is the only table
+ * of advances and kerning: the glyph cache (see glyph_cache.h) places glyphs
+ * with it, so text is drawn exactly as wide as it is measured.
+ *
+ * TextLayout breaks text into lines no wider than a given width, at spaces and
+ * newlines.  Word widths are measured once, and kept as long as the words are
+ * unchanged.  When the text is edited, the lines before the edit are kept, and
+ * the lines after it are reflowed only until they match the old ones again;
+ * editing a large document thus costs little more than the lines it touches.
+ *
+ * Notes:
+ * 1) Widths are in pixels of the font.  The width of a line is that of its
+ *    text, spaces and kerning included, as drawn by the glyph cache.  Text is
+ *    to be drawn at the size it was laid out at; other sizes are not scaled
+ *    exactly, as glyphs are hinted to whole pixels.
+ * 2) Lines break at runs of spaces, which are left out at the ends of lines.
+ *    Words wider than the layout get a line of their own.
+ * 3) Like the rest of the scene graph, metrics and layouts belong to the main
+ *    thread.
+ * 4) Metrics are dropped with their font file (see FontCache::evictFile), and
+ *    when SDL shuts down; they are measured again when next asked for.  Users
+ *    should not keep them beyond the call in which they got them.  Layouts
+ *    fetch theirs again when any have been dropped.
+ */
+#ifndef TEXT_LAYOUT_H
+#define TEXT_LAYOUT_H
+
+#include <string>
+#include <map>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+
+#include "shared_exports.h"
+#include "sdl.h"
+
+
+namespace ssg {
+
+	class SHARED_EXPORT TextMetrics {
+	public:
+		static const TextMetrics *getMetrics(std::string font, int size);
+		static int measure(std::string text, std::string font, int size);
+
+		static void evictFont(std::string font); // All sizes
+		static void clear();
+		static int getGeneration(); // Changes whenever metrics are dropped
+
+		const std::string fontPath;
+		const int fontSize;
+
+		int getHeight() const;
+		int getAdvance(unsigned char ch) const;
+		int getRight(unsigned char ch) const; // Of the glyph's cell, from the pen
+		int getKerning(unsigned char previous, unsigned char ch) const;
+
+		// Width as drawn, including any glyph reaching past the last advance
+		int measure(const std::string &text) const;
+		int measure(const char *text, int length) const;
+
+		// Distance the pen moves; unlike widths, these add up
+		int measureAdvance(const char *text, int length) const;
+
+	private:
+		int height;
+		int advances[256];
+		int rights[256];
+		mutable std::unordered_map<Uint16, int> kerningPairs;
+
+		static std::map<std::pair<std::string, int>, TextMetrics*> metrics;
+		static int generation;
+
+		TextMetrics(std::string font, int size, TTF_Font *ttf);
+	};
+
+
+
+	struct TextLine {
+		int start, length; // Characters of the text
+		int width;         // Pixels
+		int firstWord, wordCount;
+	};
+
+
+
+	class SHARED_EXPORT TextLayout {
+	public:
+		TextLayout();
+
+		void setText(const std::string &text);
+		void setFont(std::string font, int size);
+		void setWidth(int maxWidth); // Pixels; 0 for no wrapping
+
+		bool update();
+
+		int getLineCount() const;
+		const TextLine &getLine(int index) const;
+		std::string getLineText(int index) const;
+
+		// Range of lines changed by the last update which changed anything
+		int getFirstChangedLine() const;
+		int getLastChangedLine() const; // Exclusive
+
+	private:
+		struct Word {
+			int start, length;
+			int width, advance; // See TextMetrics::measure and measureAdvance
+			bool newline;       // A line break, rather than a word
+		};
+
+		std::string text, newText;
+		std::string fontPath;
+		int fontSize;
+		int maxWidth;
+		const TextMetrics *metrics;
+		int metricsGeneration;
+
+		std::vector<Word> words;
+		std::vector<TextLine> lines;
+		bool textChanged, fontChanged, widthChanged;
+		int firstChanged, lastChanged;
+
+		void tokenize(int &reusedWords, int &suffixWord, int &wordDelta, int &charDelta);
+		void reflow(int firstLine, int suffixWord, int wordDelta, int charDelta);
+		int findLine(int word) const;
+		int measureGap(const Word &previous, const Word &next) const;
+	};
+
+}
+
+#endif
@@ -0,0 +1,317 @@
+/*
+ * Source for virtualized text views
+ */
+#include <string>
+#include <list>
+#include <deque>
+#include <vector>
+
+#include "sdl.h"
+#include "text_view.h"
+#include "window.h"
+#include "renderable.h"
+#include "viewport.h"
+#include "scene_graph.h"
+#include "glyph_cache.h"
+
+using namespace ssg;
+
+
+
+ComponentTextView2D::ComponentTextView2D(Window *win):
+	fontPath(""),
+	fontSize(12),
+	colorRed(0xff),
+	colorGreen(0xff),
+	colorBlue(0xff),
+	colorAlpha(0xff),
+	fixedSize(false),
+	width(0.0f),
+	height(1.0f),
+	lineHeight(0.1f),
+	maxLines(0),
+	followTail(true),
+	window(win),
+	firstLineNumber(0),
+	lastLineOpen(false),
+	scrollPosition(0),
+	oldFontPath(""),
+	oldFontSize(12),
+	oldWidth(0.0f),
+	oldLineHeight(0.1f),
+	layoutCount(0)
+{}
+
+
+
+/*
+ * Text
+ */
+
+void ComponentTextView2D::setText(std::string text){
+	clear();
+	appendText(text);
+}
+
+
+void ComponentTextView2D::appendText(std::string text){
+	/**
+	 * Appends text to the end of the view.  The text continues the last line,
+	 * unless that line was ended by a newline; every newline in the text ends a
+	 * line.
+	 */
+	bool atEnd = isScrolledToEnd();
+
+	size_t start = 0;
+	while(true){
+		size_t end = text.find('\n', start);
+		bool ended = end != std::string::npos;
+		std::string piece = text.substr(start, ended ? end - start : std::string::npos);
+
+		if(lastLineOpen){
+			lines.back().append(piece);
+			invalidateLine(firstLineNumber + (long) lines.size() - 1);
+		}else if(ended || !piece.empty()){
+			pushLine(piece);
+		}
+
+		if(!ended){
+			lastLineOpen = lastLineOpen || !piece.empty();
+			break;
+		}
+		lastLineOpen = false;
+		start = end + 1;
+	}
+
+	if(followTail && atEnd) scrollToEnd();
+}
+
+
+void ComponentTextView2D::appendLine(std::string line){
+	/**
+	 * Appends a line of its own, even if the last line was not ended.
+	 */
+	lastLineOpen = false;
+	appendText(line + "\n");
+}
+
+
+void ComponentTextView2D::clear(){
+	lines.clear();
+	firstLineNumber = 0;
+	lastLineOpen = false;
+	scrollPosition = 0;
+	clearSlots();
+}
+
+
+int ComponentTextView2D::getLineCount() const {return lines.size();}
+
+
+const std::string &ComponentTextView2D::getLine(int index) const {
+	static const std::string empty = "";
+	if(index < 0 || index >= (int) lines.size()) return empty;
+	return lines[index];
+}
+
+
+void ComponentTextView2D::pushLine(const std::string &line){
+	lines.push_back(line);
+
+	// Dropping the oldest lines leaves the view on the same text
+	while(maxLines > 0 && (int) lines.size() > maxLines){
+		lines.pop_front();
+		firstLineNumber++;
+		if(scrollPosition > 0) scrollPosition--;
+	}
+}
+
+
+
+/*
+ * Scrolling
+ */
+
+void ComponentTextView2D::scrollTo(int line){
+	int maxPosition = getMaxScrollPosition();
+	if(line > maxPosition) line = maxPosition;
+	if(line < 0) line = 0;
+	scrollPosition = line;
+}
+
+
+void ComponentTextView2D::scrollBy(int lines){
+	scrollTo(scrollPosition + lines);
+}
+
+
+void ComponentTextView2D::scrollToEnd(){
+	scrollTo(getMaxScrollPosition());
+}
+
+
+int ComponentTextView2D::getScrollPosition() const {return scrollPosition;}
+
+
+bool ComponentTextView2D::isScrolledToEnd() const {
+	return scrollPosition >= getMaxScrollPosition();
+}
+
+
+int ComponentTextView2D::getMaxScrollPosition() const {
+	int position = (int) lines.size() - getVisibleLineCount();
+	return position > 0 ? position : 0;
+}
+
+
+int ComponentTextView2D::getVisibleLineCount() const {
+	if(lineHeight <= 0 || height <= 0) return 0;
+
+	// Tolerate rounding, e.g. a height of 10 lines of 0.1
+	return (int) (height / lineHeight + 0.001f);
+}
+
+
+int ComponentTextView2D::getLaidOutLineCount() const {
+	int count = 0;
+	for(unsigned int i = 0; i < slots.size(); i++){
+		if(slots[i].number >= 0) count++;
+	}
+	return count;
+}
+
+
+long ComponentTextView2D::getLayoutCount() const {return layoutCount;}
+
+
+
+/*
+ * Rendering
+ */
+
+void ComponentTextView2D::collectRenderables(
+	std::list<Renderable*> &render_list,
+	Viewport2D &viewport,
+	float zmod
+){
+	if(isHidden()) return;
+	if(window == NULL) return;
+
+	int rows = getVisibleLineCount();
+	if(rows < 1) return;
+
+	// Layouts depend on the font, and are cut off to the width of the view
+	if(
+		fontPath.compare(oldFontPath) != 0 ||
+		fontSize != oldFontSize ||
+		width != oldWidth ||
+		lineHeight != oldLineHeight ||
+		(int) slots.size() != rows
+	){
+		clearSlots();
+		slots.resize(rows);
+		for(int i = 0; i < rows; i++) slots[i].number = -1;
+
+		oldFontPath = fontPath;
+		oldFontSize = fontSize;
+		oldWidth = width;
+		oldLineHeight = lineHeight;
+	}
+
+
+	float scaleFactorX = scaleAbsolute.x;
+	float scaleFactorY = scaleAbsolute.y;
+	if(!fixedSize){
+		scaleFactorX *= viewport.getInverseRadiusY();
+		scaleFactorY *= viewport.getInverseRadiusY();
+	}
+	Rect2f cullRect = viewport.getViewportRect();
+
+
+	// Only the lines in view are ever laid out
+	int count = (int) lines.size() - scrollPosition;
+	if(count > rows) count = rows;
+	for(int row = 0; row < count; row++){
+		const GlyphRun *run = findRun(scrollPosition + row);
+		if(run == NULL || run->getHeight() < 1) continue;
+
+		Vector2f offset(0, -row * lineHeight);
+		offset.scale(scaleAbsolute.x, scaleAbsolute.y);
+		offset.rotate(rotationAbsolute);
+
+		Vector2f corner;
+		if(fixedSize){
+			corner = viewport.worldToViewport(positionAbsolute) + offset;
+		}else{
+			corner = viewport.worldToViewport(positionAbsolute + offset);
+		}
+
+		float ratio = (float) run->getWidth() / (float) run->getHeight();
+
+		RenderableGlyphRun *renderable = RenderableGlyphRun::createRenderableGlyphRun(
+			corner.x,
+			corner.y,
+			lineHeight * ratio * scaleFactorX,
+			lineHeight * scaleFactorY,
+			zLevel,
+			rotationAbsolute,
+			run,
+			colorRed,
+			colorGreen,
+			colorBlue,
+			colorAlpha,
+			cullRect
+		);
+
+		if(renderable != NULL){
+			renderable->zMod = zmod;
+			renderable->colorMod = colorModAbsolute;
+			render_list.push_back(renderable);
+		}
+	}
+}
+
+
+const GlyphRun *ComponentTextView2D::findRun(int index){
+	/*
+	 * The layout of the line of the provided index, laid out now if its slot
+	 * holds another line, or was laid out before the glyph cache was cleared.
+	 */
+	if(slots.empty()) return NULL;
+
+	long number = firstLineNumber + index;
+	LineSlot &slot = slots[number % slots.size()];
+	if(slot.number == number && slot.run.isValid(window->glyphCache)) return &slot.run;
+
+	slot.number = number;
+	window->glyphCache.layout(lines[index], fontPath, fontSize, slot.run);
+	layoutCount++;
+
+	// Cut off the glyphs which do not fit in the view
+	if(width > 0 && lineHeight > 0){
+		float maxWidth = width / lineHeight * slot.run.getHeight();
+		std::vector<GlyphQuad> &quads = slot.run.quads;
+		unsigned int kept = 0;
+		for(unsigned int i = 0; i < quads.size(); i++){
+			if(quads[i].x + quads[i].source.w <= maxWidth) quads[kept++] = quads[i];
+		}
+		quads.resize(kept);
+	}
+	return &slot.run;
+}
+
+
+void ComponentTextView2D::invalidateLine(long number){
+	if(slots.empty()) return;
+
+	LineSlot &slot = slots[number % slots.size()];
+	if(slot.number == number) slot.number = -1;
+}
+
+
+void ComponentTextView2D::clearSlots(){
+	for(unsigned int i = 0; i < slots.size(); i++){
+		slots[i].number = -1;
+		slots[i].run.quads.clear();
+	}
+}
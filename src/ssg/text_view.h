@@ -0,0 +1,139 @@
+/*
+ * Declarations for virtualized text views.
+ *
+ * A ComponentTextBox2D creates a text sprite for every one of its lines, which
+ * does not scale to documents or logs of many thousands of lines.  A
+ * ComponentTextView2D instead keeps its text as a buffer of lines, and draws
+ * only the lines which fit in the view, from the window's glyph cache (see
+ * glyph_cache.h).  Lines are laid out when they scroll into view, and the
+ * layouts of the visible lines are kept while they stay in view; so the cost
+ * of a frame, and the memory beyond the text itself, depends only on the
+ * height of the view.
+ *
+ * Notes:
+ * 1) The buffer is indexed by line, so finding the lines in view is O(1).
+ *    Appending text is O(1) per line; with maxLines set, the oldest lines are
+ *    dropped as new ones are appended, as in a ring buffer.
+ * 2) Lines are neither wrapped nor measured.  Lines wider than the view are
+ *    cut off at the last glyph which fits.
+ * 3) As with text sprites, text is read as Latin-1.
+ */
+#ifndef TEXT_VIEW_H
+#define TEXT_VIEW_H
+
+#include "shared_exports.h"
+
+#include <list>
+#include <deque>
+#include <vector>
+#include <string>
+
+#include "sdl.h"
+
+#include "scene_graph.h"
+#include "glyph_cache.h"
+
+
+
+namespace ssg {
+
+	class Renderable;
+	class Viewport2D;
+	class Window;
+
+
+
+	class SHARED_EXPORT ComponentTextView2D : public Component2D {
+	public:
+
+		std::string fontPath;
+		int fontSize;
+		Uint8 colorRed, colorGreen, colorBlue, colorAlpha;
+
+		/*
+		 * Size of the view, and height of each line.  Either world or viewport
+		 * coordinates, depending on fixedSize.  The position of the component is
+		 * the upper-left corner of the view.  A width of zero or less does not
+		 * cut off long lines.
+		 */
+		bool fixedSize;
+		float width, height;
+		float lineHeight;
+
+		// Lines beyond this many are dropped, oldest first; 0 for no limit
+		int maxLines;
+
+		// Whether the view stays scrolled to the end when text is appended there
+		bool followTail;
+
+
+		ComponentTextView2D(Window *win);
+
+		void setText(std::string text);
+		void appendText(std::string text);
+		void appendLine(std::string line);
+		void clear();
+
+		int getLineCount() const;
+		const std::string &getLine(int index) const;
+
+		void scrollTo(int line);
+		void scrollBy(int lines);
+		void scrollToEnd();
+		int getScrollPosition() const; // Index of the first line in view
+		bool isScrolledToEnd() const;
+
+		int getVisibleLineCount() const; // Lines which fit in the view
+		int getLaidOutLineCount() const; // Layouts currently kept
+		long getLayoutCount() const;     // Lines laid out since creation
+
+
+	internal:
+		virtual void collectRenderables(
+			std::list<Renderable*> &render_list,
+			Viewport2D &viewport
+		){
+			collectRenderables(render_list, viewport, 0.0f);
+		}
+
+		virtual void collectRenderables(
+			std::list<Renderable*> &render_list,
+			Viewport2D &viewport,
+			float zmod
+		);
+
+	protected:
+		Window *window;
+
+	private:
+		std::deque<std::string> lines;
+		long firstLineNumber; // Lines ever dropped from the front
+		bool lastLineOpen;    // Whether the last line has no newline yet
+		int scrollPosition;
+
+		/*
+		 * Layouts of the lines in view, one slot per visible row.  A line is kept
+		 * in the slot of its number (counting dropped lines) modulo the number of
+		 * slots, so scrolling by one line lays out only the line scrolled in.
+		 */
+		struct LineSlot {
+			long number; // -1 if the slot is empty
+			GlyphRun run;
+		};
+		std::vector<LineSlot> slots;
+		std::string oldFontPath;
+		int oldFontSize;
+		float oldWidth, oldLineHeight;
+		long layoutCount;
+
+		void pushLine(const std::string &line);
+		void invalidateLine(long number);
+		void clearSlots();
+		const GlyphRun *findRun(int index);
+		int getMaxScrollPosition() const;
+	};
+
+}
+
+
+#endif
@@ -1,14 +1,25 @@
 #include <cstdio>
 #include <algorithm>
 #include <string>
+#include <vector>
 
 #include "sdl.h"
 #include "window.h"
 #include "texture.h"
+#include "texture_loader.h"
+#include "texture_registry.h"
+#include "texture_residency.h"
+#include "texture_stats.h"
+#include "alpha_mask.h"
+#include "font_cache.h"
 
 using namespace ssg;
 
 
+// Minimum alpha value for a texel to count as opaque in alpha masks
+static const Uint8 ALPHA_MASK_THRESHOLD = 0x80;
+
+
 /*
  * Texture Factory Methods
  */
@@ -17,8 +28,17 @@ Texture *Texture::createSolidColor(int w, int h, Window *win,
                                    Uint8 r, Uint8 g, Uint8 b, Uint8 a){
 	if(win == NULL || w < 1 || h < 1) return NULL;
 	
+	TextureRegistry &registry = win->textureRegistry;
+	std::string key;
+	if(registry.sharingEnabled){
+		key = TextureRegistry::solidKey(w, h, r, g, b, a);
+		Texture *shared = registry.find(key);
+		if(shared != NULL) return shared;
+	}
+	
 	TextureSolid *texture = new TextureSolid(w, h, win, r, g, b, a);
 	texture->load();
+	registry.add(key, texture);
 	return texture;
 }
 
@@ -35,26 +55,31 @@ Texture *Texture::createFromText(
 ){
 	if(win == NULL) return NULL;
 	
+	TextureRegistry &registry = win->textureRegistry;
+	std::string key;
+	if(registry.sharingEnabled){
+		key = TextureRegistry::textKey(text, font, size, r, g, b, a);
+		Texture *shared = registry.find(key);
+		if(shared != NULL) return shared;
+	}
+	
 	// We need to determine the dimensions of the texture, which requires a pre-rendering
 	int w = -1;
 	int h = -1;
 	
-	TTF_Font *fnt = TTF_OpenFont(font.c_str(), size);
-	if(fnt == NULL){
-		printf("Could not load font: %s\n", TTF_GetError());
-		return NULL;
-	}
+	TTF_Font *fnt = FontCache::getFont(font, size);
+	if(fnt == NULL) return NULL;
 	TTF_SizeText(fnt, text.c_str(), &w, &h);
 	if(w == -1 || h == -1){
 		printf("Problem with font?\n");
 		return NULL;
 	}
-	TTF_CloseFont(fnt);
 	
 	
 	TextureText *texture = new TextureText(w, h, win, text, font, size, r, g, b, a);
 	
 	if(texture->load()){
+		registry.add(key, texture);
 		return texture;
 	}else{
 		delete texture;
@@ -64,24 +89,45 @@ Texture *Texture::createFromText(
 }
 
 
-Texture *Texture::createFromFile(std::string path, Window *win){
+Texture *Texture::createFromFile(std::string path, Window *win, bool buildAlphaMask){
 	if(win == NULL) return NULL;
 	
-	// Crude, but necessary: we need to determine the dimensions of the texture.
-	SDL_Surface *test = IMG_Load(path.c_str());
-	if(test == NULL){
-		printf("Unable to load texture from \"%s\"\n", path.c_str());
-		return NULL;
+	std::string key, contentKey;
+	Texture *shared = findSharedImage(path, win, buildAlphaMask, key, contentKey);
+	if(shared != NULL) return shared;
+	
+	/*
+	 * The dimensions of PNG images can be read from their headers.  Other
+	 * images must be decoded to be measured; the decoded image is then used
+	 * for the texture rather than decoded again.
+	 */
+	int w, h;
+	SDL_Surface *decoded = NULL;
+	if(!read_png_size(path, w, h)){
+		decoded = IMG_Load(path.c_str());
+		if(decoded == NULL){
+			printf("Unable to load texture from \"%s\"\n", path.c_str());
+			return NULL;
+		}
+		w = decoded->w;
+		h = decoded->h;
 	}
-	int w = test->w;
-	int h = test->h;
-	SDL_FreeSurface(test);
 	
 	
-	TextureImage *texture = new TextureImage(w, h, win, path);
+	TextureImage *texture = new TextureImage(w, h, win, path, buildAlphaMask);
 	
 	// Make sure the texture loads (i.e. image path is valid)
-	if(texture->load()){
+	bool loaded;
+	if(decoded != NULL){
+		loaded = texture->loadFromSurface(decoded);
+		SDL_FreeSurface(decoded);
+	}else{
+		loaded = texture->load();
+	}
+	
+	if(loaded){
+		win->textureRegistry.add(key, texture);
+		win->textureRegistry.add(contentKey, texture);
 		return texture;
 	}else{
 		delete texture;
@@ -91,6 +137,80 @@ Texture *Texture::createFromFile(std::string path, Window *win){
 }
 
 
+Texture *Texture::createFromFileAsync(
+	std::string path,
+	Window *win,
+	TextureLoadCallback *callback,
+	bool buildAlphaMask
+){
+	/**
+	 * Creates an image texture without waiting for its image; decoding happens
+	 * on the window's loader threads, and the texture is uploaded during a
+	 * later Window::update.  The callback (if any) is run once that is done.
+	 *
+	 * Only PNG images can be sized without decoding them; other formats are
+	 * loaded synchronously, and their callback runs before this returns.
+	 */
+	if(win == NULL) return NULL;
+	
+	// Textures still pending are not shared, since their callbacks are taken.
+	std::string key, contentKey;
+	Texture *shared = findSharedImage(path, win, buildAlphaMask, key, contentKey);
+	if(shared != NULL && !shared->isPending()){
+		if(callback != NULL) callback->callback(shared, true);
+		return shared;
+	}
+	
+	int w, h;
+	if(!read_png_size(path, w, h)){
+		Texture *texture = createFromFile(path, win, buildAlphaMask);
+		if(callback != NULL && texture != NULL) callback->callback(texture, true);
+		return texture;
+	}
+	
+	TextureLoader *loader = win->getTextureLoader();
+	if(loader == NULL) return NULL;
+	
+	TextureImage *texture = new TextureImage(w, h, win, path, buildAlphaMask);
+	loader->request(texture, callback);
+	if(shared == NULL){
+		win->textureRegistry.add(key, texture);
+		win->textureRegistry.add(contentKey, texture);
+	}
+	return texture;
+}
+
+
+Texture *Texture::findSharedImage(
+	std::string path,
+	Window *win,
+	bool buildAlphaMask,
+	std::string &key,
+	std::string &contentKey
+){
+	/*
+	 * Looks for a registered texture of the provided image file, first by path
+	 * and then (optionally) by content.  The keys are returned for registering
+	 * a new texture when none is found.
+	 */
+	TextureRegistry &registry = win->textureRegistry;
+	if(!registry.sharingEnabled) return NULL;
+	
+	key = TextureRegistry::fileKey(path, buildAlphaMask);
+	Texture *shared = registry.find(key);
+	if(shared != NULL) return shared;
+	
+	if(registry.contentHashing){
+		contentKey = TextureRegistry::contentKey(path, buildAlphaMask);
+		shared = registry.find(contentKey);
+		
+		// Remember the new path too, to skip hashing next time
+		if(shared != NULL) registry.add(key, shared);
+	}
+	return shared;
+}
+
+
 /*
  * Texture Solid
  */
@@ -102,7 +222,9 @@ TextureSolid::TextureSolid(int w, int h, Window *win,
 	colorGreen(g),
 	colorBlue(b),
 	colorAlpha(a)
-{}
+{
+	kind = "solid";
+}
 
 
 bool TextureSolid::load(){
@@ -141,6 +263,26 @@ bool TextureSolid::load(){
 }
 
 
+SDL_Surface *TextureSolid::createSurface() const {
+	SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(
+		0, width, height, 32, SDL_PIXELFORMAT_RGBA8888
+	);
+	if(surface == NULL) return NULL;
+	
+	Uint32 color = SDL_MapRGBA(surface->format, colorRed, colorGreen, colorBlue, colorAlpha);
+	SDL_FillRect(surface, NULL, color);
+	return surface;
+}
+
+
+std::string TextureSolid::getDescription() const {
+	char description[16];
+	snprintf(description, sizeof(description), "#%02x%02x%02x%02x",
+		colorRed, colorGreen, colorBlue, colorAlpha);
+	return description;
+}
+
+
 
 /*
  * TextureText
@@ -166,10 +308,17 @@ TextureText::TextureText(
 	colorGreen(green),
 	colorBlue(blue),
 	colorAlpha(alpha)
-{}
+{
+	kind = "text";
+}
+
+
+TextureText::~TextureText(){
+	// Give the texture back to the pool; ~Texture would destroy it.
+	unload();
+}
 
 
-//TODO: duplicated code smell
 bool TextureText::load(){
 	if(isLoaded()) return true;
 	
@@ -179,13 +328,59 @@ bool TextureText::load(){
 		return false;
 	}
 	
-	SDL_Surface *loadedImage, *convertedImage;
+	SDL_Surface *surface = createSurface();
+	if(surface == NULL) return false;
+	
+	// Reuse a texture of the same size class, if one is idle
+	TexturePool &pool = window->texturePool;
+	SDL_Texture *texture = pool.acquire(
+		renderer,
+		surface->w,
+		surface->h,
+		window->getFormat()->format,
+		SDL_TEXTUREACCESS_STREAMING
+	);
+	if(texture != NULL && copy_surface_to_texture(texture, surface) < 0){
+		printf("Could not upload text: %s\n", SDL_GetError());
+		pool.release(texture);
+		texture = NULL;
+	}
 	
-	TTF_Font *font = TTF_OpenFont(fontName.c_str(), fontSize);
-	if(font == NULL){
-		printf("Could not load font: %s\n", TTF_GetError());
-		return false;
+	sourceRect.x = 0;
+	sourceRect.y = 0;
+	sourceRect.w = surface->w;
+	sourceRect.h = surface->h;
+	SDL_FreeSurface(surface);
+	
+	if(texture == NULL) return false;
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+	sdlTexture = texture;
+	
+	return isLoaded();
+}
+
+
+void TextureText::unload(){
+	if(!isLoaded()) return;
+	
+	// Inactive windows have no renderer to reuse the texture with
+	if(window->isActive()){
+		window->texturePool.release(sdlTexture);
+		sdlTexture = NULL;
+	}else{
+		Texture::unload();
 	}
+}
+
+
+const SDL_Rect *TextureText::getSourceRect() const {
+	return isLoaded() ? &sourceRect : NULL;
+}
+
+
+SDL_Surface *TextureText::createSurface() const {
+	TTF_Font *font = FontCache::getFont(fontName, fontSize);
+	if(font == NULL) return NULL;
 	
 	SDL_Color fontColor;
 	fontColor.r = colorRed;
@@ -193,25 +388,15 @@ bool TextureText::load(){
 	fontColor.b = colorBlue;
 	fontColor.a = colorAlpha;
 	
-	loadedImage = TTF_RenderText_Solid(font, text.c_str(), fontColor);
-	if(loadedImage == NULL){
-		printf("Could not load font: %s\n", TTF_GetError());
-		TTF_CloseFont(font);
-		return false;
-	}
-	
+	SDL_Surface *surface = TTF_RenderText_Solid(font, text.c_str(), fontColor);
+	if(surface == NULL) printf("Could not load font: %s\n", TTF_GetError());
 	
-	convertedImage = SDL_ConvertSurface(loadedImage, window->getFormat(), 0);
-	
-	sdlTexture = SDL_CreateTextureFromSurface(renderer, convertedImage);
-	SDL_SetTextureBlendMode(sdlTexture, SDL_BLENDMODE_BLEND);
-	
-	// Cleanup
-	TTF_CloseFont(font);
-	SDL_FreeSurface(loadedImage);
-	SDL_FreeSurface(convertedImage);
-	
-	return isLoaded();
+	return surface;
+}
+
+
+std::string TextureText::getDescription() const {
+	return "\"" + text + "\"";
 }
 
 
@@ -220,10 +405,28 @@ bool TextureText::load(){
  * TextureImage
  */
 
-TextureImage::TextureImage(int w, int h, Window *win, std::string path):
+TextureImage::TextureImage(int w, int h, Window *win, std::string path, bool mask):
 	Texture(w, h, win),
-	filePath(path)
-{}
+	filePath(path),
+	alphaMaskEnabled(mask),
+	alphaMask(NULL),
+	pending(false)
+{
+	kind = "image";
+}
+
+
+TextureImage::~TextureImage(){
+	if(pending){
+		TextureLoader *loader = window->getTextureLoader();
+		if(loader != NULL) loader->cancel(this);
+	}
+	
+	if(alphaMask != NULL){
+		delete alphaMask;
+		alphaMask = NULL;
+	}
+}
 
 
 bool TextureImage::load(){
@@ -237,28 +440,86 @@ bool TextureImage::load(){
 	}
 	
 	
-	SDL_Surface *loadedImage, *convertedImage;
-	
-	loadedImage = IMG_Load(filePath.c_str());
+	SDL_Surface *loadedImage = IMG_Load(filePath.c_str());
 	if(loadedImage == NULL){
 		printf("Unable to load texture from \"%s\"\n", filePath.c_str());
 		return false;
 	}
 	
-	convertedImage = SDL_ConvertSurface(loadedImage, window->getFormat(), 0);
-	
-	sdlTexture = SDL_CreateTextureFromSurface(renderer, convertedImage);
-	SDL_SetTextureBlendMode(sdlTexture, SDL_BLENDMODE_BLEND);
-	
+	loadFromSurface(loadedImage);
 	
 	// Clean Up
 	SDL_FreeSurface(loadedImage);
-	SDL_FreeSurface(convertedImage);
 	
 	return isLoaded();
 }
 
 
+bool TextureImage::loadFromSurface(SDL_Surface *surface){
+	/*
+	 * Loads the texture from its decoded image, in whatever format it was
+	 * decoded in.
+	 */
+	if(isLoaded()) return true;
+	
+	// The alpha mask only needs to be built once; it survives unloading.
+	if(alphaMaskEnabled && alphaMask == NULL){
+		alphaMask = AlphaMask::createFromSurface(surface, ALPHA_MASK_THRESHOLD);
+	}
+	
+	return uploadSurface(surface);
+}
+
+
+bool TextureImage::uploadSurface(SDL_Surface *surface){
+	/*
+	 * Creates the SDL texture from a decoded image.  Images in the window's
+	 * format are copied straight into texture memory; others are converted on
+	 * the way.  Shared by synchronous loads and by the TextureLoader.
+	 */
+	if(surface == NULL) return false;
+	
+	SDL_Renderer *renderer = window->getRenderer();
+	if(renderer == NULL){
+		printf("Cannot load Texture; Window has no active renderer.\n");
+		return false;
+	}
+	
+	sdlTexture = create_texture_from_surface(renderer, surface, window->getFormat()->format);
+	SDL_SetTextureBlendMode(sdlTexture, SDL_BLENDMODE_BLEND);
+	return isLoaded();
+}
+
+
+bool TextureImage::requestLoad(){
+	/**
+	 * Loads the image on the window's loader threads, rather than decoding it on
+	 * the calling thread.
+	 */
+	if(isLoaded() || pending) return true;
+	
+	TextureLoader *loader = window->getTextureLoader();
+	if(loader == NULL) return load();
+	
+	loader->request(this, NULL);
+	return true;
+}
+
+
+bool TextureImage::isPending() const {return pending;}
+
+std::string TextureImage::getDescription() const {return filePath;}
+
+
+SDL_Surface *TextureImage::createSurface() const {
+	SDL_Surface *surface = IMG_Load(filePath.c_str());
+	if(surface == NULL){
+		printf("Unable to load texture from \"%s\"\n", filePath.c_str());
+	}
+	return surface;
+}
+
+
 
 
 /*
@@ -269,17 +530,52 @@ Texture::Texture(int w, int h, Window *win):
 	window(win),
 	width(w),
 	height(h),
-	sdlTexture(NULL)
-{}
+	sdlTexture(NULL),
+	kind("texture"),
+	referenceCount(0),
+	holders(NULL),
+	registry(NULL),
+	residency(NULL),
+	residencyBytes(0),
+	lastUsedFrame(0),
+	evicted(false)
+{
+	TextureStats::textureCreated(this);
+}
 
 
 Texture::~Texture(){
 	
-	for(const auto &result : ownerTable){
-		TextureOwner *owner = (TextureOwner*) result.first;
-		if(owner != NULL){
-			owner->removeTextureReference(this);
+	TextureStats::textureDestroyed(this);
+	
+	if(registry != NULL) registry->remove(this);
+	if(residency != NULL) residency->remove(this);
+	
+	/*
+	 * Null out every handle before telling any owner, so that owners dropping
+	 * their other handles in removeTextureReference cannot release the texture
+	 * a second time.  Each owner is told once, however many handles it holds.
+	 */
+	std::vector<TextureOwner*> notify;
+	TextureRef *ref = holders;
+	holders = NULL;
+	while(ref != NULL){
+		TextureRef *next = ref->next;
+		ref->texture = NULL;
+		ref->previous = NULL;
+		ref->next = NULL;
+		
+		TextureOwner *owner = ref->owner;
+		if(owner != NULL && std::find(notify.begin(), notify.end(), owner) == notify.end()){
+			notify.push_back(owner);
 		}
+		if(ref->allocated) delete ref;
+		ref = next;
+	}
+	referenceCount = 0;
+	
+	for(unsigned int i = 0; i < notify.size(); i++){
+		notify[i]->removeTextureReference(this);
 	}
 	
 	
@@ -289,6 +585,8 @@ Texture::~Texture(){
 
 bool Texture::isLoaded() const {return sdlTexture != NULL;}
 
+bool Texture::isPending() const {return false;}
+
 void Texture::unload(){
 	if(isLoaded()){
 		SDL_DestroyTexture(sdlTexture);
@@ -301,31 +599,71 @@ bool Texture::reload(){
 	return load();
 }
 
+bool Texture::requestLoad(){
+	/**
+	 * Loads the texture, asynchronously if that is possible for its kind.
+	 */
+	return load();
+}
+
+size_t Texture::getByteSize() const {
+	/**
+	 * @return the bytes of pixel data of the texture, from its format and
+	 *         dimensions.  Unloaded textures report the size they would have in
+	 *         the window's pixel format.
+	 */
+	Uint32 format = SDL_PIXELFORMAT_UNKNOWN;
+	int w = width;
+	int h = height;
+	if(sdlTexture != NULL){
+		SDL_QueryTexture(sdlTexture, &format, NULL, &w, &h);
+	}else if(window != NULL && window->getFormat() != NULL){
+		format = window->getFormat()->format;
+	}
+	
+	int bytesPerPixel = SDL_BYTESPERPIXEL(format);
+	if(bytesPerPixel < 1) bytesPerPixel = 4;
+	return (size_t) w * h * bytesPerPixel;
+}
+
+
+std::string Texture::getKind() const {return kind;}
+
+std::string Texture::getDescription() const {return "";}
+
 
 void Texture::addOwner(TextureOwner *owner){
+	/**
+	 * Gives the owner a reference to the texture, held by a handle that the
+	 * texture keeps for it.  Owners which store the texture anyway should hold
+	 * a TextureRef of their own instead.
+	 */
 	if(owner != NULL){
-		if(ownerTable.find(owner) != ownerTable.end()){
-			ownerTable[owner]++;
-		}else{
-			ownerTable[owner] = 1;
-		}
+		TextureRef *ref = new TextureRef(this, owner);
+		ref->allocated = true;
 	}
 }
 
 
 void Texture::removeOwner(TextureOwner *owner){
-	
-	
-	if(ownerTable.find(owner) != ownerTable.end()){
-		ownerTable[owner]--;
-		if(ownerTable[owner] < 1) ownerTable.erase(owner);
+	/**
+	 * Drops one reference given to the owner by addOwner.  The texture is
+	 * deleted if nothing references it any more.
+	 */
+	for(TextureRef *ref = holders; ref != NULL; ref = ref->next){
+		if(ref->allocated && ref->owner == owner){
+			delete ref; // May delete the texture
+			return;
+		}
 	}
 	
-	
-	if(ownerTable.empty()) delete this;
+	if(referenceCount == 0) delete this;
 }
 
 
+int Texture::getReferenceCount() const {return referenceCount;}
+
+
 float Texture::getAspectRatio() const {
 	return (float) width / (float) height;
 }
@@ -333,41 +671,163 @@ float Texture::getAspectRatio() const {
 
 SDL_Texture *Texture::getSdlTexture() const {return sdlTexture;}
 
+const AlphaMask *Texture::getAlphaMask() const {return NULL;}
+
+SDL_Surface *Texture::createSurface() const {return NULL;}
+
+const SDL_Rect *Texture::getSourceRect() const {return NULL;}
+
+const AlphaMask *TextureImage::getAlphaMask() const {return alphaMask;}
+
+
+
+/*
+ * TextureRef
+ */
+
+TextureRef::TextureRef(Texture *tex, TextureOwner *o):
+	texture(NULL),
+	owner(o),
+	previous(NULL),
+	next(NULL),
+	allocated(false)
+{
+	reset(tex);
+}
+
+
+TextureRef::TextureRef(const TextureRef &other):
+	texture(NULL),
+	owner(NULL),
+	previous(NULL),
+	next(NULL),
+	allocated(false)
+{
+	reset(other.texture);
+}
+
+
+TextureRef::~TextureRef(){
+	reset();
+}
+
+
+TextureRef &TextureRef::operator=(const TextureRef &other){
+	reset(other.texture);
+	return *this;
+}
+
+
+void TextureRef::reset(Texture *tex){
+	/**
+	 * Makes the handle refer to another texture (or none).  The previous
+	 * texture is deleted if this was its last reference.
+	 */
+	if(tex == texture) return;
+	
+	Texture *old = texture;
+	bool release = false;
+	if(old != NULL){
+		if(previous != NULL){
+			previous->next = next;
+		}else{
+			old->holders = next;
+		}
+		if(next != NULL) next->previous = previous;
+		release = --old->referenceCount == 0;
+	}
+	
+	previous = NULL;
+	next = NULL;
+	texture = tex;
+	if(tex != NULL){
+		next = tex->holders;
+		if(next != NULL) next->previous = this;
+		tex->holders = this;
+		tex->referenceCount++;
+	}
+	
+	// Only now, in case the old texture's destructor touches this handle
+	if(release) delete old;
+}
+
+
+Texture *TextureRef::get() const {return texture;}
+
+Texture *TextureRef::operator->() const {return texture;}
+
+TextureOwner *TextureRef::getOwner() const {return owner;}
+
 
 
 /*
  * TextureCache
  */
 
+TextureCache::TextureCache():
+	compactPending(false)
+{}
+
+
 TextureCache::~TextureCache(){
-	while(!ownedTextures.empty()){
-		Texture *texture = ownedTextures.front();
-		if(texture != NULL) texture->removeOwner(this);
-		ownedTextures.pop_front();
+	for(unsigned int i = 0; i < ownedTextures.size(); i++){
+		delete ownedTextures[i];
 	}
+	ownedTextures.clear();
 }
 
 
 void TextureCache::addTexture(Texture *texture){
 	if(texture != NULL){
-		texture->addOwner(this);
-		ownedTextures.push_back(texture);
+		ownedTextures.push_back(new TextureRef(texture, this));
 	}
 }
 
 
 void TextureCache::removeTexture(Texture *texture){
-	removeTextureReference(texture);
-	if(texture != NULL) texture->removeOwner(this);
+	/**
+	 * Drops one reference to the provided texture, deleting it if that was the
+	 * last one.
+	 */
+	if(texture == NULL) return;
+	compact();
+	
+	for(int i = ownedTextures.size() - 1; i >= 0; i--){
+		if(ownedTextures[i]->get() == texture){
+			TextureRef *ref = ownedTextures[i];
+			ownedTextures[i] = ownedTextures.back();
+			ownedTextures.pop_back();
+			delete ref;
+			return;
+		}
+	}
 }
 
 
 void TextureCache::removeTextureReference(Texture *texture){
-	ownedTextures.remove(texture);
+	// The handles are already nulled out; drop them lazily.
+	compactPending = true;
+}
+
+
+void TextureCache::compact(){
+	if(!compactPending) return;
+	
+	unsigned int live = 0;
+	for(unsigned int i = 0; i < ownedTextures.size(); i++){
+		if(ownedTextures[i]->get() != NULL){
+			ownedTextures[live++] = ownedTextures[i];
+		}else{
+			delete ownedTextures[i];
+		}
+	}
+	ownedTextures.resize(live);
+	compactPending = false;
 }
 
 
 int TextureCache::textureCount(){
+	compact();
 	return ownedTextures.size();
 }
 
@@ -20,6 +20,26 @@
  *    transparent rectangle in any viewer.
  * 9) An unloaded Texture will not be reloaded automatically when it is needed;
  *    the user must manually reload so by calling its load method.
+ * 10) Image textures may optionally keep a bit-packed alpha mask (see
+ *    alpha_mask.h), built once when the image is first loaded.  It costs 1/32
+ *    of the memory of the RGBA image and is kept even while unloaded.
+ * 11) Image textures may also be loaded asynchronously (see texture_loader.h).
+ *    Until their image arrives, they are "pending", and behave as unloaded.
+ * 12) The factory methods may return textures shared with earlier callers, if
+ *    the window's texture registry has sharing enabled (see
+ *    texture_registry.h).  Shared textures are freed with their last owner.
+ * 13) A window may be given a texture memory budget (see texture_residency.h).
+ *    Textures it unloads to meet the budget are reloaded automatically.
+ * 14) All textures are listed in a global registry for memory accounting (see
+ *    texture_stats.h).
+ * 15) Atlas regions (see texture_atlas.h) share the SDL texture of an atlas
+ *    page, and only draw their own source rectangle of it.
+ * 16) Text textures take their SDL texture from the window's texture pool (see
+ *    texture_pool.h), and give it back when unloaded.
+ * 17) Ownership is an intrusive reference count.  Every reference is a
+ *    TextureRef handle linked into its texture's list of holders, so taking or
+ *    dropping a reference is O(1) and involves no hashing.  addOwner and
+ *    removeOwner are kept for existing owners; they allocate a handle each.
  */
 
 #ifndef TEXTURE_H
@@ -27,7 +47,7 @@
 
 #include <string>
 #include <list>
-#include <unordered_map>
+#include <vector>
 
 #include "shared_exports.h"
 #include "sdl.h"
@@ -37,10 +57,19 @@ namespace ssg {
 
 	class Window;
 	class TextureOwner;
+	class TextureRef;
+	class TextureLoadCallback;
+	class TextureRegistry;
+	class ResidencyManager;
+	class AlphaMask;
 
 
 
 	class SHARED_EXPORT Texture {
+	friend class TextureRegistry;
+	friend class ResidencyManager;
+	friend class TextureStats;
+	friend class TextureRef;
 	public:
 		/*
 		 * Factory Methods for Textures
@@ -66,7 +95,14 @@ namespace ssg {
 		);
 		static Texture *createFromFile(
 			std::string filepath,
-			Window *win
+			Window *win,
+			bool buildAlphaMask = false
+		);
+		static Texture *createFromFileAsync(
+			std::string filepath,
+			Window *win,
+			TextureLoadCallback *callback = NULL,
+			bool buildAlphaMask = false
 		);
 	
 	
@@ -82,26 +118,68 @@ namespace ssg {
 		virtual bool load() = 0;
 		virtual bool reload();
 		virtual void unload();
+		virtual bool requestLoad();
 		bool isLoaded() const;
+		virtual bool isPending() const;
+		
+		// Memory used by the texture's pixels when loaded
+		virtual size_t getByteSize() const;
+		
+		// For memory statistics (see texture_stats.h)
+		std::string getKind() const;
+		virtual std::string getDescription() const;
 	
 		void addOwner(TextureOwner *owner);
 		void removeOwner(TextureOwner *owner);
+		int getReferenceCount() const;
 	
 		float getAspectRatio() const;
 		
+		// Returns NULL if the texture has no alpha mask
+		virtual const AlphaMask *getAlphaMask() const;
+		
+		// New software copy of the texture's contents; the caller must free it.
+		virtual SDL_Surface *createSurface() const;
+		
+		// Part of the SDL texture to draw; NULL if the whole texture is drawn.
+		virtual const SDL_Rect *getSourceRect() const;
+		
 	internal:
 		SDL_Texture *getSdlTexture() const; // returns NULL if not loaded
 	
 	protected:
 		bool loaded;
 		SDL_Texture *sdlTexture;
+		const char *kind; // Set by the constructor of each subclass
 	
 		Texture(int w, int h, Window *win);
+		
+		static Texture *findSharedImage(
+			std::string path,
+			Window *win,
+			bool buildAlphaMask,
+			std::string &key,
+			std::string &contentKey
+		);
 
 	private:
 		void init();
-		std::list<TextureOwner*> owners;
-		std::unordered_map<TextureOwner*, int> ownerTable;
+		
+		// Handles referencing the texture (see TextureRef)
+		int referenceCount;
+		TextureRef *holders;
+		TextureRegistry *registry; // NULL unless shared
+		
+		// Residency tracking (see texture_residency.h)
+		ResidencyManager *residency;
+		std::list<Texture*>::iterator residencyEntry;
+		size_t residencyBytes;
+		Uint64 lastUsedFrame;
+		bool evicted;
+		
+		// Global texture list (see texture_stats.h)
+		Texture *statsPrevious, *statsNext;
+		Uint64 createdFrame;
 	};
 
 
@@ -113,6 +191,8 @@ namespace ssg {
 		const Uint8 colorRed, colorGreen, colorBlue, colorAlpha;
 	
 		virtual bool load();
+		virtual SDL_Surface *createSurface() const;
+		virtual std::string getDescription() const;
 	
 	protected:
 		TextureSolid(int w, int h, Window *win, Uint8 r, Uint8 g, Uint8 b, Uint8 a);
@@ -128,7 +208,15 @@ namespace ssg {
 		const std::string text;
 		const Uint8 colorRed, colorGreen, colorBlue, colorAlpha;
 	
+		virtual ~TextureText();
+	
 		virtual bool load();
+		virtual void unload();
+		virtual SDL_Surface *createSurface() const;
+		virtual std::string getDescription() const;
+		
+		// Pooled textures are rounded up in size (see texture_pool.h)
+		virtual const SDL_Rect *getSourceRect() const;
 
 	protected:
 		TextureText(
@@ -143,19 +231,39 @@ namespace ssg {
 			Uint8 blue,
 			Uint8 alpha
 		);
+	
+	private:
+		SDL_Rect sourceRect;
 	};
 
 
 
 	class SHARED_EXPORT TextureImage : public Texture {
 	friend class Texture;
+	friend class TextureLoader;
 	public:
 		const std::string filePath;
+		const bool alphaMaskEnabled;
+	
+		virtual ~TextureImage();
 	
 		virtual bool load();
+		virtual bool requestLoad();
+		virtual bool isPending() const;
+		virtual SDL_Surface *createSurface() const;
+		virtual std::string getDescription() const;
+		
+		virtual const AlphaMask *getAlphaMask() const;
 	
 	protected:
-		TextureImage(int w, int h, Window *win, std::string path);
+		TextureImage(int w, int h, Window *win, std::string path, bool mask);
+		
+		bool loadFromSurface(SDL_Surface *surface);
+		bool uploadSurface(SDL_Surface *surface);
+	
+	private:
+		AlphaMask *alphaMask;
+		bool pending; // Waiting for the window's TextureLoader
 	};
 
 
@@ -172,12 +280,49 @@ namespace ssg {
 	
 	
 	
+	/*
+	 * Counted reference to a texture.  The texture lives as long as any handle
+	 * refers to it, and is deleted with its last one.  If the texture is deleted
+	 * manually, every handle is nulled out, and its owner (if it has one) is told
+	 * through removeTextureReference.
+	 *
+	 * Handles are not thread safe; like the rest of the scene graph, they belong
+	 * to the main thread.
+	 */
+	
+	class SHARED_EXPORT TextureRef {
+	friend class Texture;
+	friend class TextureStats;
+	public:
+		explicit TextureRef(Texture *texture = NULL, TextureOwner *owner = NULL);
+		TextureRef(const TextureRef &other);
+		~TextureRef();
+		
+		// Copies the texture; each handle keeps its own owner.
+		TextureRef &operator=(const TextureRef &other);
+		
+		void reset(Texture *texture = NULL);
+		Texture *get() const;
+		Texture *operator->() const;
+		
+		TextureOwner *getOwner() const;
+	
+	private:
+		Texture *texture;
+		TextureOwner * const owner;
+		TextureRef *previous, *next;
+		bool allocated; // Created by Texture::addOwner
+	};
+	
+	
+	
 	/*
 	 * A special type of TextureOwner that just maintains a list of textures
 	 */
 	
 	class SHARED_EXPORT TextureCache : public TextureOwner {
 	public:
+		TextureCache();
 		virtual ~TextureCache();
 		void addTexture(Texture *texture);
 		void removeTexture(Texture *texture);
@@ -189,7 +334,11 @@ namespace ssg {
 		virtual void removeTextureReference(Texture *texture);
 		
 	private:
-		std::list<Texture*> ownedTextures;
+		// Handles of deleted textures are nulled, and dropped on the next change
+		std::vector<TextureRef*> ownedTextures;
+		bool compactPending;
+		
+		void compact();
 	};
 
 }
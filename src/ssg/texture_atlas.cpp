@@ -0,0 +1,337 @@
+/*
+ * Source for runtime texture atlases
+ */
+#include <cstdio>
+#include <climits>
+#include <string>
+#include <vector>
+
+#include "sdl.h"
+#include "window.h"
+#include "texture.h"
+#include "texture_atlas.h"
+
+using namespace ssg;
+
+
+// Transparent gap (in pixels) kept to the right of and below every region, so
+// that filtering never samples a neighbouring image.
+static const int ATLAS_PADDING = 1;
+
+
+
+/*
+ * SkylinePacker
+ */
+
+SkylinePacker::SkylinePacker(int w, int h):
+	width(w),
+	height(h)
+{
+	clear();
+}
+
+
+void SkylinePacker::clear(){
+	skyline.clear();
+	Segment floor;
+	floor.x = 0;
+	floor.y = 0;
+	floor.width = width;
+	skyline.push_back(floor);
+	usedArea = 0;
+}
+
+
+bool SkylinePacker::insert(int w, int h, SDL_Rect &out){
+	/**
+	 * Finds a place for a w by h rectangle.  Of all positions at which the
+	 * rectangle fits, the one with the lowest top edge is chosen; ties go to
+	 * the narrowest skyline segment.
+	 *
+	 * @return true if the rectangle was placed; its position is written to out.
+	 */
+	if(w < 1 || h < 1 || w > width || h > height) return false;
+
+	int bestIndex = -1;
+	int bestTop = INT_MAX;
+	int bestWidth = INT_MAX;
+	int bestY = 0;
+	for(unsigned int i = 0; i < skyline.size(); i++){
+		int y = findHeight(i, w);
+		if(y < 0 || y + h > height) continue;
+
+		if(y + h < bestTop || (y + h == bestTop && skyline[i].width < bestWidth)){
+			bestIndex = i;
+			bestTop = y + h;
+			bestWidth = skyline[i].width;
+			bestY = y;
+		}
+	}
+	if(bestIndex < 0) return false;
+
+	out.x = skyline[bestIndex].x;
+	out.y = bestY;
+	out.w = w;
+	out.h = h;
+
+	addSegment(bestIndex, out.x, out.y, w, h);
+	usedArea += (long) w * h;
+	return true;
+}
+
+
+int SkylinePacker::findHeight(int index, int w) const {
+	/*
+	 * The height at which a rectangle of width w would rest if its left edge
+	 * were aligned with the provided segment, or -1 if it would not fit.
+	 */
+	if(skyline[index].x + w > width) return -1;
+
+	int y = 0;
+	int remaining = w;
+	for(unsigned int i = index; remaining > 0; i++){
+		if(i >= skyline.size()) return -1;
+		if(skyline[i].y > y) y = skyline[i].y;
+		remaining -= skyline[i].width;
+	}
+	return y;
+}
+
+
+void SkylinePacker::addSegment(int index, int x, int y, int w, int h){
+	Segment segment;
+	segment.x = x;
+	segment.y = y + h;
+	segment.width = w;
+	skyline.insert(skyline.begin() + index, segment);
+
+	// Trim the segments now hidden beneath the new one
+	for(unsigned int i = index + 1; i < skyline.size();){
+		const Segment &previous = skyline[i - 1];
+		int overlap = previous.x + previous.width - skyline[i].x;
+		if(overlap <= 0) break;
+
+		skyline[i].x += overlap;
+		skyline[i].width -= overlap;
+		if(skyline[i].width > 0) break;
+		skyline.erase(skyline.begin() + i);
+	}
+
+	// Merge neighbours of equal height
+	for(unsigned int i = 0; i + 1 < skyline.size();){
+		if(skyline[i].y == skyline[i + 1].y){
+			skyline[i].width += skyline[i + 1].width;
+			skyline.erase(skyline.begin() + i + 1);
+		}else{
+			i++;
+		}
+	}
+}
+
+
+float SkylinePacker::getOccupancy() const {
+	/**
+	 * @return the fraction of the bin covered by inserted rectangles.
+	 */
+	return (float) usedArea / ((float) width * (float) height);
+}
+
+
+
+/*
+ * AtlasRegion
+ */
+
+AtlasRegion::AtlasRegion(TextureAtlas *a, SDL_Texture *page, SDL_Rect rect):
+	Texture(rect.w, rect.h, a->window),
+	atlas(a),
+	pageTexture(page),
+	sourceRect(rect)
+{
+	kind = "region";
+}
+
+
+AtlasRegion::~AtlasRegion(){
+	// The page belongs to the atlas; it must not be destroyed with the region.
+	sdlTexture = NULL;
+}
+
+
+bool AtlasRegion::load(){
+	if(isLoaded()) return true;
+	sdlTexture = pageTexture;
+	return isLoaded();
+}
+
+
+void AtlasRegion::unload(){
+	sdlTexture = NULL;
+}
+
+
+const SDL_Rect *AtlasRegion::getSourceRect() const {return &sourceRect;}
+
+TextureAtlas *AtlasRegion::getAtlas() const {return atlas;}
+
+// The memory belongs to the atlas page
+size_t AtlasRegion::getByteSize() const {return 0;}
+
+
+void AtlasRegion::detachAtlas(){
+	atlas = NULL;
+	pageTexture = NULL;
+	sdlTexture = NULL;
+}
+
+
+
+/*
+ * TextureAtlas
+ */
+
+TextureAtlas *TextureAtlas::createTextureAtlas(Window *win, int pageWidth, int pageHeight){
+	if(win == NULL || win->getRenderer() == NULL) return NULL;
+	if(pageWidth < 1 || pageHeight < 1) return NULL;
+
+	return new TextureAtlas(win, pageWidth, pageHeight);
+}
+
+
+TextureAtlas::TextureAtlas(Window *win, int w, int h):
+	window(win),
+	pageWidth(w),
+	pageHeight(h)
+{}
+
+
+TextureAtlas::~TextureAtlas(){
+	while(!regions.empty()){
+		AtlasRegion *region = regions.front();
+		regions.pop_front();
+
+		// Regions kept alive by other owners can no longer be drawn
+		region->detachAtlas();
+		region->removeOwner(this);
+	}
+
+	for(unsigned int i = 0; i < pages.size(); i++){
+		if(pages[i]->texture != NULL) SDL_DestroyTexture(pages[i]->texture);
+		delete pages[i];
+	}
+	pages.clear();
+}
+
+
+Texture *TextureAtlas::addImage(std::string path){
+	/**
+	 * Loads an image file and packs it into the atlas.
+	 *
+	 * @return the new region, or NULL if the image could not be loaded or does
+	 *         not fit on a page.
+	 */
+	SDL_Surface *surface = IMG_Load(path.c_str());
+	if(surface == NULL){
+		printf("Unable to load texture from \"%s\"\n", path.c_str());
+		return NULL;
+	}
+
+	Texture *region = addSurface(surface);
+	SDL_FreeSurface(surface);
+	return region;
+}
+
+
+Texture *TextureAtlas::addSurface(SDL_Surface *surface){
+	/**
+	 * Packs a copy of the provided surface into the atlas.  A new page is
+	 * started when none of the existing ones has room.
+	 *
+	 * @return the new region, or NULL if the surface does not fit on a page.
+	 */
+	if(surface == NULL) return NULL;
+
+	int w = surface->w + ATLAS_PADDING;
+	int h = surface->h + ATLAS_PADDING;
+	if(w > pageWidth || h > pageHeight){
+		printf("Image of size %dx%d does not fit in a %dx%d atlas page.\n",
+			surface->w, surface->h, pageWidth, pageHeight);
+		return NULL;
+	}
+
+	SDL_Rect slot;
+	Page *page = NULL;
+	for(unsigned int i = 0; i < pages.size() && page == NULL; i++){
+		if(pages[i]->packer.insert(w, h, slot)) page = pages[i];
+	}
+	if(page == NULL){
+		page = createPage();
+		if(page == NULL) return NULL;
+		page->packer.insert(w, h, slot);
+	}
+
+	SDL_Surface *converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA8888, 0);
+	if(converted == NULL){
+		printf("Unable to convert image for atlas: %s\n", SDL_GetError());
+		return NULL;
+	}
+
+	SDL_Rect rect;
+	rect.x = slot.x;
+	rect.y = slot.y;
+	rect.w = surface->w;
+	rect.h = surface->h;
+
+	if(SDL_MUSTLOCK(converted)) SDL_LockSurface(converted);
+	SDL_UpdateTexture(page->texture, &rect, converted->pixels, converted->pitch);
+	if(SDL_MUSTLOCK(converted)) SDL_UnlockSurface(converted);
+	SDL_FreeSurface(converted);
+
+	AtlasRegion *region = new AtlasRegion(this, page->texture, rect);
+	region->load();
+	region->addOwner(this);
+	regions.push_back(region);
+	return region;
+}
+
+
+TextureAtlas::Page *TextureAtlas::createPage(){
+	SDL_Renderer *renderer = window->getRenderer();
+	if(renderer == NULL){
+		printf("Cannot create atlas page; Window has no active renderer.\n");
+		return NULL;
+	}
+
+	SDL_Texture *texture = SDL_CreateTexture(
+		renderer,
+		SDL_PIXELFORMAT_RGBA8888,
+		SDL_TEXTUREACCESS_STATIC,
+		pageWidth,
+		pageHeight
+	);
+	if(texture == NULL){
+		printf("Cannot create atlas page: %s\n", SDL_GetError());
+		return NULL;
+	}
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+	// Static textures start out undefined; the padding must be transparent.
+	std::vector<Uint32> blank((size_t) pageWidth * pageHeight, 0);
+	SDL_UpdateTexture(texture, NULL, &blank[0], pageWidth * sizeof(Uint32));
+
+	Page *page = new Page(pageWidth, pageHeight);
+	page->texture = texture;
+	pages.push_back(page);
+	return page;
+}
+
+
+void TextureAtlas::removeTextureReference(Texture *texture){
+	regions.remove((AtlasRegion*) texture);
+}
+
+
+int TextureAtlas::getPageCount() const {return pages.size();}
+
+int TextureAtlas::getRegionCount() const {return regions.size();}
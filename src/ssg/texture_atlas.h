@@ -0,0 +1,130 @@
+/*
+ * Declarations for runtime texture atlases.
+ *
+ * A TextureAtlas packs many small images into a few large pages, each of which
+ * is a single SDL_Texture.  Every packed image is exposed as an AtlasRegion,
+ * which is an ordinary Texture (it can be given to sprites, buttons, etc.) that
+ * draws only its own sub-rectangle of the page.  Sprites sharing a page share a
+ * texture, which saves per-texture overhead and lets the renderer batch them.
+ *
+ * Notes about memory management:
+ * 1) The atlas owns its regions, in the sense of texture.h.  Deleting the atlas
+ *    releases them; regions without other owners are deleted.
+ * 2) Regions which outlive their atlas lose their page, and stay unloaded.
+ * 3) Space freed by deleting a region is not reused; the skyline packer only
+ *    ever grows.  Atlases are meant for sets of images loaded together.
+ */
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include <string>
+#include <list>
+#include <vector>
+
+#include "shared_exports.h"
+#include "sdl.h"
+#include "texture.h"
+
+
+namespace ssg {
+
+	class Window;
+	class TextureAtlas;
+
+
+
+	/*
+	 * Skyline bin packer.  The used area of the bin is described by its upper
+	 * outline (the skyline); new rectangles are placed bottom-left, at the
+	 * position which keeps the skyline lowest.
+	 */
+	class SHARED_EXPORT SkylinePacker {
+	public:
+		const int width, height;
+
+		SkylinePacker(int w, int h);
+
+		bool insert(int w, int h, SDL_Rect &out);
+		void clear();
+
+		float getOccupancy() const;
+
+	private:
+		struct Segment {
+			int x, y, width;
+		};
+		std::vector<Segment> skyline;
+		long usedArea;
+
+		int findHeight(int index, int w) const;
+		void addSegment(int index, int x, int y, int w, int h);
+	};
+
+
+
+	class SHARED_EXPORT AtlasRegion : public Texture {
+	friend class TextureAtlas;
+	public:
+		virtual ~AtlasRegion();
+
+		virtual bool load();
+		virtual void unload();
+
+		virtual const SDL_Rect *getSourceRect() const;
+		virtual size_t getByteSize() const;
+
+		TextureAtlas *getAtlas() const;
+
+	protected:
+		AtlasRegion(TextureAtlas *atlas, SDL_Texture *page, SDL_Rect rect);
+
+	private:
+		TextureAtlas *atlas;
+		SDL_Texture *pageTexture;
+		SDL_Rect sourceRect;
+
+		void detachAtlas();
+	};
+
+
+
+	class SHARED_EXPORT TextureAtlas : public TextureOwner {
+	public:
+		static TextureAtlas *createTextureAtlas(
+			Window *win,
+			int pageWidth = 1024,
+			int pageHeight = 1024
+		);
+
+		Window* const window;
+		const int pageWidth, pageHeight;
+
+		virtual ~TextureAtlas();
+
+		Texture *addImage(std::string path);
+		Texture *addSurface(SDL_Surface *surface);
+
+		int getPageCount() const;
+		int getRegionCount() const;
+
+	protected:
+		virtual void removeTextureReference(Texture *texture);
+
+	private:
+		struct Page {
+			SDL_Texture *texture;
+			SkylinePacker packer;
+
+			Page(int w, int h): texture(NULL), packer(w, h) {};
+		};
+
+		std::vector<Page*> pages;
+		std::list<AtlasRegion*> regions;
+
+		TextureAtlas(Window *win, int w, int h);
+		Page *createPage();
+	};
+
+}
+
+#endif
@@ -0,0 +1,293 @@
+/*
+ * Source for asynchronous texture loading
+ */
+#include <cstdio>
+#include <algorithm>
+#include <string>
+
+#include "sdl.h"
+#include "window.h"
+#include "texture.h"
+#include "texture_loader.h"
+#include "alpha_mask.h"
+
+using namespace ssg;
+
+
+// Minimum alpha value for a texel to count as opaque in alpha masks
+static const Uint8 ALPHA_MASK_THRESHOLD = 0x80;
+
+
+
+/*
+ * Constructors and Destructors
+ */
+
+TextureLoader::TextureLoader(Window *win, int threadCount):
+	window(win),
+	pixelFormat(win->getFormat()->format),
+	decoding(0),
+	stopping(false)
+{
+	if(threadCount < 1) threadCount = 1;
+	for(int i = 0; i < threadCount; i++){
+		workers.push_back(std::thread(&TextureLoader::work, this));
+	}
+}
+
+
+TextureLoader::~TextureLoader(){
+	/*
+	 * Stops the workers.  Loads which have not finished are dropped, and their
+	 * textures simply stay unloaded.
+	 */
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	jobAvailable.notify_all();
+	for(unsigned int i = 0; i < workers.size(); i++) workers[i].join();
+	workers.clear();
+
+	for(unsigned int i = 0; i < active.size(); i++){
+		Job *job = active[i];
+		if(job->texture != NULL) job->texture->pending = false;
+		discard(job);
+	}
+	active.clear();
+	queued.clear();
+	decoded.clear();
+}
+
+
+
+/*
+ * Main Thread Methods
+ */
+
+void TextureLoader::request(TextureImage *texture, TextureLoadCallback *callback){
+	/**
+	 * Internal Method: Queues the image of the provided texture for decoding.
+	 */
+	Job *job = new Job();
+	job->texture = texture;
+	job->callback = callback;
+	job->path = texture->filePath;
+	job->buildAlphaMask = texture->alphaMaskEnabled;
+	job->surface = NULL;
+	job->alphaMask = NULL;
+
+	texture->pending = true;
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		active.push_back(job);
+		queued.push_back(job);
+	}
+	jobAvailable.notify_one();
+}
+
+
+void TextureLoader::cancel(TextureImage *texture){
+	/**
+	 * Internal Method: Forgets the load of the provided texture, which is about
+	 * to be deleted.  Its callback is not run.
+	 */
+	std::lock_guard<std::mutex> guard(lock);
+	for(unsigned int i = 0; i < active.size(); i++){
+		Job *job = active[i];
+		if(job->texture != texture) continue;
+
+		job->texture = NULL;
+		job->callback = NULL;
+
+		// Jobs still waiting for a worker can go at once; others are dropped
+		// when they come back.
+		auto position = std::find(queued.begin(), queued.end(), job);
+		if(position != queued.end()){
+			queued.erase(position);
+			active.erase(active.begin() + i);
+			discard(job);
+		}
+		return;
+	}
+}
+
+
+int TextureLoader::processUploads(size_t byteBudget){
+	/**
+	 * Internal Method: Uploads decoded images to the renderer, until the
+	 * provided number of bytes has been uploaded.  At least one image is always
+	 * uploaded if any are ready, so that large images cannot stall forever.
+	 *
+	 * @return the number of loads completed.
+	 */
+	size_t bytes = 0;
+	int count = 0;
+	while(count == 0 || bytes < byteBudget){
+		Job *job;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			if(decoded.empty()) break;
+			job = decoded.front();
+			decoded.pop_front();
+			active.erase(std::find(active.begin(), active.end(), job));
+		}
+
+		if(job->surface != NULL){
+			bytes += (size_t) job->surface->pitch * job->surface->h;
+		}
+		finish(job);
+		count++;
+	}
+	return count;
+}
+
+
+void TextureLoader::waitAll(){
+	/**
+	 * Blocks until every requested load has completed, running all of their
+	 * callbacks.  The per-frame upload budget does not apply.
+	 */
+	while(true){
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			jobDecoded.wait(guard, [this]{
+				return !decoded.empty() || (queued.empty() && decoding == 0);
+			});
+			if(decoded.empty()) return;
+		}
+		processUploads((size_t) -1);
+	}
+}
+
+
+int TextureLoader::getPendingCount() const {
+	std::lock_guard<std::mutex> guard(lock);
+	return active.size();
+}
+
+
+void TextureLoader::finish(Job *job){
+	TextureImage *texture = job->texture;
+	TextureLoadCallback *callback = job->callback;
+	if(texture == NULL){
+		discard(job);
+		return;
+	}
+
+	texture->pending = false;
+	if(texture->alphaMask == NULL){
+		texture->alphaMask = job->alphaMask;
+		job->alphaMask = NULL;
+	}
+
+	// The texture may have been loaded synchronously in the meantime
+	bool success = texture->isLoaded();
+	if(!success){
+		if(job->surface != NULL){
+			success = texture->uploadSurface(job->surface);
+		}else{
+			printf("Unable to load texture from \"%s\"\n", job->path.c_str());
+		}
+	}
+	discard(job);
+
+	// The callback may well delete the texture, so it must come last.
+	if(callback != NULL) callback->callback(texture, success);
+}
+
+
+void TextureLoader::discard(Job *job){
+	if(job->surface != NULL) SDL_FreeSurface(job->surface);
+	if(job->alphaMask != NULL) delete job->alphaMask;
+	delete job;
+}
+
+
+
+/*
+ * Worker Thread Methods
+ */
+
+void TextureLoader::work(){
+	while(true){
+		Job *job;
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			jobAvailable.wait(guard, [this]{return stopping || !queued.empty();});
+			if(stopping) return;
+			job = queued.front();
+			queued.pop_front();
+			decoding++;
+		}
+
+		decode(job);
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			decoded.push_back(job);
+			decoding--;
+		}
+		jobDecoded.notify_all();
+	}
+}
+
+
+void TextureLoader::decode(Job *job){
+	/*
+	 * Decodes the image and converts it to the window's pixel format, so that
+	 * the main thread only has to upload it.  Only the path and the results of
+	 * the job are touched here.
+	 */
+	SDL_Surface *loadedImage = IMG_Load(job->path.c_str());
+	if(loadedImage == NULL) return;
+
+	if(job->buildAlphaMask){
+		job->alphaMask = AlphaMask::createFromSurface(loadedImage, ALPHA_MASK_THRESHOLD);
+	}
+
+	job->surface = SDL_ConvertSurfaceFormat(loadedImage, pixelFormat, 0);
+	SDL_FreeSurface(loadedImage);
+}
+
+
+
+/*
+ * Image Headers
+ */
+
+static Uint32 read_big_endian_32(const unsigned char *bytes){
+	return ((Uint32) bytes[0] << 24) | ((Uint32) bytes[1] << 16)
+		| ((Uint32) bytes[2] << 8) | (Uint32) bytes[3];
+}
+
+
+bool ssg::read_png_size(std::string path, int &w, int &h){
+	/**
+	 * Reads the dimensions of a PNG image from its IHDR chunk, which always
+	 * directly follows the 8 byte signature.
+	 *
+	 * @return false if the file cannot be read or is not a PNG.
+	 */
+	static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+	FILE *file = fopen(path.c_str(), "rb");
+	if(file == NULL) return false;
+
+	unsigned char header[24];
+	size_t count = fread(header, 1, sizeof(header), file);
+	fclose(file);
+	if(count != sizeof(header)) return false;
+
+	if(!std::equal(signature, signature + 8, header)) return false;
+	if(!std::equal(header + 12, header + 16, (const unsigned char*) "IHDR")) return false;
+
+	Uint32 width = read_big_endian_32(header + 16);
+	Uint32 height = read_big_endian_32(header + 20);
+	if(width < 1 || height < 1 || width > 0x7fffffff || height > 0x7fffffff) return false;
+
+	w = width;
+	h = height;
+	return true;
+}
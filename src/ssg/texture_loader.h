@@ -0,0 +1,101 @@
+/*
+ * Declarations for asynchronous texture loading.
+ *
+ * Every Window has a TextureLoader with a small pool of worker threads.
+ * Texture::createFromFileAsync returns a TextureImage at once, in a "pending"
+ * state; its image is decoded and converted to the window's pixel format on a
+ * worker, and then uploaded to the renderer by the main thread during
+ * Window::update.  Uploads are limited to a number of bytes per frame, so that
+ * loading many images does not stall any single frame.
+ *
+ * Pending textures are simply not loaded yet, so they render as transparent
+ * rectangles, just like unloaded textures.  Deleting a pending texture cancels
+ * its load.
+ */
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "shared_exports.h"
+#include "sdl.h"
+
+
+namespace ssg {
+
+	class Window;
+	class Texture;
+	class TextureImage;
+	class AlphaMask;
+
+
+	/*
+	 * Abstract superclass of callbacks notified when an asynchronous load ends.
+	 * Callbacks are always run on the main thread.
+	 */
+	class SHARED_EXPORT TextureLoadCallback {
+	public:
+		virtual ~TextureLoadCallback(){};
+		virtual void callback(Texture *texture, bool success) = 0;
+	};
+
+
+
+	class SHARED_EXPORT TextureLoader {
+	public:
+		TextureLoader(Window *win, int threadCount);
+		~TextureLoader();
+
+		void waitAll();
+		int getPendingCount() const;
+
+	internal:
+		void request(TextureImage *texture, TextureLoadCallback *callback);
+		void cancel(TextureImage *texture);
+		int processUploads(size_t byteBudget);
+
+	private:
+		struct Job {
+			TextureImage *texture; // NULL once cancelled
+			TextureLoadCallback *callback;
+			std::string path;
+			bool buildAlphaMask;
+
+			// Results, filled in by a worker
+			SDL_Surface *surface;
+			AlphaMask *alphaMask;
+		};
+
+		Window *window;
+		Uint32 pixelFormat;
+
+		std::vector<std::thread> workers;
+		std::deque<Job*> queued, decoded;
+		std::vector<Job*> active;
+		int decoding;
+		bool stopping;
+
+		mutable std::mutex lock;
+		std::condition_variable jobAvailable, jobDecoded;
+
+		void work();
+		void decode(Job *job);
+		void finish(Job *job);
+		void discard(Job *job);
+	};
+
+
+
+	/*
+	 * Reads the dimensions of a PNG image from its header, without decoding it.
+	 */
+	bool read_png_size(std::string path, int &w, int &h);
+
+}
+
+#endif
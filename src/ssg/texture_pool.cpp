@@ -0,0 +1,164 @@
+/*
+ * Source for pooling of SDL textures
+ */
+#include <cstdio>
+#include <list>
+
+#include "sdl.h"
+#include "texture_pool.h"
+
+using namespace ssg;
+
+
+// Default number of bytes of idle textures kept for reuse
+static const size_t DEFAULT_POOL_CAPACITY = 4 * 1024 * 1024;
+
+// Texture sizes are rounded up to multiples of this
+static const int POOL_SIZE_CLASS = 32;
+
+
+
+/*
+ * Constructors and Destructors
+ */
+
+TexturePool::TexturePool():
+	capacity(DEFAULT_POOL_CAPACITY),
+	idleBytes(0),
+	reuseCount(0)
+{}
+
+
+TexturePool::~TexturePool(){
+	clear();
+}
+
+
+void TexturePool::clear(){
+	/**
+	 * Frees all idle textures.  Must be called before the renderer which
+	 * created them is destroyed.
+	 */
+	trim(0);
+}
+
+
+
+/*
+ * Capacity
+ */
+
+void TexturePool::setCapacity(size_t bytes){
+	capacity = bytes;
+	trim(capacity);
+}
+
+
+size_t TexturePool::getCapacity() const {return capacity;}
+
+size_t TexturePool::getIdleBytes() const {return idleBytes;}
+
+int TexturePool::getIdleCount() const {return idle.size();}
+
+int TexturePool::getReuseCount() const {return reuseCount;}
+
+
+void TexturePool::trim(size_t bytes){
+	/**
+	 * Frees the least recently released idle textures, until at most the
+	 * provided number of bytes of them are left.
+	 */
+	while(idleBytes > bytes && !idle.empty()){
+		Entry &entry = idle.back();
+		SDL_DestroyTexture(entry.texture);
+		idleBytes -= entry.bytes;
+		idle.pop_back();
+	}
+}
+
+
+int TexturePool::roundSize(int size){
+	/**
+	 * @return the size of the size class of the provided texture dimension.
+	 */
+	if(size < 1) return POOL_SIZE_CLASS;
+	return (size + POOL_SIZE_CLASS - 1) / POOL_SIZE_CLASS * POOL_SIZE_CLASS;
+}
+
+
+
+/*
+ * Pooling
+ */
+
+SDL_Texture *TexturePool::acquire(
+	SDL_Renderer *renderer,
+	int w,
+	int h,
+	Uint32 format,
+	int access
+){
+	/**
+	 * Internal Method: Takes a texture of at least w by h pixels out of the
+	 * pool, or creates one if no idle texture of that size class fits.  Its
+	 * contents are undefined.
+	 *
+	 * @return the texture, which must be given back with release, or NULL if
+	 *         it could not be created.
+	 */
+	int roundedW = roundSize(w);
+	int roundedH = roundSize(h);
+
+	std::list<Entry>::iterator entry;
+	for(entry = idle.begin(); entry != idle.end(); entry++){
+		if(
+			entry->w == roundedW &&
+			entry->h == roundedH &&
+			entry->format == format &&
+			entry->access == access
+		){
+			SDL_Texture *texture = entry->texture;
+			idleBytes -= entry->bytes;
+			idle.erase(entry);
+			reuseCount++;
+			
+			// Undo any modulation left by the previous user
+			SDL_SetTextureColorMod(texture, 0xff, 0xff, 0xff);
+			SDL_SetTextureAlphaMod(texture, 0xff);
+			return texture;
+		}
+	}
+
+	if(renderer == NULL) return NULL;
+	SDL_Texture *texture = SDL_CreateTexture(renderer, format, access, roundedW, roundedH);
+	if(texture == NULL){
+		printf("Cannot create pooled texture: %s\n", SDL_GetError());
+	}
+	return texture;
+}
+
+
+void TexturePool::release(SDL_Texture *texture){
+	/**
+	 * Internal Method: Gives a texture back to the pool.  Textures beyond the
+	 * pool's capacity are destroyed.
+	 */
+	if(texture == NULL) return;
+
+	Entry entry;
+	entry.texture = texture;
+	SDL_QueryTexture(texture, &entry.format, &entry.access, &entry.w, &entry.h);
+
+	int bytesPerPixel = SDL_BYTESPERPIXEL(entry.format);
+	if(bytesPerPixel < 1) bytesPerPixel = 4;
+	entry.bytes = (size_t) entry.w * entry.h * bytesPerPixel;
+
+	if(entry.bytes > capacity){
+		SDL_DestroyTexture(texture);
+		return;
+	}
+
+	idle.push_front(entry);
+	idleBytes += entry.bytes;
+	trim(capacity);
+}
@@ -0,0 +1,74 @@
+/*
+ * Declarations for pooling of SDL textures.
+ *
+ * Creating and destroying SDL textures goes through the graphics driver, and is
+ * expensive.  Textures whose contents are replaced often (above all text which
+ * changes every frame, like FPS counters) instead take their SDL texture from
+ * the window's TexturePool, and give it back when they are unloaded; the next
+ * texture of the same size class and format reuses it, and only has to upload
+ * its pixels.
+ *
+ * Sizes are rounded up to size classes, so that e.g. successive values of a
+ * counter fit the same texture.  Pooled textures are therefore often larger
+ * than their contents, and are drawn through a source rectangle.
+ *
+ * The pool keeps at most its capacity of idle textures, freeing the least
+ * recently released first.  Idle textures also count against the window's
+ * texture memory budget (see texture_residency.h), and are freed before any
+ * texture in use is evicted.
+ */
+#ifndef TEXTURE_POOL_H
+#define TEXTURE_POOL_H
+
+#include <list>
+
+#include "shared_exports.h"
+#include "sdl.h"
+
+
+namespace ssg {
+
+	class SHARED_EXPORT TexturePool {
+	public:
+		TexturePool();
+		~TexturePool();
+
+		void setCapacity(size_t bytes); // 0 disables pooling
+		size_t getCapacity() const;
+
+		size_t getIdleBytes() const;
+		int getIdleCount() const;
+		int getReuseCount() const;
+
+		void trim(size_t bytes);
+		void clear();
+
+		static int roundSize(int size);
+
+	internal:
+		SDL_Texture *acquire(
+			SDL_Renderer *renderer,
+			int w,
+			int h,
+			Uint32 format,
+			int access
+		);
+		void release(SDL_Texture *texture);
+
+	private:
+		struct Entry {
+			SDL_Texture *texture;
+			Uint32 format;
+			int access, w, h;
+			size_t bytes;
+		};
+		std::list<Entry> idle; // Most recently released first
+
+		size_t capacity;
+		size_t idleBytes;
+		int reuseCount;
+	};
+
+}
+
+#endif
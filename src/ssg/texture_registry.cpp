@@ -0,0 +1,159 @@
+/*
+ * Source for the per-window texture registry
+ */
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+#include "sdl.h"
+#include "texture.h"
+#include "texture_registry.h"
+
+using namespace ssg;
+
+
+/*
+ * Constructors and Destructors
+ */
+
+TextureRegistry::TextureRegistry():
+	sharingEnabled(false),
+	contentHashing(false)
+{}
+
+
+TextureRegistry::~TextureRegistry(){
+	clear();
+}
+
+
+void TextureRegistry::clear(){
+	/**
+	 * Forgets all registered textures.  The textures themselves are untouched,
+	 * but will no longer be shared.
+	 */
+	for(const auto &entry : keys){
+		entry.first->registry = NULL;
+	}
+	keys.clear();
+	textures.clear();
+}
+
+
+int TextureRegistry::getTextureCount() const {
+	return keys.size();
+}
+
+
+
+/*
+ * Lookup
+ */
+
+Texture *TextureRegistry::find(const std::string &key) const {
+	/**
+	 * Internal Method: @return the texture registered under the provided key, or
+	 * NULL if there is none.
+	 */
+	if(key.empty()) return NULL;
+	auto entry = textures.find(key);
+	if(entry == textures.end()) return NULL;
+	return entry->second;
+}
+
+
+void TextureRegistry::add(const std::string &key, Texture *texture){
+	/**
+	 * Internal Method: Registers a texture under the provided key.  A texture
+	 * may have several keys, but only one registry.
+	 */
+	if(key.empty() || texture == NULL) return;
+	if(texture->registry != NULL && texture->registry != this) return;
+	if(textures.find(key) != textures.end()) return;
+
+	textures[key] = texture;
+	keys[texture].push_back(key);
+	texture->registry = this;
+}
+
+
+void TextureRegistry::remove(Texture *texture){
+	/**
+	 * Internal Method: Forgets the provided texture; called when it is deleted.
+	 */
+	auto entry = keys.find(texture);
+	if(entry == keys.end()) return;
+
+	for(unsigned int i = 0; i < entry->second.size(); i++){
+		textures.erase(entry->second[i]);
+	}
+	keys.erase(entry);
+	texture->registry = NULL;
+}
+
+
+
+/*
+ * Keys
+ */
+
+static std::string color_string(Uint8 r, Uint8 g, Uint8 b, Uint8 a){
+	char buffer[16];
+	snprintf(buffer, sizeof(buffer), "%02x%02x%02x%02x", r, g, b, a);
+	return buffer;
+}
+
+
+std::string TextureRegistry::solidKey(int w, int h, Uint8 r, Uint8 g, Uint8 b, Uint8 a){
+	return "solid:" + std::to_string(w) + "x" + std::to_string(h) + ":"
+		+ color_string(r, g, b, a);
+}
+
+
+std::string TextureRegistry::textKey(std::string text, std::string font, int size,
+                                     Uint8 r, Uint8 g, Uint8 b, Uint8 a){
+	// The text goes last, so that no choice of text can mimic another key
+	return "text:" + std::to_string(size) + ":" + color_string(r, g, b, a) + ":"
+		+ std::to_string(font.size()) + ":" + font + ":" + text;
+}
+
+
+std::string TextureRegistry::fileKey(std::string path, bool alphaMask){
+	/**
+	 * @return the key of an image file, which includes its modification time so
+	 *         that edited files are loaded anew; empty if the file is missing.
+	 */
+	struct stat info;
+	if(stat(path.c_str(), &info) != 0) return "";
+	return std::string("file:") + (alphaMask ? "m:" : "-:")
+		+ std::to_string((long long) info.st_mtime) + ":" + path;
+}
+
+
+std::string TextureRegistry::contentKey(std::string path, bool alphaMask){
+	/**
+	 * @return a key made from a 64-bit FNV-1a hash of the contents of an image
+	 *         file; empty if the file cannot be read.
+	 */
+	FILE *file = fopen(path.c_str(), "rb");
+	if(file == NULL) return "";
+
+	Uint64 hash = 0xcbf29ce484222325ULL;
+	Uint64 length = 0;
+	unsigned char buffer[4096];
+	size_t count;
+	while((count = fread(buffer, 1, sizeof(buffer), file)) > 0){
+		for(size_t i = 0; i < count; i++){
+			hash ^= buffer[i];
+			hash *= 0x100000001b3ULL;
+		}
+		length += count;
+	}
+	fclose(file);
+
+	char key[64];
+	snprintf(key, sizeof(key), "content:%s:%016llx:%llu", alphaMask ? "m" : "-",
+		(unsigned long long) hash, (unsigned long long) length);
+	return key;
+}
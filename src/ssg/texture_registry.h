@@ -0,0 +1,63 @@
+/*
+ * Declarations for the per-window texture registry.
+ *
+ * When sharing is enabled on a window's registry, the Texture factory methods
+ * return an existing texture instead of creating a new one whenever they are
+ * asked for the same source again:
+ *  - images, by path and file modification time;
+ *  - text, by string, font, size and color;
+ *  - solid colors, by size and color.
+ * Optionally, images are also matched by a hash of their file contents, so
+ * that copies of the same file under different paths share one texture.
+ *
+ * Shared textures are reference counted by their owners, as usual (see
+ * texture.h): a shared texture is freed once no owner uses it anymore, and is
+ * then forgotten by the registry.  Note that deleting or unloading a shared
+ * texture manually affects every one of its users.
+ */
+#ifndef TEXTURE_REGISTRY_H
+#define TEXTURE_REGISTRY_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "shared_exports.h"
+#include "sdl.h"
+
+
+namespace ssg {
+
+	class Texture;
+
+
+	class SHARED_EXPORT TextureRegistry {
+	public:
+		bool sharingEnabled;
+		bool contentHashing; // Only used if sharing is enabled
+
+		TextureRegistry();
+		~TextureRegistry();
+
+		int getTextureCount() const;
+		void clear();
+
+	internal:
+		Texture *find(const std::string &key) const;
+		void add(const std::string &key, Texture *texture);
+		void remove(Texture *texture);
+
+		static std::string solidKey(int w, int h, Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+		static std::string textKey(std::string text, std::string font, int size,
+		                           Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+		static std::string fileKey(std::string path, bool alphaMask);
+		static std::string contentKey(std::string path, bool alphaMask);
+
+	private:
+		std::unordered_map<std::string, Texture*> textures;
+		std::unordered_map<Texture*, std::vector<std::string> > keys;
+	};
+
+}
+
+#endif
@@ -0,0 +1,169 @@
+/*
+ * Source for texture residency management
+ */
+#include <cstdio>
+#include <list>
+
+#include "sdl.h"
+#include "texture.h"
+#include "texture_residency.h"
+
+using namespace ssg;
+
+
+/*
+ * Constructors and Destructors
+ */
+
+ResidencyManager::ResidencyManager():
+	budget(0),
+	residentBytes(0),
+	frame(0),
+	evictionCount(0)
+{}
+
+
+ResidencyManager::~ResidencyManager(){
+	clear();
+}
+
+
+void ResidencyManager::clear(){
+	/**
+	 * Stops tracking all textures.  Evicted textures stay unloaded.
+	 */
+	while(!residents.empty()){
+		untrack(residents.front());
+	}
+}
+
+
+
+/*
+ * Budget
+ */
+
+void ResidencyManager::setBudget(size_t bytes){
+	/**
+	 * Sets the number of bytes of drawn textures to keep loaded.  A budget of 0
+	 * disables residency management altogether.
+	 */
+	budget = bytes;
+	if(budget == 0) clear();
+}
+
+
+size_t ResidencyManager::getBudget() const {return budget;}
+
+size_t ResidencyManager::getResidentBytes() const {return residentBytes;}
+
+int ResidencyManager::getResidentCount() const {return residents.size();}
+
+int ResidencyManager::getEvictionCount() const {return evictionCount;}
+
+
+
+/*
+ * Tracking
+ */
+
+void ResidencyManager::touch(const Texture *tex){
+	/**
+	 * Internal Method: Records that the provided texture was drawn (or is about
+	 * to be) in the current frame.
+	 */
+	if(budget == 0 || tex == NULL) return;
+	Texture *texture = const_cast<Texture*>(tex);
+	texture->lastUsedFrame = frame;
+
+	if(texture->residency == this){
+		residents.splice(residents.begin(), residents, texture->residencyEntry);
+		return;
+	}
+	if(texture->residency != NULL || !texture->isLoaded()) return;
+
+	size_t bytes = texture->getByteSize();
+	if(bytes == 0) return; // Shares its memory, e.g. an atlas region
+
+	residents.push_front(texture);
+	texture->residencyEntry = residents.begin();
+	texture->residency = this;
+	texture->residencyBytes = bytes;
+	residentBytes += bytes;
+}
+
+
+void ResidencyManager::prefetch(Texture *texture){
+	/**
+	 * Internal Method: Called for textures of sprites which are just offscreen
+	 * and may soon become visible.
+	 */
+	if(texture == NULL) return;
+	if(texture->isLoaded()){
+		touch(texture);
+	}else{
+		request(texture);
+	}
+}
+
+
+void ResidencyManager::request(Texture *texture){
+	/**
+	 * Internal Method: Called for textures which should be drawn but are not
+	 * loaded.  Textures evicted by the manager are reloaded; textures unloaded
+	 * by the user are left alone.
+	 */
+	if(texture == NULL || !texture->evicted || texture->isPending()) return;
+
+	texture->evicted = false;
+	texture->requestLoad();
+}
+
+
+void ResidencyManager::remove(Texture *texture){
+	/**
+	 * Internal Method: Forgets the provided texture; called when it is deleted.
+	 */
+	if(texture->residency == this) untrack(texture);
+}
+
+
+void ResidencyManager::untrack(Texture *texture){
+	residents.erase(texture->residencyEntry);
+	texture->residency = NULL;
+	residentBytes -= texture->residencyBytes;
+	texture->residencyBytes = 0;
+}
+
+
+
+/*
+ * Eviction
+ */
+
+void ResidencyManager::endFrame(){
+	/**
+	 * Internal Method: Evicts the least recently drawn textures until the budget
+	 * is met, or until only textures drawn this frame are left.
+	 */
+	if(budget != 0){
+		while(residentBytes > budget && !residents.empty()){
+			Texture *texture = residents.back();
+			if(texture->lastUsedFrame == frame) break;
+			evict(texture);
+		}
+	}
+	frame++;
+}
+
+
+void ResidencyManager::evict(Texture *texture){
+	untrack(texture);
+
+	// Textures unloaded by the user in the meantime are simply dropped
+	if(!texture->isLoaded()) return;
+
+	texture->unload();
+	texture->evicted = true;
+	evictionCount++;
+}
@@ -0,0 +1,69 @@
+/*
+ * Declarations for texture residency management.
+ *
+ * Every Window has a ResidencyManager, which is disabled until it is given a
+ * byte budget.  Once enabled, it keeps track of which textures have been drawn
+ * recently, and when the textures drawn exceed the budget, it unloads the least
+ * recently drawn ones at the end of the frame.  Textures unloaded this way are
+ * "evicted": unlike textures unloaded by the user, they are loaded again as
+ * soon as a sprite wants to draw them (image textures asynchronously, see
+ * texture_loader.h; others at once).
+ *
+ * Textures near the edge of the screen, in the direction in which the viewport
+ * is moving, are prefetched: kept resident, or reloaded if evicted, before they
+ * become visible.
+ *
+ * Textures are never evicted in the frame in which they were drawn, so the
+ * budget is a target rather than a hard limit.
+ */
+#ifndef TEXTURE_RESIDENCY_H
+#define TEXTURE_RESIDENCY_H
+
+#include <list>
+
+#include "shared_exports.h"
+#include "sdl.h"
+
+
+namespace ssg {
+
+	class Texture;
+
+
+	class SHARED_EXPORT ResidencyManager {
+	public:
+		ResidencyManager();
+		~ResidencyManager();
+
+		void setBudget(size_t bytes); // 0 disables eviction
+		size_t getBudget() const;
+
+		size_t getResidentBytes() const;
+		int getResidentCount() const;
+		int getEvictionCount() const;
+
+		void clear();
+
+	internal:
+		void touch(const Texture *texture);
+		void prefetch(Texture *texture);
+		void request(Texture *texture);
+		void remove(Texture *texture);
+		void endFrame();
+
+	private:
+		size_t budget;
+		size_t residentBytes;
+		Uint64 frame;
+		int evictionCount;
+
+		// Most recently drawn textures first
+		std::list<Texture*> residents;
+
+		void evict(Texture *texture);
+		void untrack(Texture *texture);
+	};
+
+}
+
+#endif
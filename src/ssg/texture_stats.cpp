@@ -0,0 +1,293 @@
+/*
+ * Source for texture memory accounting
+ */
+#include <cstdio>
+#include <algorithm>
+#include <string>
+#include <list>
+#include <vector>
+
+#include "sdl.h"
+#include "texture.h"
+#include "texture_stats.h"
+
+using namespace ssg;
+
+
+// Textures destroyed within this many frames of their creation are short-lived
+static const Uint64 SHORT_LIVED_FRAMES = 2;
+
+// Frames in a row with short-lived textures before a warning is printed
+static const int CHURN_WARNING_FRAMES = 30;
+
+
+Texture *TextureStats::firstTexture = NULL;
+int TextureStats::textureCount = 0;
+size_t TextureStats::glyphPageBytes = 0;
+std::unordered_map<const Window*, TextureStats::FrameCounts> TextureStats::frames;
+
+
+
+/*
+ * Registration
+ */
+
+void TextureStats::textureCreated(Texture *texture){
+	/**
+	 * Internal Method: Adds a new texture to the registry.
+	 */
+	texture->statsPrevious = NULL;
+	texture->statsNext = firstTexture;
+	if(firstTexture != NULL) firstTexture->statsPrevious = texture;
+	firstTexture = texture;
+	texture->createdFrame = getFrameCounts(texture->window).frame;
+	textureCount++;
+}
+
+
+void TextureStats::textureDestroyed(Texture *texture){
+	/**
+	 * Internal Method: Removes a texture which is being deleted.
+	 */
+	if(texture->statsPrevious != NULL){
+		texture->statsPrevious->statsNext = texture->statsNext;
+	}else{
+		firstTexture = texture->statsNext;
+	}
+	if(texture->statsNext != NULL){
+		texture->statsNext->statsPrevious = texture->statsPrevious;
+	}
+	textureCount--;
+
+	// Textures outliving their window are no longer counted
+	std::unordered_map<const Window*, FrameCounts>::iterator entry = frames.find(texture->window);
+	if(entry == frames.end()) return;
+
+	FrameCounts &counts = entry->second;
+	if(counts.frame - texture->createdFrame < SHORT_LIVED_FRAMES){
+		counts.shortLivedThisFrame++;
+		counts.churnKind = texture->getKind();
+	}
+}
+
+
+void TextureStats::frameEnded(const Window *window){
+	/**
+	 * Internal Method: Called by every window at the end of each of its frames.
+	 */
+	FrameCounts &counts = getFrameCounts(window);
+	if(counts.shortLivedThisFrame > 0){
+		counts.churnFrames++;
+		if(counts.churnFrames == CHURN_WARNING_FRAMES){
+			printf("[Warning] %s textures are being created and destroyed every frame ", counts.churnKind.c_str());
+			printf("(%d in the last frame).  Consider reusing them.\n", counts.shortLivedThisFrame);
+		}
+	}else{
+		counts.churnFrames = 0;
+	}
+
+	counts.shortLivedLastFrame = counts.shortLivedThisFrame;
+	counts.shortLivedThisFrame = 0;
+	counts.frame++;
+}
+
+
+void TextureStats::windowDestroyed(const Window *window){
+	/**
+	 * Internal Method: Forgets the frames of a window which is being deleted.
+	 */
+	frames.erase(window);
+}
+
+
+TextureStats::FrameCounts &TextureStats::getFrameCounts(const Window *window){
+	std::unordered_map<const Window*, FrameCounts>::iterator entry = frames.find(window);
+	if(entry != frames.end()) return entry->second;
+
+	FrameCounts counts;
+	counts.frame = 0;
+	counts.shortLivedThisFrame = 0;
+	counts.shortLivedLastFrame = 0;
+	counts.churnFrames = 0;
+	counts.churnKind = "";
+	return frames[window] = counts;
+}
+
+
+int TextureStats::getShortLivedCount(){
+	/**
+	 * @return the number of textures destroyed during the last frame (of their
+	 *         window) within two frames of their creation, over all windows.
+	 */
+	int total = 0;
+	std::unordered_map<const Window*, FrameCounts>::iterator entry;
+	for(entry = frames.begin(); entry != frames.end(); entry++){
+		total += entry->second.shortLivedLastFrame;
+	}
+	return total;
+}
+
+
+int TextureStats::getShortLivedCount(const Window *window){
+	/**
+	 * @return the number of short-lived textures of one window, as above.
+	 */
+	std::unordered_map<const Window*, FrameCounts>::iterator entry = frames.find(window);
+	if(entry == frames.end()) return 0;
+	return entry->second.shortLivedLastFrame;
+}
+
+
+
+/*
+ * Totals
+ */
+
+int TextureStats::getTextureCount(){return textureCount;}
+
+
+size_t TextureStats::getGlyphPageBytes(){
+	/**
+	 * @return the memory used by the glyph pages of all windows.
+	 */
+	return glyphPageBytes;
+}
+
+
+void TextureStats::glyphPageCreated(size_t bytes){
+	/**
+	 * Internal Method: Counts a new glyph page.
+	 */
+	glyphPageBytes += bytes;
+}
+
+
+void TextureStats::glyphPageDestroyed(size_t bytes){
+	/**
+	 * Internal Method: Stops counting a glyph page which has been freed.
+	 */
+	glyphPageBytes -= bytes;
+}
+
+
+size_t TextureStats::getLoadedBytes(){
+	size_t total = 0;
+	for(Texture *t = firstTexture; t != NULL; t = t->statsNext){
+		if(t->isLoaded()) total += t->getByteSize();
+	}
+	return total;
+}
+
+
+size_t TextureStats::getUnloadedBytes(){
+	size_t total = 0;
+	for(Texture *t = firstTexture; t != NULL; t = t->statsNext){
+		if(!t->isLoaded()) total += t->getByteSize();
+	}
+	return total;
+}
+
+
+std::list<TextureKindStats> TextureStats::getStatsByKind(){
+	/**
+	 * @return one entry for every kind of texture which currently exists.
+	 */
+	std::list<TextureKindStats> kinds;
+	for(Texture *t = firstTexture; t != NULL; t = t->statsNext){
+		std::string kind = t->getKind();
+
+		std::list<TextureKindStats>::iterator entry = kinds.begin();
+		while(entry != kinds.end() && entry->kind != kind) entry++;
+		if(entry == kinds.end()){
+			TextureKindStats stats;
+			stats.kind = kind;
+			stats.count = 0;
+			stats.loadedCount = 0;
+			stats.loadedBytes = 0;
+			stats.unloadedBytes = 0;
+			entry = kinds.insert(kinds.end(), stats);
+		}
+
+		entry->count++;
+		if(t->isLoaded()){
+			entry->loadedCount++;
+			entry->loadedBytes += t->getByteSize();
+		}else{
+			entry->unloadedBytes += t->getByteSize();
+		}
+	}
+	return kinds;
+}
+
+
+std::unordered_map<const TextureOwner*, size_t> TextureStats::getLoadedBytesByOwner(){
+	/**
+	 * @return the bytes of loaded textures held by every texture owner.  Shared
+	 *         textures count fully towards each of their owners.
+	 */
+	std::unordered_map<const TextureOwner*, size_t> owners;
+	for(Texture *t = firstTexture; t != NULL; t = t->statsNext){
+		if(!t->isLoaded()) continue;
+		size_t bytes = t->getByteSize();
+		
+		// Owners holding several handles to the texture count it once
+		std::vector<const TextureOwner*> counted;
+		for(TextureRef *ref = t->holders; ref != NULL; ref = ref->next){
+			const TextureOwner *owner = ref->owner;
+			if(owner == NULL) continue;
+			if(std::find(counted.begin(), counted.end(), owner) != counted.end()) continue;
+			counted.push_back(owner);
+			owners[owner] += bytes;
+		}
+	}
+	return owners;
+}
+
+
+
+/*
+ * Largest Textures
+ */
+
+static bool compare_byte_size(const Texture *a, const Texture *b){
+	return a->getByteSize() > b->getByteSize();
+}
+
+
+std::vector<Texture*> TextureStats::getLargestTextures(int n){
+	std::vector<Texture*> textures;
+	for(Texture *t = firstTexture; t != NULL; t = t->statsNext){
+		textures.push_back(t);
+	}
+
+	if(n < 0) n = 0;
+	if((size_t) n < textures.size()){
+		std::partial_sort(textures.begin(), textures.begin() + n, textures.end(), compare_byte_size);
+		textures.resize(n);
+	}else{
+		std::sort(textures.begin(), textures.end(), compare_byte_size);
+	}
+	return textures;
+}
+
+
+void TextureStats::printLargestTextures(int n){
+	/**
+	 * Prints the n largest textures, followed by the totals.
+	 */
+	std::vector<Texture*> textures = getLargestTextures(n);
+	for(unsigned int i = 0; i < textures.size(); i++){
+		Texture *t = textures[i];
+		printf("%10lu B  %-6s %5dx%-5d %-8s %s\n",
+			(unsigned long) t->getByteSize(),
+			t->getKind().c_str(),
+			t->width,
+			t->height,
+			t->isLoaded() ? "loaded" : "unloaded",
+			t->getDescription().c_str()
+		);
+	}
+	printf("%d textures: %lu B loaded, %lu B unloaded; %lu B of glyph pages\n", textureCount,
+		(unsigned long) getLoadedBytes(), (unsigned long) getUnloadedBytes(),
+		(unsigned long) glyphPageBytes);
+}
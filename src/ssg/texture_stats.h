@@ -0,0 +1,87 @@
+/*
+ * Declarations for texture memory accounting.
+ *
+ * Every Texture in the process is listed in a global registry, which can be
+ * queried for the memory used by textures: in total, by kind of texture
+ * (image, text, solid, region), by owner, and loaded vs. unloaded.  Unloaded
+ * textures are counted by the memory they would use if loaded.
+ *
+ * Glyph pages (see glyph_cache.h) are not Textures, and are counted apart.
+ *
+ * The registry also looks out for textures which only live for a frame or two,
+ * and prints a warning when this happens for many frames in a row.  This is
+ * almost always a texture being rebuilt every frame, e.g. a text sprite whose
+ * text changes every frame.  Frames are counted separately for every window,
+ * and a texture's lifetime is measured in frames of its own window, so that
+ * several windows do not disturb each other's counts.
+ */
+#ifndef TEXTURE_STATS_H
+#define TEXTURE_STATS_H
+
+#include <string>
+#include <list>
+#include <vector>
+#include <unordered_map>
+
+#include "shared_exports.h"
+#include "sdl.h"
+
+
+namespace ssg {
+
+	class Texture;
+	class TextureOwner;
+	class Window;
+
+
+	struct TextureKindStats {
+		std::string kind;
+		int count, loadedCount;
+		size_t loadedBytes, unloadedBytes;
+	};
+
+
+	class SHARED_EXPORT TextureStats {
+	public:
+		static int getTextureCount();
+		static size_t getLoadedBytes();
+		static size_t getUnloadedBytes();
+
+		static std::list<TextureKindStats> getStatsByKind();
+		static std::unordered_map<const TextureOwner*, size_t> getLoadedBytesByOwner();
+
+		static std::vector<Texture*> getLargestTextures(int n);
+		static void printLargestTextures(int n);
+
+		static size_t getGlyphPageBytes();
+
+		static int getShortLivedCount();
+		static int getShortLivedCount(const Window *window);
+
+	internal:
+		static void textureCreated(Texture *texture);
+		static void textureDestroyed(Texture *texture);
+		static void frameEnded(const Window *window);
+		static void windowDestroyed(const Window *window);
+		static void glyphPageCreated(size_t bytes);
+		static void glyphPageDestroyed(size_t bytes);
+
+	private:
+		struct FrameCounts {
+			Uint64 frame;
+			int shortLivedThisFrame, shortLivedLastFrame;
+			int churnFrames;
+			std::string churnKind;
+		};
+
+		static Texture *firstTexture;
+		static int textureCount;
+		static size_t glyphPageBytes;
+
+		static std::unordered_map<const Window*, FrameCounts> frames;
+		static FrameCounts &getFrameCounts(const Window *window);
+	};
+
+}
+
+#endif
@@ -8,6 +8,13 @@
 using namespace ssg;
 
 
+// How many frames of viewport motion to look ahead when prefetching textures
+static const float PREFETCH_FRAMES = 30.0f;
+
+// Margin (in viewport coordinates) prefetched all around the viewport
+static const float PREFETCH_MARGIN = 0.25f;
+
+
 /*
  * Source for Viewport2D
  */
@@ -17,7 +24,11 @@ Viewport2D::Viewport2D():
 	centerY(0.0f),
 	aspectPreserved(true),
 	aspectLocked(true),
-	scaleY(false)
+	scaleY(false),
+	lastCenterX(0.0f),
+	lastCenterY(0.0f),
+	motionX(0.0f),
+	motionY(0.0f)
 {
 	setRadii(1.0f, 1.0f);
 }
@@ -172,3 +183,39 @@ Rect2f Viewport2D::getViewportRect() const {
 }
 
 
+Rect2f Viewport2D::getPrefetchRect() const {
+	/**
+	 * @return the viewport rectangle (in viewport coordinates) grown by a small
+	 *         margin, and stretched in the direction in which the viewport has
+	 *         recently been moving.  Textures of sprites inside of it should be
+	 *         loaded soon.
+	 */
+	Rect2f prefetchRect = getViewportRect();
+	prefetchRect.xMin -= PREFETCH_MARGIN;
+	prefetchRect.xMax += PREFETCH_MARGIN;
+	prefetchRect.yMin -= PREFETCH_MARGIN;
+	prefetchRect.yMax += PREFETCH_MARGIN;
+	
+	float aheadX = motionX * inverseRadiusY * PREFETCH_FRAMES;
+	float aheadY = motionY * inverseRadiusY * PREFETCH_FRAMES;
+	if(aheadX > 0) prefetchRect.xMax += aheadX; else prefetchRect.xMin += aheadX;
+	if(aheadY > 0) prefetchRect.yMax += aheadY; else prefetchRect.yMin += aheadY;
+	
+	return prefetchRect;
+}
+
+
+void Viewport2D::trackMotion(){
+	/*
+	 * Called once per rendered frame by the owning layer.  The motion is
+	 * smoothed a little, so that a single jump does not dominate.
+	 */
+	float dx = centerX - lastCenterX;
+	float dy = centerY - lastCenterY;
+	motionX = 0.5f * (motionX + dx);
+	motionY = 0.5f * (motionY + dy);
+	lastCenterX = centerX;
+	lastCenterY = centerY;
+}
+
+
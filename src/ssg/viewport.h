@@ -53,9 +53,11 @@ namespace ssg {
 	
 		Rect2f getWorldRect() const;
 		Rect2f getViewportRect() const;
+		Rect2f getPrefetchRect() const;
 
 	protected:
 		void forceAspectRatio(float newRatio);
+		void trackMotion();
 	private:
 		float centerX, centerY;
 		float radiusX, radiusY;
@@ -65,6 +67,10 @@ namespace ssg {
 		bool aspectLocked;
 		bool scaleY;
 	
+		// Motion of the center per rendered frame, in world coordinates
+		float lastCenterX, lastCenterY;
+		float motionX, motionY;
+	
 		void setRadii(float rx, float ry);
 	};
 
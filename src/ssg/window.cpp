@@ -12,25 +12,46 @@
 #include "layer.h"
 #include "callback.h"
 #include "input.h"
+#include "input_record.h"
+#include "texture_loader.h"
+#include "texture_stats.h"
 #include "vectormath.h"
 
 using namespace ssg;
 
 
 
+// Bytes of decoded images uploaded to the renderer per frame
+static const size_t DEFAULT_TEXTURE_UPLOAD_BUDGET = 8 * 1024 * 1024;
+
+// Upper limit on the number of texture loader threads
+static const int MAX_TEXTURE_LOADER_THREADS = 4;
+
+
 /*
  * Constructors
  */
 
 Window::Window(int sx, int sy, bool ha, std::string name):
 	hardwareAccelerated(ha),
+	glyphCache(this),
 	screenWidth(sx),
 	screenHeight(sy),
 	active(false),
 	pixelFormat(NULL),
 	buffer(NULL),
 	renderer(NULL), // until activation
-	tickRecord(NULL)
+	tickRecord(NULL),
+	latchMouseX(0),
+	latchMouseY(0),
+	recorder(NULL),
+	replaying(false),
+	replayMouseX(0),
+	replayMouseY(0),
+	replayMouseButtons(0),
+	currentCursor(NULL),
+	textureLoader(NULL),
+	textureUploadBudget(DEFAULT_TEXTURE_UPLOAD_BUDGET)
 {
 
 	windowName = name;
@@ -59,9 +80,10 @@ int Window::activate(){
 	
 	if(result < 0 || renderer == NULL) return -1;
 
-	// Pixel Format for the texture buffer
-	pixelFormat = SDL_AllocFormat(SDL_PIXELFORMAT_RGBA8888);
-	buffer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, screenWidth, screenHeight);
+	// Pixel Format for textures, native to the renderer so uploads are copies
+	Uint32 format = choose_texture_format(renderer);
+	pixelFormat = SDL_AllocFormat(format);
+	buffer = SDL_CreateTexture(renderer, format, SDL_TEXTUREACCESS_TARGET, screenWidth, screenHeight);
 
 	// Tick Record for fps calculations
 	tickRecord = create_tick_record(10);
@@ -76,6 +98,7 @@ int Window::activate(){
  */
 Window::~Window(){
 	if(active) dispose();
+	TextureStats::windowDestroyed(this);
 }
 
 
@@ -88,6 +111,8 @@ int Window::dispose(){
 		printf("Cannot Dispose inactive window.\n");
 		return -1;
 	}
+	
+	stopRecording();
 
 	// Remove all layers
 	while (!layers.empty()){
@@ -97,6 +122,20 @@ int Window::dispose(){
 		// Note: This automatically removes the layer from the list.
 		delete layer;
 	}
+	
+	// Textures which outlive the window are no longer shared or managed
+	textureRegistry.clear();
+	textureResidency.clear();
+	
+	// Textures still pending will now never load
+	if(textureLoader != NULL){
+		delete textureLoader;
+		textureLoader = NULL;
+	}
+	
+	freeCursors();
+	texturePool.clear();
+	glyphCache.clear();
 
 	if (renderer != NULL){
 		SDL_DestroyRenderer(renderer);
@@ -141,12 +180,32 @@ void ssg::Window::update(float tpf){
 		return;
 	}
 	
+	if(recorder != NULL) recorder->beginFrame(tpf);
+	
 	// Note: Processing of input should be the final step of the update cycle,
 	//       as this may result in the end of the event.
 	processInput(tpf);
 	
 	if(!active) return;
 	
+	advanceFrame(tpf);
+}
+
+
+void ssg::Window::advanceFrame(float tpf){
+	/**
+	 * The part of the update cycle which follows input processing: updates the
+	 * layers and redraws the screen.
+	 */
+	
+	// Remember where the cursor was for the update step
+	latchMouseX = getMouseX();
+	latchMouseY = getMouseY();
+	
+	
+	// Upload images decoded since the last frame, so that they can be drawn
+	if(textureLoader != NULL) textureLoader->processUploads(textureUploadBudget);
+	
 	
 	// Update all layers
 	std::list<Layer*>::iterator iter;
@@ -156,8 +215,45 @@ void ssg::Window::update(float tpf){
 	}
 	
 	
+	// Catch up cursor-bound components with the latest cursor position
+	lateLatchCursor();
+	
 	// Draw the Window
 	refresh();
+	
+	// Glyph pages replaced during the frame are no longer drawn from
+	glyphCache.releaseRetiredPages();
+	
+	// Unload textures not drawn lately, if over the texture memory budget.
+	// Idle pooled textures go first.
+	size_t budget = textureResidency.getBudget();
+	if(budget != 0){
+		size_t used = textureResidency.getResidentBytes();
+		texturePool.trim(used < budget ? budget - used : 0);
+	}
+	textureResidency.endFrame();
+	TextureStats::frameEnded(this);
+}
+
+
+void ssg::Window::lateLatchCursor(){
+	/**
+	 * Re-reads the cursor position just before rendering and passes any motion
+	 * since the update step on to the layers, so that cursor-bound components
+	 * are drawn where the cursor is now rather than where it was a frame ago.
+	 * Events pumped here remain queued for the next update.
+	 */
+	SDL_PumpEvents();
+	
+	int dx = getMouseX() - latchMouseX;
+	int dy = getMouseY() - latchMouseY;
+	if(dx == 0 && dy == 0) return;
+	
+	std::list<Layer*>::iterator iter;
+	for(iter = layers.begin(); iter != layers.end(); iter++){
+		Layer *layer = *iter;
+		layer->lateLatch(dx, dy);
+	}
 }
 
 
@@ -219,6 +315,9 @@ void ssg::Window::refresh(){
 	SDL_RenderCopy(renderer, buffer, NULL, NULL);
 
 	SDL_RenderPresent(renderer);
+	
+	// Everything processed so far is now on screen
+	latencyTracker.framePresented();
 }
 
 
@@ -231,10 +330,122 @@ void ssg::Window::processInput(float tpf){
 	
 	// Cycle through all active events
 	while(SDL_PollEvent(&sdlEvent) != 0){
+		if(recorder != NULL) recorder->recordEvent(sdlEvent);
 		processEvent(sdlEvent, tpf);
 	}
 }
 
+
+void Window::replayFrame(const std::vector<SDL_Event> &events, float tpf){
+	/**
+	 * Internal Method: Runs one update cycle with the provided (recorded) events
+	 * in place of live input, which is discarded.  From the first call until
+	 * endReplay is called, the mouse and keyboard state reported by the window
+	 * is derived from the replayed events instead of SDL.  Replayed events are
+	 * not counted towards input latency, as they were not received live.
+	 * 
+	 * @param events the events of the frame, in the order they were received
+	 * @param tpf the recorded time, in seconds, since the last frame
+	 */
+	if(!active){
+		printf("Replaying input on an inactive Window.\n");
+		return;
+	}
+	replaying = true;
+	
+	// Live input is ignored
+	SDL_Event sdlEvent;
+	while(SDL_PollEvent(&sdlEvent) != 0);
+	
+	// As with SDL, the input state reflects all of the frame's events up front.
+	for(unsigned int i = 0; i < events.size(); i++){
+		applyReplayState(events[i]);
+	}
+	
+	for(unsigned int i = 0; i < events.size() && active; i++){
+		processEvent(events[i], tpf);
+	}
+	
+	if(!active) return;
+	
+	advanceFrame(tpf);
+}
+
+
+void Window::applyReplayState(const SDL_Event &event){
+	switch(event.type){
+	case SDL_MOUSEMOTION:
+		replayMouseX = event.motion.x;
+		replayMouseY = event.motion.y;
+		break;
+	case SDL_MOUSEBUTTONDOWN:
+		replayMouseX = event.button.x;
+		replayMouseY = event.button.y;
+		replayMouseButtons |= SDL_BUTTON(event.button.button);
+		break;
+	case SDL_MOUSEBUTTONUP:
+		replayMouseX = event.button.x;
+		replayMouseY = event.button.y;
+		replayMouseButtons &= ~SDL_BUTTON(event.button.button);
+		break;
+	case SDL_KEYDOWN:
+		replayKeys.insert(event.key.keysym.sym);
+		break;
+	case SDL_KEYUP:
+		replayKeys.erase(event.key.keysym.sym);
+		break;
+	}
+}
+
+
+/*
+ * Input Recording
+ */
+
+bool Window::startRecording(std::string path){
+	/**
+	 * Starts recording all input received by this window, along with the tpf
+	 * of every frame, to the provided file.  Any recording in progress is
+	 * stopped first.  The trace may be replayed with an InputReplayer.
+	 * 
+	 * @param path the file to write the trace to
+	 * @return a boolean indicating whether or not recording has started.
+	 */
+	stopRecording();
+	recorder = InputRecorder::create(path);
+	return recorder != NULL;
+}
+
+void Window::stopRecording(){
+	/**
+	 * Stops recording input and closes the trace file, if recording.
+	 */
+	if(recorder != NULL){
+		delete recorder;
+		recorder = NULL;
+	}
+}
+
+bool Window::isRecording() const {
+	return recorder != NULL;
+}
+
+void Window::endReplay(){
+	/**
+	 * Goes back to live input after replaying a trace.  The input state left
+	 * over from the replayed events is forgotten.
+	 */
+	replaying = false;
+	replayMouseX = 0;
+	replayMouseY = 0;
+	replayMouseButtons = 0;
+	replayKeys.clear();
+}
+
+bool Window::isReplaying() const {
+	return replaying;
+}
+
 void Window::processEvent(SDL_Event sdlEvent, float tpf){
 	/**
 	 * Internal Method: Force the window to process the provided pseudo-input event.
@@ -259,6 +470,9 @@ void Window::processEvent(InputEvent *event, float tpf){
 	 * @param tpf the time, in seconds, since the last frame
 	 */
 	
+	// Replayed events were received long ago
+	if(!replaying) latencyTracker.eventReceived(event);
+	
 	// Pass the event on to layers for processing.
 	std::list<Layer*>::reverse_iterator iter;
 	// Iterate backwards (reverse order from rendering)
@@ -288,6 +502,166 @@ SDL_Surface *Window::createNewSurface(){
 }
 
 
+
+/*
+ * Hardware Cursors
+ */
+
+bool Window::setCursor(Texture *texture, int hotX, int hotY){
+	/**
+	 * Replaces the system cursor with the provided texture, drawn by the
+	 * compositor rather than by the renderer, so it tracks the mouse without any
+	 * frame of delay.  The cursor is built once per texture and hotspot, and
+	 * cached until the texture is released or the window is disposed.
+	 *
+	 * @return true if the cursor was changed.
+	 */
+	if(texture == NULL || !active) return false;
+	
+	SDL_Cursor *cursor = NULL;
+	std::map<Texture*, CursorRecord>::iterator cached = cursorCache.find(texture);
+	if(cached != cursorCache.end()){
+		if(cached->second.hotX == hotX && cached->second.hotY == hotY){
+			cursor = cached->second.cursor;
+		}else{
+			// Same image with a new hotspot; the old cursor cannot be reused.
+			if(currentCursor == texture) SDL_SetCursor(SDL_GetDefaultCursor());
+			SDL_FreeCursor(cached->second.cursor);
+			cached->second.cursor = NULL;
+		}
+	}
+	
+	if(cursor == NULL){
+		SDL_Surface *surface = texture->createSurface();
+		if(surface == NULL){
+			printf("Cannot create cursor; texture has no surface.\n");
+			return false;
+		}
+		cursor = SDL_CreateColorCursor(surface, hotX, hotY);
+		SDL_FreeSurface(surface);
+		if(cursor == NULL){
+			printf("Cannot create cursor: %s\n", SDL_GetError());
+			if(cached != cursorCache.end()){
+				cursorCache.erase(cached);
+				texture->removeOwner(this);
+			}
+			return false;
+		}
+		
+		if(cached == cursorCache.end()) texture->addOwner(this);
+		CursorRecord record;
+		record.cursor = cursor;
+		record.hotX = hotX;
+		record.hotY = hotY;
+		cursorCache[texture] = record;
+	}
+	
+	SDL_SetCursor(cursor);
+	currentCursor = texture;
+	return true;
+}
+
+
+void Window::resetCursor(){
+	/**
+	 * Restores the system default cursor.  Cached cursors are kept.
+	 */
+	if(currentCursor == NULL) return;
+	SDL_SetCursor(SDL_GetDefaultCursor());
+	currentCursor = NULL;
+}
+
+
+void Window::releaseCursor(Texture *texture){
+	/**
+	 * Frees the cached cursor of the provided texture, and gives up the window's
+	 * ownership of it.
+	 */
+	if(cursorCache.find(texture) == cursorCache.end()) return;
+	removeTextureReference(texture);
+	texture->removeOwner(this);
+}
+
+
+void Window::removeTextureReference(Texture *texture){
+	std::map<Texture*, CursorRecord>::iterator cached = cursorCache.find(texture);
+	if(cached == cursorCache.end()) return;
+	
+	if(currentCursor == texture) resetCursor();
+	if(cached->second.cursor != NULL) SDL_FreeCursor(cached->second.cursor);
+	cursorCache.erase(cached);
+}
+
+
+int Window::getCachedCursorCount() const {
+	/**
+	 * Internal Method: The number of cursors built and kept for reuse.
+	 */
+	return cursorCache.size();
+}
+
+
+Texture *Window::getCurrentCursor() const {
+	/**
+	 * Internal Method: The texture of the cursor shown, or NULL if the system
+	 * default is shown.
+	 */
+	return currentCursor;
+}
+
+
+void Window::freeCursors(){
+	resetCursor();
+	while(!cursorCache.empty()){
+		Texture *texture = cursorCache.begin()->first;
+		releaseCursor(texture);
+	}
+}
+
+
+/*
+ * Asynchronous Texture Loading
+ */
+
+TextureLoader *Window::getTextureLoader(){
+	/**
+	 * Internal Method: The loader used by Texture::createFromFileAsync; its
+	 * threads are started on first use.
+	 */
+	if(textureLoader == NULL && active){
+		int threads = SDL_GetCPUCount() - 1;
+		if(threads > MAX_TEXTURE_LOADER_THREADS) threads = MAX_TEXTURE_LOADER_THREADS;
+		textureLoader = new TextureLoader(this, threads);
+	}
+	return textureLoader;
+}
+
+
+void Window::waitForTextures(){
+	/**
+	 * Blocks until all asynchronous texture loads have finished, e.g. at the end
+	 * of a loading screen.
+	 */
+	if(textureLoader != NULL) textureLoader->waitAll();
+}
+
+
+int Window::getPendingTextureCount() const {
+	if(textureLoader == NULL) return 0;
+	return textureLoader->getPendingCount();
+}
+
+
+void Window::setTextureUploadBudget(size_t bytes){
+	/**
+	 * Sets the number of bytes of asynchronously loaded images which may be
+	 * uploaded each frame.  At least one image is uploaded per frame regardless.
+	 */
+	textureUploadBudget = bytes;
+}
+
+
+
 /*
  * Property Methods
  */
@@ -337,6 +711,38 @@ SDL_Renderer *Window::getRenderer() {
 }
 
 
+/*
+ * Latency Instrumentation
+ */
+
+LatencyStats Window::getInputLatency(std::string eventType) const {
+	/**
+	 * Returns rolling percentiles of the time between input events of the
+	 * provided type happening and the first frame reflecting them being
+	 * presented.
+	 * 
+	 * @param eventType the type of event, as returned by InputEvent::getType()
+	 * @return a struct containing the number of samples and the 50th, 95th and
+	 * 99th percentile latencies in milliseconds.
+	 */
+	return latencyTracker.getStats(eventType);
+}
+
+std::list<std::string> Window::getLatencyEventTypes() const {
+	/**
+	 * @return a list of all event types for which latencies have been recorded.
+	 */
+	return latencyTracker.getEventTypes();
+}
+
+void Window::resetInputLatency(){
+	/**
+	 * Discards all recorded latency samples.
+	 */
+	latencyTracker.reset();
+}
+
+
 /*
  * Coordinate Transforms
  */
@@ -535,6 +941,8 @@ bool Window::isKeyPressed(SDL_Keycode keycode){
 	 * @param keycode the SDL2 keycode corresponding to the key of interest
 	 * @return a boolean indicating whether or not the key is pressed.
 	 */
+	if(replaying) return replayKeys.count(keycode) > 0;
+	
 	const Uint8 *keystate = SDL_GetKeyboardState(NULL);
 	SDL_Scancode scancode = SDL_GetScancodeFromKey(keycode);
 	return keystate[scancode] != 0;
@@ -547,6 +955,7 @@ bool Window::isLeftMouseButtonPressed(){
 	 * @return a boolean indicating whether or not the left mouse button is
 	 * currently pressed.
 	 */
+	if(replaying) return replayMouseButtons & SDL_BUTTON(SDL_BUTTON_LEFT);
 	return SDL_GetMouseState(NULL, NULL) & SDL_BUTTON(SDL_BUTTON_LEFT);
 }
 
@@ -557,6 +966,7 @@ bool Window::isRightMouseButtonPressed(){
 	 * @return a boolean indicating whether or not the right mouse button is
 	 * currently pressed.
 	 */
+	if(replaying) return replayMouseButtons & SDL_BUTTON(SDL_BUTTON_RIGHT);
 	return SDL_GetMouseState(NULL, NULL) & SDL_BUTTON(SDL_BUTTON_RIGHT);
 }
 
@@ -567,6 +977,7 @@ bool Window::isMiddleMouseButtonPressed(){
 	 * @return a boolean indicating whether or not the middle mouse button is
 	 * currently pressed.
 	 */
+	if(replaying) return replayMouseButtons & SDL_BUTTON(SDL_BUTTON_MIDDLE);
 	return SDL_GetMouseState(NULL, NULL) & SDL_BUTTON(SDL_BUTTON_MIDDLE);
 }
 
@@ -576,6 +987,8 @@ int Window::getMouseX(){
 	 * 
 	 * @return an int containing the (screen) x-coordinate of the mouse cursor.
 	 */
+	if(replaying) return replayMouseX;
+	
 	int x;
 	SDL_GetMouseState(&x, NULL);
 	return x;
@@ -587,6 +1000,8 @@ int Window::getMouseY(){
 	 * 
 	 * @return an int containing the (screen) y-coordinate of the mouse cursor.
 	 */
+	if(replaying) return replayMouseY;
+	
 	int y;
 	SDL_GetMouseState(NULL, &y);
 	return y;
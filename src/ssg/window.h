@@ -7,15 +7,26 @@
 #include "shared_exports.h"
 
 #include <list>
+#include <map>
+#include <set>
 #include <string>
+#include <vector>
 #include "sdl.h"
 #include "layer.h"
 #include "callback.h"
+#include "latency.h"
+#include "texture.h"
+#include "texture_registry.h"
+#include "texture_residency.h"
+#include "texture_pool.h"
+#include "glyph_cache.h"
 
 
 namespace ssg {
 
 	struct TickRecord;
+	class InputRecorder;
+	class TextureLoader;
 	class CallbackManager;
 	class EventCallback;
 	class Vector2f;
@@ -23,11 +34,15 @@ namespace ssg {
 	/*
 	 * Main window class
 	 */
-	class SHARED_EXPORT Window {
+	class SHARED_EXPORT Window : public TextureOwner {
 	public:
 		const bool hardwareAccelerated;
 	
 		TopCallbackManager callbackManager;
+		TextureRegistry textureRegistry;
+		ResidencyManager textureResidency;
+		TexturePool texturePool;
+		GlyphCache glyphCache;
 	
 		Window(int sx, int sy, bool ha, std::string name = "ssg");
 		~Window();
@@ -70,13 +85,41 @@ namespace ssg {
 		int getMouseX();
 		int getMouseY();
 		
+		// Input-to-present latency
+		LatencyStats getInputLatency(std::string eventType) const;
+		std::list<std::string> getLatencyEventTypes() const;
+		void resetInputLatency();
+		
+		// Input Recording (see input_record.h)
+		bool startRecording(std::string path);
+		void stopRecording();
+		bool isRecording() const;
+		void endReplay();
+		bool isReplaying() const;
+		
+		// Hardware Cursors
+		bool setCursor(Texture *texture, int hotX, int hotY);
+		void resetCursor();
+		void releaseCursor(Texture *texture);
+		
+		// Asynchronous Texture Loading (see texture_loader.h)
+		void waitForTextures();
+		int getPendingTextureCount() const;
+		void setTextureUploadBudget(size_t bytes);
+		
 	internal:
 		SDL_PixelFormat *getFormat() const;
 		SDL_Renderer *getRenderer();
 		SDL_Surface *createNewSurface();
+		TextureLoader *getTextureLoader();
 		
 		void processEvent(InputEvent *event, float tpf);
 		void processEvent(SDL_Event event, float tpf);
+		
+		void replayFrame(const std::vector<SDL_Event> &events, float tpf);
+		
+		int getCachedCursorCount() const;
+		Texture *getCurrentCursor() const;
 	
 	private:
 		SDL_Window *window;
@@ -93,12 +136,45 @@ namespace ssg {
 		SDL_Renderer *renderer;
 	
 		struct TickRecord *tickRecord;
+		LatencyTracker latencyTracker;
+	
+		// Cursor position as seen by the most recent update step
+		int latchMouseX, latchMouseY;
+	
+		InputRecorder *recorder;
+	
+		// While replaying, input state comes from the replayed events
+		bool replaying;
+		int replayMouseX, replayMouseY;
+		Uint32 replayMouseButtons;
+		std::set<SDL_Keycode> replayKeys;
+	
+		/*
+		 * Hardware cursors, one per texture.  The window owns each texture for
+		 * as long as its cursor is cached.
+		 */
+		struct CursorRecord {
+			SDL_Cursor *cursor;
+			int hotX, hotY;
+		};
+		std::map<Texture*, CursorRecord> cursorCache;
+		Texture *currentCursor;
+	
+		TextureLoader *textureLoader; // Created on first use
+		size_t textureUploadBudget;   // Bytes per frame
 	
 	
 		bool registerLayer(Layer *layer);
 	
 		void refresh();
 		void processInput(float tpf);
+		void advanceFrame(float tpf);
+		void lateLatchCursor();
+		void applyReplayState(const SDL_Event &event);
+		void freeCursors();
+	
+	protected:
+		virtual void removeTextureReference(Texture *texture);
 	
 	};
 }
@@ -0,0 +1,103 @@
+/*
+ * Unit Tests for bit-packed alpha masks
+ */
+
+#include <cstdio>
+#include <gtest/gtest.h>
+
+#include "../src/ssg/ssg_test.h"
+
+
+using namespace ssg;
+
+
+static SDL_Surface *create_disc_surface(int size){
+	/*
+	 * Creates an RGBA surface containing an opaque disc on a transparent
+	 * background.
+	 */
+	SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(
+		0, size, size, 32, SDL_PIXELFORMAT_RGBA8888
+	);
+
+	float r = 0.5f * size;
+	for(int y = 0; y < size; y++){
+		Uint32 *row = (Uint32*) ((Uint8*) surface->pixels + y * surface->pitch);
+		for(int x = 0; x < size; x++){
+			float dx = x + 0.5f - r;
+			float dy = y + 0.5f - r;
+			Uint32 alpha = (dx * dx + dy * dy <= r * r) ? 0xff : 0x00;
+			row[x] = 0xffffff00 | alpha;
+		}
+	}
+
+	return surface;
+}
+
+
+
+TEST(AlphaMask, DiscMask){
+	/**
+	 * Builds a mask from a disc and checks the center, the corners and the
+	 * coarse levels.
+	 */
+	int size = 100;
+	SDL_Surface *surface = create_disc_surface(size);
+	ASSERT_TRUE(surface != NULL);
+
+	AlphaMask *mask = AlphaMask::createFromSurface(surface, 0x80);
+	ASSERT_TRUE(mask != NULL);
+
+	EXPECT_EQ(size, mask->width);
+	EXPECT_EQ(size, mask->height);
+
+	// Inside the disc
+	EXPECT_TRUE(mask->test(50, 50));
+	EXPECT_TRUE(mask->test(5, 50));
+	EXPECT_TRUE(mask->test(50, 94));
+
+	// Corners are transparent
+	EXPECT_FALSE(mask->test(0, 0));
+	EXPECT_FALSE(mask->test(99, 0));
+	EXPECT_FALSE(mask->test(0, 99));
+	EXPECT_FALSE(mask->test(99, 99));
+
+	// Outside of the mask altogether
+	EXPECT_FALSE(mask->test(-1, 50));
+	EXPECT_FALSE(mask->test(50, 100));
+
+	// Coarse levels: the top-left 8x8 block is empty; the center block is not
+	EXPECT_FALSE(mask->testLevel(1, 0, 0));
+	EXPECT_TRUE(mask->testLevel(1, 6, 6));
+	EXPECT_TRUE(mask->testLevel(mask->getLevelCount() - 1, 0, 0));
+
+	// Roughly 1 bit per texel
+	EXPECT_LT(mask->getByteSize(), (size_t) (size * size * 4) / 20);
+
+	delete mask;
+	SDL_FreeSurface(surface);
+}
+
+
+TEST(AlphaMask, Threshold){
+	/**
+	 * Checks that the threshold is inclusive.
+	 */
+	SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(
+		0, 2, 1, 32, SDL_PIXELFORMAT_RGBA8888
+	);
+	ASSERT_TRUE(surface != NULL);
+
+	Uint32 *pixels = (Uint32*) surface->pixels;
+	pixels[0] = 0x0000007f;
+	pixels[1] = 0x00000080;
+
+	AlphaMask *mask = AlphaMask::createFromSurface(surface, 0x80);
+	ASSERT_TRUE(mask != NULL);
+
+	EXPECT_FALSE(mask->test(0, 0));
+	EXPECT_TRUE(mask->test(1, 0));
+
+	delete mask;
+	SDL_FreeSurface(surface);
+}
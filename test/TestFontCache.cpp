@@ -0,0 +1,79 @@
+/*
+ * Unit Tests for the font cache
+ */
+
+#include <gtest/gtest.h>
+
+#include "../src/ssg/ssg_test.h"
+
+
+using namespace ssg;
+
+
+static const char *FONT_PATH = "assets/font/LiberationSerif-Regular.ttf";
+
+
+
+TEST(FontCache, SharedFile){
+	/**
+	 * Sizes of a font are opened once each, and share the font file, which is
+	 * freed with the last of them.
+	 */
+	Window *window = new Window(100, 100, false);
+	
+	TTF_Font *small = FontCache::getFont(FONT_PATH, 12);
+	TTF_Font *large = FontCache::getFont(FONT_PATH, 24);
+	ASSERT_TRUE(small != NULL && large != NULL);
+	EXPECT_NE(small, large);
+	EXPECT_EQ(small, FontCache::getFont(FONT_PATH, 12));
+	EXPECT_EQ(2, FontCache::getFontCount());
+	EXPECT_EQ(1, FontCache::getFileCount());
+	EXPECT_GT(FontCache::getFileBytes(), 0u);
+	
+	FontCache::evictFont(FONT_PATH, 12);
+	EXPECT_EQ(1, FontCache::getFontCount());
+	EXPECT_EQ(1, FontCache::getFileCount());
+	
+	FontCache::evictFile(FONT_PATH);
+	EXPECT_EQ(0, FontCache::getFontCount());
+	EXPECT_EQ(0, FontCache::getFileCount());
+	
+	// Missing files are not cached
+	EXPECT_EQ(NULL, FontCache::getFont("assets/font/missing.ttf", 12));
+	EXPECT_EQ(0, FontCache::getFileCount());
+	
+	delete window;
+}
+
+
+TEST(FontCache, EvictMetrics){
+	/**
+	 * Evicting a font file drops its metrics too; layouts which used them
+	 * measure with new ones.
+	 */
+	Window *window = new Window(100, 100, false);
+	
+	TextLayout layout;
+	layout.setFont(FONT_PATH, 16);
+	layout.setText("Evicted metrics");
+	layout.update();
+	ASSERT_EQ(1, layout.getLineCount());
+	int width = layout.getLine(0).width;
+	
+	int generation = TextMetrics::getGeneration();
+	FontCache::evictFile(FONT_PATH);
+	EXPECT_GT(TextMetrics::getGeneration(), generation);
+	
+	// Other fonts' metrics are not dropped
+	generation = TextMetrics::getGeneration();
+	FontCache::evictFile("assets/font/missing.ttf");
+	EXPECT_EQ(generation, TextMetrics::getGeneration());
+	
+	layout.setText("Evicted metrics, again");
+	layout.update();
+	ASSERT_EQ(1, layout.getLineCount());
+	EXPECT_GT(layout.getLine(0).width, width);
+	EXPECT_EQ(TextMetrics::measure("Evicted metrics, again", FONT_PATH, 16), layout.getLine(0).width);
+	
+	delete window;
+}
@@ -0,0 +1,94 @@
+/*
+ * Unit Tests for the glyph cache
+ */
+
+#include <gtest/gtest.h>
+
+#include "../src/ssg/ssg_test.h"
+
+
+using namespace ssg;
+
+
+static const char *FONT_PATH = "assets/font/LiberationSerif-Regular.ttf";
+
+
+
+TEST(GlyphCache, Layout){
+	/**
+	 * Glyphs are rasterized once, however often they are laid out, and runs
+	 * laid out before the cache is cleared become invalid.
+	 */
+	Window *window = new Window(100, 100, false);
+	GlyphCache &cache = window->glyphCache;
+	
+	GlyphRun run;
+	EXPECT_FALSE(run.isValid(cache));
+	
+	ASSERT_TRUE(cache.layout("abba", FONT_PATH, 16, run));
+	EXPECT_TRUE(run.isValid(cache));
+	EXPECT_EQ(4u, run.quads.size());
+	EXPECT_EQ(2, cache.getGlyphCount());
+	EXPECT_EQ(1, cache.getPageCount());
+	EXPECT_GT(run.getWidth(), 0);
+	EXPECT_GT(run.getHeight(), 0);
+	
+	// Spaces take room, but need no quad
+	int width = run.getWidth();
+	cache.layout("ab ba", FONT_PATH, 16, run);
+	EXPECT_EQ(4u, run.quads.size());
+	EXPECT_EQ(3, cache.getGlyphCount());
+	EXPECT_GT(run.getWidth(), width);
+	
+	// Runs are exactly as wide as their text measures
+	EXPECT_EQ(TextMetrics::measure("ab ba", FONT_PATH, 16), run.getWidth());
+	
+	cache.clear();
+	EXPECT_FALSE(run.isValid(cache));
+	EXPECT_EQ(0, cache.getGlyphCount());
+	
+	// Unknown fonts lay out as nothing
+	EXPECT_FALSE(cache.layout("abba", "assets/font/missing.ttf", 16, run));
+	EXPECT_TRUE(run.quads.empty());
+	
+	delete window;
+}
+
+
+TEST(GlyphCache, PageLimit){
+	/**
+	 * When the pages fill up, the cache starts over rather than growing, and
+	 * page memory is reported until the old pages are freed.
+	 */
+	Window *window = new Window(100, 100, false);
+	GlyphCache &cache = window->glyphCache;
+	cache.setPageLimit(1);
+	EXPECT_EQ(1, cache.getPageLimit());
+	
+	size_t pageBytes = TextureStats::getGlyphPageBytes();
+	
+	GlyphRun first;
+	ASSERT_TRUE(cache.layout("abcdefghijklm", FONT_PATH, 40, first));
+	int generation = cache.getGeneration();
+	EXPECT_GT(TextureStats::getGlyphPageBytes(), pageBytes);
+	
+	// Large glyphs soon fill the only page
+	GlyphRun run;
+	for(int size = 60; size <= 140; size += 20){
+		ASSERT_TRUE(cache.layout("abcdefghijklm", FONT_PATH, size, run));
+		EXPECT_EQ(13u, run.quads.size());
+		EXPECT_TRUE(run.isValid(cache));
+		EXPECT_EQ(1, cache.getPageCount());
+	}
+	EXPECT_GT(cache.getGeneration(), generation);
+	EXPECT_FALSE(first.isValid(cache));
+	
+	// Only the page in use is left once the frame ends
+	cache.releaseRetiredPages();
+	size_t oneMore = TextureStats::getGlyphPageBytes() - pageBytes;
+	EXPECT_GT(oneMore, 0u);
+	cache.clear();
+	EXPECT_EQ(pageBytes, TextureStats::getGlyphPageBytes());
+	
+	delete window;
+}
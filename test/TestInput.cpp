@@ -274,38 +274,121 @@ TEST(Input, EventPriority){
 
 
 
+TEST(Input, LateLatch){
+	/**
+	 * Just before rendering, cursor-bound components, and everything attached
+	 * to them, are moved by the cursor motion since the update step; nothing
+	 * else moves.
+	 */
+	
+	// Absolute positions are not API; these expose them
+	class DraggableProbe : public ComponentDraggable2D {
+	public:
+		DraggableProbe(Window *win): ComponentDraggable2D(win){};
+		Vector2f getPositionAbsolute(){return positionAbsolute;};
+	};
+	
+	class PointProbe : public ComponentPoint2D {
+	public:
+		Vector2f getPositionAbsolute(){return positionAbsolute;};
+	};
+	
+	
+	Window *window = new Window(100, 200, false);
+	Layer2D *layer = new Layer2D("latch");
+	window->addLayerTop(layer);
+	layer->viewport.setRadiusY(3.0f);
+	
+	Node2D *node = new Node2D();
+	node->position = Vector2f(1.0f, 1.0f);
+	layer->getRootNode()->attachChild(node);
+	
+	DraggableProbe *draggable = new DraggableProbe(window);
+	draggable->cursorBound = true;
+	draggable->position = Vector2f(0.5f, 0.0f);
+	node->attachChild(draggable);
+	
+	Node2D *group = new Node2D();
+	group->cursorBound = true;
+	node->attachChild(group);
+	PointProbe *follower = new PointProbe();
+	follower->position = Vector2f(0.0f, -0.5f);
+	group->attachChild(follower);
+	
+	PointProbe *still = new PointProbe();
+	node->attachChild(still);
+	
+	layer->update(0.0f);
+	Vector2f draggableStart = draggable->getPositionAbsolute();
+	Vector2f followerStart = follower->getPositionAbsolute();
+	Vector2f stillStart = still->getPositionAbsolute();
+	
+	// Screen pixels, down being positive, to world units, up being positive
+	layer->lateLatch(10, 5);
+	float pixelFactor = 2.0f / window->getScreenHeight();
+	float dx = 10 * pixelFactor * 3.0f;
+	float dy = -5 * pixelFactor * 3.0f;
+	
+	EXPECT_FLOAT_EQ(draggableStart.x + dx, draggable->getPositionAbsolute().x);
+	EXPECT_FLOAT_EQ(draggableStart.y + dy, draggable->getPositionAbsolute().y);
+	EXPECT_FLOAT_EQ(followerStart.x + dx, follower->getPositionAbsolute().x);
+	EXPECT_FLOAT_EQ(followerStart.y + dy, follower->getPositionAbsolute().y);
+	EXPECT_FLOAT_EQ(stillStart.x, still->getPositionAbsolute().x);
+	EXPECT_FLOAT_EQ(stillStart.y, still->getPositionAbsolute().y);
+	
+	// The next update step puts everything back where it belongs
+	layer->update(0.0f);
+	EXPECT_FLOAT_EQ(draggableStart.x, draggable->getPositionAbsolute().x);
+	EXPECT_FLOAT_EQ(followerStart.y, follower->getPositionAbsolute().y);
+	
+	delete window;
+}
 
 
 
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
+TEST(Input, HoverCursor){
+	/**
+	 * Hovering over a button with a hover cursor shows the cursor, which is
+	 * built once and kept for the next hover.  Leaving the button restores
+	 * the default cursor, and deleting the texture frees its cursor.
+	 */
+	Window *window = new Window(100, 100, false);
+	Layer2D *layer = new Layer2D("cursor");
+	window->addLayerTop(layer);
+	
+	ComponentButtonSimple2D *button = new ComponentButtonSimple2D(window);
+	button->width = 0.5f;
+	button->height = 0.5f;
+	layer->getRootNode()->attachChild(button);
+	
+	Texture *cursor = Texture::createSolidColor(8, 8, window, 0xff, 0, 0, 0xff);
+	button->setHoverCursor(cursor, 1, 2);
+	layer->update(0.0f);
+	
+	SDL_Event inside, outside;
+	SDL_memset(&inside, 0, sizeof(SDL_Event));
+	inside.type = SDL_MOUSEMOTION;
+	window->viewportToScreen(0.1f, -0.1f, inside.motion.x, inside.motion.y);
+	outside = inside;
+	window->viewportToScreen(-0.9f, 0.9f, outside.motion.x, outside.motion.y);
+	
+	window->processEvent(inside, 0.0f);
+	EXPECT_EQ(cursor, window->getCurrentCursor());
+	EXPECT_EQ(1, window->getCachedCursorCount());
+	
+	window->processEvent(outside, 0.0f);
+	EXPECT_TRUE(window->getCurrentCursor() == NULL);
+	EXPECT_EQ(1, window->getCachedCursorCount());
+	
+	// The cached cursor is reused
+	window->processEvent(inside, 0.0f);
+	EXPECT_EQ(cursor, window->getCurrentCursor());
+	EXPECT_EQ(1, window->getCachedCursorCount());
+	
+	delete cursor;
+	EXPECT_EQ(0, window->getCachedCursorCount());
+	EXPECT_TRUE(window->getCurrentCursor() == NULL);
+	EXPECT_TRUE(button->getHoverCursor() == NULL);
+	
+	delete window;
+}
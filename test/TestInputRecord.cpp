@@ -0,0 +1,172 @@
+/*
+ * Unit Tests for input recording and replay
+ */
+
+#include <cstdio>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../src/ssg/ssg_test.h"
+
+
+using namespace ssg;
+
+
+static const char *TRACE_PATH = "test_input_trace.tmp";
+
+
+static SDL_Event make_motion_event(int x, int y){
+	SDL_Event event;
+	SDL_memset(&event, 0, sizeof(SDL_Event));
+	event.type = SDL_MOUSEMOTION;
+	event.motion.x = x;
+	event.motion.y = y;
+	return event;
+}
+
+
+static SDL_Event make_button_event(Uint32 type, int x, int y){
+	SDL_Event event;
+	SDL_memset(&event, 0, sizeof(SDL_Event));
+	event.type = type;
+	event.button.button = SDL_BUTTON_LEFT;
+	event.button.state = type == SDL_MOUSEBUTTONDOWN ? SDL_PRESSED : SDL_RELEASED;
+	event.button.x = x;
+	event.button.y = y;
+	return event;
+}
+
+
+static SDL_Event make_key_event(Uint32 type, SDL_Keycode key){
+	SDL_Event event;
+	SDL_memset(&event, 0, sizeof(SDL_Event));
+	event.type = type;
+	event.key.state = type == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED;
+	event.key.keysym.sym = key;
+	return event;
+}
+
+
+
+TEST(InputRecord, RoundTrip){
+	/**
+	 * Records three frames (one of them without events) and reads them back.
+	 */
+	InputRecorder *recorder = InputRecorder::create(TRACE_PATH);
+	ASSERT_TRUE(recorder != NULL);
+	
+	recorder->beginFrame(0.016f);
+	recorder->recordEvent(make_motion_event(10, 20));
+	recorder->recordEvent(make_motion_event(11, 21));
+	
+	recorder->beginFrame(0.020f);
+	
+	recorder->beginFrame(0.030f);
+	recorder->recordEvent(make_motion_event(42, 43));
+	
+	// Window manager events carry pointers, and are left out
+	SDL_Event syswm;
+	SDL_memset(&syswm, 0, sizeof(SDL_Event));
+	syswm.type = SDL_SYSWMEVENT;
+	recorder->recordEvent(syswm);
+	
+	recorder->close();
+	EXPECT_EQ(3, recorder->getFrameCount());
+	delete recorder;
+	
+	
+	InputReplayer *replayer = InputReplayer::create(TRACE_PATH);
+	ASSERT_TRUE(replayer != NULL);
+	
+	std::vector<SDL_Event> events;
+	float tpf;
+	
+	ASSERT_TRUE(replayer->readFrame(events, tpf));
+	EXPECT_FLOAT_EQ(0.016f, tpf);
+	ASSERT_EQ(2u, events.size());
+	EXPECT_EQ((Uint32) SDL_MOUSEMOTION, events[0].type);
+	EXPECT_EQ(10, events[0].motion.x);
+	EXPECT_EQ(21, events[1].motion.y);
+	
+	ASSERT_TRUE(replayer->readFrame(events, tpf));
+	EXPECT_FLOAT_EQ(0.020f, tpf);
+	EXPECT_EQ(0u, events.size());
+	
+	ASSERT_TRUE(replayer->readFrame(events, tpf));
+	EXPECT_FLOAT_EQ(0.030f, tpf);
+	ASSERT_EQ(1u, events.size());
+	EXPECT_EQ(42, events[0].motion.x);
+	
+	EXPECT_FALSE(replayer->readFrame(events, tpf));
+	
+	delete replayer;
+	remove(TRACE_PATH);
+}
+
+
+TEST(InputRecord, InvalidTrace){
+	/**
+	 * Files which are not traces should be rejected.
+	 */
+	FILE *file = fopen(TRACE_PATH, "wb");
+	ASSERT_TRUE(file != NULL);
+	fputs("definitely not a trace", file);
+	fclose(file);
+	
+	EXPECT_TRUE(InputReplayer::create(TRACE_PATH) == NULL);
+	
+	remove(TRACE_PATH);
+}
+
+
+TEST(InputRecord, ReplayFrame){
+	/**
+	 * Replayed frames drive callbacks and the input state of the window, but
+	 * not its latency statistics, until the replay ends.
+	 */
+	Window *window = new Window(100, 100, false);
+	
+	class CallbackPresses : public MouseButtonCallback {
+	public:
+		int presses, releases;
+		CallbackPresses(Window *win): MouseButtonCallback(win), presses(0), releases(0){};
+		
+		virtual void callback(MouseButtonEvent *event, float tpf){
+			if(!event->isLeftButton()) return;
+			if(event->isPressed()) presses++;
+			if(event->isReleased()) releases++;
+		};
+	};
+	CallbackPresses *callback = new CallbackPresses(window);
+	
+	std::vector<SDL_Event> events;
+	events.push_back(make_motion_event(10, 20));
+	events.push_back(make_button_event(SDL_MOUSEBUTTONDOWN, 30, 40));
+	events.push_back(make_key_event(SDL_KEYDOWN, SDLK_a));
+	window->replayFrame(events, 0.016f);
+	
+	EXPECT_TRUE(window->isReplaying());
+	EXPECT_EQ(1, callback->presses);
+	EXPECT_EQ(0, callback->releases);
+	EXPECT_TRUE(window->isLeftMouseButtonPressed());
+	EXPECT_FALSE(window->isRightMouseButtonPressed());
+	EXPECT_TRUE(window->isKeyPressed(SDLK_a));
+	EXPECT_EQ(30, window->getMouseX());
+	EXPECT_EQ(40, window->getMouseY());
+	
+	events.clear();
+	events.push_back(make_button_event(SDL_MOUSEBUTTONUP, 50, 60));
+	window->replayFrame(events, 0.016f);
+	
+	EXPECT_EQ(1, callback->releases);
+	EXPECT_FALSE(window->isLeftMouseButtonPressed());
+	EXPECT_TRUE(window->isKeyPressed(SDLK_a));
+	EXPECT_EQ(50, window->getMouseX());
+	
+	EXPECT_TRUE(window->getLatencyEventTypes().empty());
+	
+	window->endReplay();
+	EXPECT_FALSE(window->isReplaying());
+	
+	delete window; // Takes care of the callback
+}
@@ -0,0 +1,97 @@
+/*
+ * Unit Tests for label placement
+ */
+
+#include <list>
+#include <gtest/gtest.h>
+
+#include "../src/ssg/ssg_test.h"
+#include "../src/ssg/renderable.h"
+
+
+using namespace ssg;
+
+
+static Renderable *make_renderable(){
+	return RenderablePoint::createRenderablePoint(0, 0, 0, 1, 0, 0, 0, 0, Rect2f(-1, 1, -1, 1));
+}
+
+
+static void clear_renderables(std::list<Renderable*> &renderables){
+	while(!renderables.empty()){
+		delete renderables.front();
+		renderables.pop_front();
+	}
+}
+
+
+
+TEST(LabelPlacer, Overlap){
+	/**
+	 * Overlapping labels give way to those of higher priority, or else to those
+	 * collected first; labels clear of all others are always placed.
+	 */
+	LabelPlacer placer;
+	placer.padding = 0;
+	int labels[4];
+	std::list<Renderable*> renderables;
+
+	Renderable *low = make_renderable();
+	Renderable *high = make_renderable();
+	placer.considerLabel(&labels[0], low, Rect2f(0.0f, 0.5f, 0.0f, 0.1f), 0);
+	placer.considerLabel(&labels[1], high, Rect2f(0.4f, 0.9f, 0.05f, 0.15f), 1);
+	placer.considerLabel(&labels[2], make_renderable(), Rect2f(-0.9f, -0.5f, 0.0f, 0.1f), 0);
+	placer.considerLabel(&labels[3], make_renderable(), Rect2f(-0.6f, -0.2f, 0.05f, 0.15f), 0);
+	placer.place(renderables, 100);
+
+	EXPECT_EQ(2, placer.getPlacedCount());
+	EXPECT_EQ(2, placer.getHiddenCount());
+	EXPECT_EQ(2u, renderables.size());
+	EXPECT_EQ(high, renderables.front());
+	clear_renderables(renderables);
+
+	// Touching labels do not overlap, unless padded
+	placer.considerLabel(&labels[0], make_renderable(), Rect2f(0.0f, 0.5f, 0.0f, 0.1f), 0);
+	placer.considerLabel(&labels[1], make_renderable(), Rect2f(0.5f, 0.9f, 0.0f, 0.1f), 0);
+	placer.place(renderables, 100);
+	EXPECT_EQ(2, placer.getPlacedCount());
+	clear_renderables(renderables);
+
+	placer.padding = 2;
+	placer.considerLabel(&labels[0], make_renderable(), Rect2f(0.0f, 0.5f, 0.0f, 0.1f), 0);
+	placer.considerLabel(&labels[1], make_renderable(), Rect2f(0.5f, 0.9f, 0.0f, 0.1f), 0);
+	placer.place(renderables, 100);
+	EXPECT_EQ(1, placer.getPlacedCount());
+	clear_renderables(renderables);
+
+	// Without placement, every label is drawn
+	placer.enabled = false;
+	placer.considerLabel(&labels[0], make_renderable(), Rect2f(0.0f, 0.5f, 0.0f, 0.1f), 0);
+	placer.considerLabel(&labels[1], make_renderable(), Rect2f(0.0f, 0.5f, 0.0f, 0.1f), 0);
+	placer.place(renderables, 100);
+	EXPECT_EQ(2, placer.getPlacedCount());
+	clear_renderables(renderables);
+}
+
+
+
+TEST(LabelPlacer, Cache){
+	/**
+	 * The placement is reused while the same labels are collected in the same
+	 * places.
+	 */
+	LabelPlacer placer;
+	int labels[2];
+	std::list<Renderable*> renderables;
+
+	for(int frame = 0; frame < 3; frame++){
+		float x = frame < 2 ? 0.0f : 1.0f;
+		placer.considerLabel(&labels[0], make_renderable(), Rect2f(0.0f, 0.5f, 0.0f, 0.1f), 0);
+		placer.considerLabel(&labels[1], make_renderable(), Rect2f(x, x + 0.5f, 0.0f, 0.1f), 0);
+		placer.place(renderables, 100);
+
+		EXPECT_EQ(frame == 1, placer.isCached());
+		EXPECT_EQ(frame < 2 ? 1 : 2, placer.getPlacedCount());
+		clear_renderables(renderables);
+	}
+}
@@ -0,0 +1,55 @@
+/*
+ * Unit Tests for latency records
+ */
+
+#include <cstdio>
+#include <gtest/gtest.h>
+
+#include "../src/ssg/ssg_test.h"
+
+
+using namespace ssg;
+
+
+
+TEST(Latency, Percentiles){
+	/**
+	 * Adds the samples 1, 2, ..., 100 in scrambled order and checks the
+	 * percentiles.
+	 */
+	LatencyRecord record(100);
+	
+	for(int i = 0; i < 100; i++){
+		record.addSample((float) ((i * 37) % 100 + 1));
+	}
+	
+	LatencyStats stats = record.computeStats();
+	EXPECT_EQ(100, stats.sampleCount);
+	EXPECT_FLOAT_EQ(50.0f, stats.p50);
+	EXPECT_FLOAT_EQ(95.0f, stats.p95);
+	EXPECT_FLOAT_EQ(99.0f, stats.p99);
+}
+
+
+TEST(Latency, RollingWindow){
+	/**
+	 * Once the record is full, old samples should be replaced by new ones.
+	 */
+	LatencyRecord record(10);
+	
+	LatencyStats stats = record.computeStats();
+	EXPECT_EQ(0, stats.sampleCount);
+	EXPECT_FLOAT_EQ(0.0f, stats.p99);
+	
+	for(int i = 0; i < 10; i++){
+		record.addSample(1000.0f);
+	}
+	for(int i = 0; i < 10; i++){
+		record.addSample(5.0f);
+	}
+	
+	stats = record.computeStats();
+	EXPECT_EQ(10, stats.sampleCount);
+	EXPECT_FLOAT_EQ(5.0f, stats.p50);
+	EXPECT_FLOAT_EQ(5.0f, stats.p99);
+}
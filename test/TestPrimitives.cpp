@@ -0,0 +1,286 @@
+/*
+ * Unit Tests for untextured primitive components
+ */
+
+#include <list>
+#include <gtest/gtest.h>
+
+#include "../src/ssg/ssg_test.h"
+#include "../src/ssg/renderable.h"
+
+
+using namespace ssg;
+
+
+static RenderableGeometry *collect_geometry(Component2D *component, Viewport2D &viewport){
+	std::list<Renderable*> renderables;
+	component->collectRenderables(renderables, viewport);
+	if(renderables.empty()) return NULL;
+
+	EXPECT_EQ(1u, renderables.size());
+	EXPECT_EQ("RenderableGeometry", renderables.front()->getType());
+	return (RenderableGeometry*) renderables.front();
+}
+
+
+
+TEST(Primitives, Rect){
+	/**
+	 * Rectangles are drawn as two triangles, and outlines as two more per side.
+	 */
+	Window *window = new Window(100, 100, false);
+	Layer2D *layer = new Layer2D("primitives");
+	window->addLayerTop(layer);
+
+	ComponentRect2D *rect = new ComponentRect2D(0.5f, 0.25f);
+	layer->getRootNode()->attachChild(rect);
+	layer->update(0.0f);
+
+	RenderableGeometry *geometry = collect_geometry(rect, layer->viewport);
+	ASSERT_TRUE(geometry != NULL);
+	EXPECT_EQ(4u, geometry->vertices.size());
+	EXPECT_EQ(6u, geometry->indices.size());
+	EXPECT_FLOAT_EQ(0.5f, geometry->vertices[1].position.x);
+	EXPECT_FLOAT_EQ(-0.25f, geometry->vertices[2].position.y);
+	EXPECT_TRUE(geometry->isBatched());
+	delete geometry;
+
+	rect->outlined = true;
+	rect->outlineWidth = 5;
+	geometry = collect_geometry(rect, layer->viewport);
+	ASSERT_TRUE(geometry != NULL);
+	EXPECT_EQ(12u, geometry->vertices.size());
+	EXPECT_EQ(30u, geometry->indices.size());
+
+	// The fill is inset by the outline: 5 pixels of 100 are 0.1 viewport units
+	EXPECT_FLOAT_EQ(0.1f, geometry->vertices[0].position.x);
+	EXPECT_FLOAT_EQ(-0.1f, geometry->vertices[0].position.y);
+	delete geometry;
+
+	// Rectangles out of view are culled
+	rect->position.set(10.0f, 0.0f);
+	layer->update(0.0f);
+	EXPECT_TRUE(collect_geometry(rect, layer->viewport) == NULL);
+
+	delete window;
+}
+
+
+
+TEST(Primitives, Polyline){
+	/**
+	 * Polylines are drawn as strips of two vertices per point, mitered at the
+	 * joins; runs of segments out of view are left out.
+	 */
+	Window *window = new Window(100, 100, false);
+	Layer2D *layer = new Layer2D("primitives");
+	window->addLayerTop(layer);
+
+	ComponentPolyline2D *line = new ComponentPolyline2D();
+	line->lineWidth = 10;
+	line->addPoint(-0.5f, 0.0f);
+	line->addPoint(0.0f, 0.0f);
+	line->addPoint(0.0f, 0.5f);
+	layer->getRootNode()->attachChild(line);
+	layer->update(0.0f);
+
+	RenderableGeometry *geometry = collect_geometry(line, layer->viewport);
+	ASSERT_TRUE(geometry != NULL);
+	EXPECT_EQ(6u, geometry->vertices.size());
+	EXPECT_EQ(12u, geometry->indices.size());
+
+	// 10 pixels of 100 are 0.2 viewport units wide
+	EXPECT_FLOAT_EQ(0.1f, geometry->vertices[0].position.y);
+	EXPECT_FLOAT_EQ(-0.1f, geometry->vertices[1].position.y);
+
+	// The corner is mitered: its outer vertex is on both outer edges
+	EXPECT_NEAR(0.1f, geometry->vertices[3].position.x, 1e-5);
+	EXPECT_NEAR(-0.1f, geometry->vertices[3].position.y, 1e-5);
+	delete geometry;
+
+	// Closing the line adds a segment back to the start
+	line->closed = true;
+	geometry = collect_geometry(line, layer->viewport);
+	ASSERT_TRUE(geometry != NULL);
+	EXPECT_EQ(8u, geometry->vertices.size());
+	EXPECT_EQ(18u, geometry->indices.size());
+	delete geometry;
+
+	// Segments far out of view make no triangles
+	line->closed = false;
+	line->addPoint(50.0f, 0.5f);
+	line->addPoint(50.0f, 10.0f);
+	geometry = collect_geometry(line, layer->viewport);
+	ASSERT_TRUE(geometry != NULL);
+	EXPECT_EQ(8u, geometry->vertices.size());
+	delete geometry;
+
+	delete window;
+}
+
+
+
+TEST(Primitives, PolylineSimplify){
+	/**
+	 * Long polylines draw only as many points as the screen can resolve, and
+	 * more of them when zoomed in.
+	 */
+	Window *window = new Window(100, 100, false);
+	Layer2D *layer = new Layer2D("primitives");
+	window->addLayerTop(layer);
+
+	// A flat line with ripples of 0.001 world units
+	ComponentPolyline2D *line = new ComponentPolyline2D();
+	for(int i = 0; i <= 1000; i++){
+		line->addPoint(-1.0f + 0.002f * i, i % 2 == 0 ? 0.0f : 0.001f);
+	}
+	line->addPoint(1.0f, 0.5f);
+	layer->getRootNode()->attachChild(line);
+	layer->update(0.0f);
+
+	// Tolerances halve down to the last level, which holds every point
+	line->buildLevels();
+	int levels = line->getLevelCount();
+	ASSERT_GE(levels, 2);
+	for(int i = 1; i < levels - 1; i++){
+		EXPECT_FLOAT_EQ(0.5f * line->getLevelTolerance(i - 1), line->getLevelTolerance(i));
+	}
+	EXPECT_EQ(0.0f, line->getLevelTolerance(levels - 1));
+
+	// Ripples of a tenth of a pixel are left out
+	RenderableGeometry *geometry = collect_geometry(line, layer->viewport);
+	ASSERT_TRUE(geometry != NULL);
+	EXPECT_LT(line->getDrawnPointCount(), 10);
+	EXPECT_EQ(2u * line->getDrawnPointCount(), geometry->vertices.size());
+	delete geometry;
+
+	// Zoomed in, ripples of several pixels are drawn
+	layer->viewport.setRadiusY(0.01f);
+	geometry = collect_geometry(line, layer->viewport);
+	ASSERT_TRUE(geometry != NULL);
+	EXPECT_GT(line->getDrawnPointCount(), 1000);
+	delete geometry;
+
+	// Without simplification, every point is drawn
+	layer->viewport.setRadiusY(1.0f);
+	line->simplifyTolerance = 0;
+	geometry = collect_geometry(line, layer->viewport);
+	ASSERT_TRUE(geometry != NULL);
+	EXPECT_EQ(1002, line->getDrawnPointCount());
+	delete geometry;
+
+	delete window;
+}
+
+
+
+TEST(Primitives, PointCloud){
+	/**
+	 * Point clouds draw every point in view as a square, all in one renderable,
+	 * each in its own color.
+	 */
+	Window *window = new Window(100, 100, false);
+	Layer2D *layer = new Layer2D("primitives");
+	window->addLayerTop(layer);
+
+	ComponentPointCloud2D *cloud = new ComponentPointCloud2D();
+	cloud->pointSize = 10;
+	cloud->addPoint(0.0f, 0.0f);
+	SDL_Color red = {0xff, 0x00, 0x00, 0xff};
+	cloud->addPoint(0.5f, 0.5f, red, 20);
+	cloud->addPoint(50.0f, 0.0f);
+	layer->getRootNode()->attachChild(cloud);
+	layer->update(0.0f);
+
+	EXPECT_EQ(3, cloud->getPointCount());
+	EXPECT_FLOAT_EQ(20.0f, cloud->getSize(1));
+
+	RenderableGeometry *geometry = collect_geometry(cloud, layer->viewport);
+	ASSERT_TRUE(geometry != NULL);
+	EXPECT_EQ(2, cloud->getDrawnPointCount());
+	EXPECT_EQ(8u, geometry->vertices.size());
+	EXPECT_EQ(12u, geometry->indices.size());
+
+	// 10 pixels of 100 are 0.2 viewport units wide
+	EXPECT_FLOAT_EQ(-0.1f, geometry->vertices[0].position.x);
+	EXPECT_FLOAT_EQ(0.1f, geometry->vertices[0].position.y);
+	EXPECT_FLOAT_EQ(0.7f, geometry->vertices[5].position.x);
+	EXPECT_EQ(0x00, geometry->vertices[5].color.g);
+	delete geometry;
+
+	// Points appended in blocks are drawn with the rest
+	float x[3] = {-0.5f, -0.4f, 60.0f};
+	float y[3] = {0.0f, 0.0f, 0.0f};
+	cloud->addPoints(3, x, y);
+	geometry = collect_geometry(cloud, layer->viewport);
+	ASSERT_TRUE(geometry != NULL);
+	EXPECT_EQ(4, cloud->getDrawnPointCount());
+	delete geometry;
+
+	// Clouds out of view make no renderable at all
+	cloud->clearPoints();
+	cloud->addPoints(1, x + 2, y);
+	EXPECT_TRUE(collect_geometry(cloud, layer->viewport) == NULL);
+	EXPECT_EQ(0, cloud->getDrawnPointCount());
+
+	delete window;
+}
+
+
+
+TEST(Primitives, PointCloudPixels){
+	/**
+	 * Clouds of one color, whose points are no wider than a pixel, are drawn
+	 * as pixels from a buffer which is kept between frames.
+	 */
+	Window *window = new Window(100, 100, false);
+	Layer2D *layer = new Layer2D("primitives");
+	window->addLayerTop(layer);
+
+	ComponentPointCloud2D *cloud = new ComponentPointCloud2D();
+	float x[3] = {0.0f, 0.5f, 60.0f};
+	float y[3] = {0.0f, -0.5f, 0.0f};
+	cloud->addPoints(3, x, y);
+	layer->getRootNode()->attachChild(cloud);
+	layer->update(0.0f);
+
+	std::list<Renderable*> renderables;
+	cloud->collectRenderables(renderables, layer->viewport);
+	ASSERT_EQ(1u, renderables.size());
+	ASSERT_EQ("RenderablePixels", renderables.front()->getType());
+	RenderablePixels *pixels = (RenderablePixels*) renderables.front();
+	EXPECT_EQ(2, cloud->getDrawnPointCount());
+	ASSERT_EQ(2u, pixels->pixels->size());
+
+	// The center of the screen, and a quarter of it to the right and down
+	EXPECT_FLOAT_EQ(50.0f, (*pixels->pixels)[0].x);
+	EXPECT_FLOAT_EQ(50.0f, (*pixels->pixels)[0].y);
+	EXPECT_FLOAT_EQ(75.0f, (*pixels->pixels)[1].x);
+	EXPECT_FLOAT_EQ(75.0f, (*pixels->pixels)[1].y);
+	const std::vector<SDL_FPoint> *buffer = pixels->pixels;
+	delete pixels;
+	renderables.clear();
+
+	// The next frame fills the same buffer
+	cloud->collectRenderables(renderables, layer->viewport);
+	ASSERT_EQ(1u, renderables.size());
+	EXPECT_EQ(buffer, ((RenderablePixels*) renderables.front())->pixels);
+	delete renderables.front();
+
+	// A point of another color, or a wider one, needs geometry
+	SDL_Color red = {0xff, 0x00, 0x00, 0xff};
+	cloud->addPoint(0.1f, 0.1f, red, 1);
+	RenderableGeometry *geometry = collect_geometry(cloud, layer->viewport);
+	ASSERT_TRUE(geometry != NULL);
+	EXPECT_EQ(3, cloud->getDrawnPointCount());
+	delete geometry;
+
+	cloud->clearPoints();
+	cloud->pointSize = 2;
+	cloud->addPoints(3, x, y);
+	geometry = collect_geometry(cloud, layer->viewport);
+	ASSERT_TRUE(geometry != NULL);
+	delete geometry;
+
+	delete window;
+}
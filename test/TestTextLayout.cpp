@@ -0,0 +1,131 @@
+/*
+ * Unit Tests for text measurement and layout
+ */
+
+#include <list>
+#include <string>
+#include <gtest/gtest.h>
+
+#include "../src/ssg/ssg_test.h"
+#include "../src/ssg/renderable.h"
+
+
+using namespace ssg;
+
+
+static const char *FONT_PATH = "assets/font/LiberationSerif-Regular.ttf";
+
+
+
+TEST(TextLayout, Measure){
+	/**
+	 * Measurements agree with SDL_ttf, and are additive over words.
+	 */
+	Window *window = new Window(100, 100, false);
+	
+	const TextMetrics *metrics = TextMetrics::getMetrics(FONT_PATH, 16);
+	ASSERT_TRUE(metrics != NULL);
+	EXPECT_EQ(metrics, TextMetrics::getMetrics(FONT_PATH, 16));
+	
+	int w, h;
+	TTF_SizeText(FontCache::getFont(FONT_PATH, 16), "Hello", &w, &h);
+	EXPECT_EQ(w, metrics->measure("Hello"));
+	EXPECT_EQ(h, metrics->getHeight());
+	EXPECT_EQ(0, metrics->measure(""));
+	
+	EXPECT_EQ(-1, TextMetrics::measure("Hello", "assets/font/missing.ttf", 16));
+	
+	delete window;
+}
+
+
+
+TEST(TextLayout, Wrapping){
+	/**
+	 * Lines are filled greedily, and an edit only reflows the lines it touches.
+	 */
+	Window *window = new Window(100, 100, false);
+	const TextMetrics *metrics = TextMetrics::getMetrics(FONT_PATH, 16);
+	ASSERT_TRUE(metrics != NULL);
+	
+	// Room for exactly two words per line
+	int space = metrics->getAdvance(' ');
+	TextLayout layout;
+	layout.setFont(FONT_PATH, 16);
+	layout.setWidth(2 * metrics->measure("word") + space);
+	
+	layout.setText("word word word word word word\n\nword");
+	EXPECT_TRUE(layout.update());
+	ASSERT_EQ(5, layout.getLineCount());
+	EXPECT_EQ("word word", layout.getLineText(0));
+	EXPECT_EQ("word word", layout.getLineText(2));
+	EXPECT_EQ("", layout.getLineText(3));
+	EXPECT_EQ("word", layout.getLineText(4));
+	EXPECT_FALSE(layout.update());
+	
+	// Changing a word in the middle reflows its line and the one before
+	layout.setText("word word word wordwordword word word\n\nword");
+	EXPECT_TRUE(layout.update());
+	EXPECT_EQ("word", layout.getLineText(1));
+	EXPECT_EQ("wordwordword", layout.getLineText(2));
+	EXPECT_EQ("word word", layout.getLineText(3));
+	EXPECT_EQ("word", layout.getLineText(5));
+	EXPECT_EQ(0, layout.getFirstChangedLine());
+	EXPECT_EQ(3, layout.getLastChangedLine());
+	
+	// Without wrapping, only newlines break lines
+	layout.setWidth(0);
+	layout.update();
+	EXPECT_EQ(3, layout.getLineCount());
+	
+	delete window;
+}
+
+
+
+
+TEST(TextLayout, TextBoxFits){
+	/**
+	 * Every line of a text box is drawn no wider than the box, whichever size
+	 * its glyphs are rasterized at.
+	 */
+	Window *window = new Window(100, 100, false);
+	Layer2D *layer = new Layer2D("text");
+	window->addLayerTop(layer);
+
+	ComponentTextBox2D *box = new ComponentTextBox2D(window);
+	box->text = "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do "
+	            "eiusmod tempor incididunt ut labore et dolore magna aliqua.  Ut "
+	            "enim ad minim veniam, quis nostrud exercitation ullamco laboris.";
+	box->fontPath = FONT_PATH;
+	box->fontSize = 16;
+	box->lineCount = 12;
+	box->width = 0.8f;
+	box->height = 1.2f;
+	layer->getRootNode()->attachChild(box);
+
+	const float radii[] = {1.0f, 0.37f, 0.61f, 2.3f, 1.0f};
+	for(int i = 0; i < 5; i++){
+		layer->viewport.setRadiusY(radii[i]);
+		layer->update(0.0f);
+
+		std::list<Renderable*> renderables;
+		box->collectRenderables(renderables, layer->viewport);
+		float boxWidth = box->width * layer->viewport.getInverseRadiusY();
+
+		int lines = 0;
+		while(!renderables.empty()){
+			Renderable *renderable = renderables.front();
+			renderables.pop_front();
+			if(renderable->getType() == "RenderableGlyphRun"){
+				RenderableGlyphRun *run = (RenderableGlyphRun*) renderable;
+				EXPECT_LE(run->width, boxWidth * 1.0001f) << "radius " << radii[i];
+				lines++;
+			}
+			delete renderable;
+		}
+		EXPECT_GT(lines, 2);
+	}
+
+	delete window;
+}
@@ -0,0 +1,232 @@
+/*
+ * Unit Tests for text sprites
+ */
+
+#include <list>
+#include <string>
+#include <gtest/gtest.h>
+
+#include "../src/ssg/ssg_test.h"
+#include "../src/ssg/renderable.h"
+
+
+using namespace ssg;
+
+
+static const char *FONT_PATH = "assets/font/LiberationSerif-Regular.ttf";
+
+
+static std::string collect_type(ComponentSpriteText2D *label, Viewport2D &viewport){
+	std::list<Renderable*> renderables;
+	label->collectRenderables(renderables, viewport);
+
+	std::string type = renderables.empty() ? "" : renderables.front()->getType();
+	while(!renderables.empty()){
+		delete renderables.front();
+		renderables.pop_front();
+	}
+	return type;
+}
+
+
+
+TEST(TextSprite, LevelOfDetail){
+	/**
+	 * Text is rasterized at a size following its height on screen, which does
+	 * not change back and forth for small changes of zoom; text too small to
+	 * read is drawn as a line.
+	 */
+	Window *window = new Window(100, 100, false);
+	Layer2D *layer = new Layer2D("text");
+	window->addLayerTop(layer);
+
+	ComponentSpriteText2D *label = new ComponentSpriteText2D(window);
+	label->text = "Level of detail";
+	label->fontPath = FONT_PATH;
+	label->fontSize = 16;
+	label->height = 0.2f;
+	layer->getRootNode()->attachChild(label);
+	layer->update(0.0f);
+
+	EXPECT_EQ("RenderableGlyphRun", collect_type(label, layer->viewport));
+	int size = label->getRasterSize();
+
+	layer->viewport.setRadiusY(0.5f);
+	collect_type(label, layer->viewport);
+	EXPECT_GT(label->getRasterSize(), size);
+	size = label->getRasterSize();
+
+	layer->viewport.setRadiusY(0.52f);
+	collect_type(label, layer->viewport);
+	EXPECT_EQ(size, label->getRasterSize());
+
+	layer->viewport.setRadiusY(10.0f);
+	EXPECT_EQ("RenderableLine", collect_type(label, layer->viewport));
+
+	label->drawPlaceholder = false;
+	EXPECT_EQ("", collect_type(label, layer->viewport));
+
+	// Without level of detail, text is always rasterized at its font size
+	label->levelOfDetail = false;
+	collect_type(label, layer->viewport);
+	EXPECT_EQ(16, label->getRasterSize());
+
+	delete window;
+}
+
+
+
+TEST(TextSprite, NaturalSize){
+	/**
+	 * Text drawn at the natural height of its font is rasterized at exactly its
+	 * font size, whatever that size is.
+	 */
+	Window *window = new Window(100, 100, false);
+	Layer2D *layer = new Layer2D("text");
+	window->addLayerTop(layer);
+
+	ComponentSpriteText2D *label = new ComponentSpriteText2D(window);
+	label->text = "Natural size";
+	label->fontPath = FONT_PATH;
+	layer->getRootNode()->attachChild(label);
+	layer->update(0.0f);
+
+	const int sizes[] = {12, 14, 20, 16};
+	for(int i = 0; i < 4; i++){
+		const TextMetrics *metrics = TextMetrics::getMetrics(FONT_PATH, sizes[i]);
+		ASSERT_TRUE(metrics != NULL);
+
+		// As many pixels tall as the font, in a window 100 pixels tall
+		label->fontSize = sizes[i];
+		label->height = 2.0f * metrics->getHeight() / window->getScreenHeight();
+		collect_type(label, layer->viewport);
+		EXPECT_EQ(sizes[i], label->getRasterSize());
+	}
+
+	delete window;
+}
+
+
+
+TEST(TextSprite, Deferred){
+	/**
+	 * Text which is hidden or out of view is not rasterized until it is drawn.
+	 */
+	Window *window = new Window(100, 100, false);
+	Layer2D *layer = new Layer2D("text");
+	window->addLayerTop(layer);
+
+	ComponentSpriteText2D *label = new ComponentSpriteText2D(window);
+	label->text = "Deferred";
+	label->fontPath = FONT_PATH;
+	label->height = 0.2f;
+	layer->getRootNode()->attachChild(label);
+
+	label->hide();
+	layer->update(0.0f);
+	EXPECT_EQ("", collect_type(label, layer->viewport));
+	EXPECT_EQ(0, window->glyphCache.getGlyphCount());
+
+	// Estimating where the text would be leaves its box as it is
+	label->show();
+	label->position.set(100.0f, 0.0f);
+	layer->update(0.0f);
+	float width = label->width;
+	EXPECT_EQ("", collect_type(label, layer->viewport));
+	EXPECT_EQ(0, window->glyphCache.getGlyphCount());
+	EXPECT_EQ(width, label->width);
+
+	label->position.set(0.0f, 0.0f);
+	layer->update(0.0f);
+	EXPECT_EQ("RenderableGlyphRun", collect_type(label, layer->viewport));
+	EXPECT_GT(window->glyphCache.getGlyphCount(), 0);
+
+	delete window;
+}
+
+
+
+TEST(TextSprite, ColorMod){
+	/**
+	 * Text is tinted by its color and by the color modulation of its parents
+	 * when drawn; changing either does not rasterize it again.
+	 */
+	Window *window = new Window(100, 100, false);
+	Layer2D *layer = new Layer2D("text");
+	window->addLayerTop(layer);
+
+	Node2D *node = new Node2D();
+	node->alphaMod = 0x80;
+	layer->getRootNode()->attachChild(node);
+
+	ComponentSpriteText2D *label = new ComponentSpriteText2D(window);
+	label->text = "Tinted";
+	label->fontPath = FONT_PATH;
+	label->height = 0.2f;
+	label->useGlyphCache = false;
+	label->colorGreen = 0;
+	node->attachChild(label);
+	layer->update(0.0f);
+
+	std::list<Renderable*> renderables;
+	label->collectRenderables(renderables, layer->viewport);
+	ASSERT_EQ(1u, renderables.size());
+	SDL_Color mod = renderables.front()->colorMod;
+	EXPECT_EQ(0xff, mod.r);
+	EXPECT_EQ(0x00, mod.g);
+	EXPECT_EQ(0x80, mod.a);
+	delete renderables.front();
+	renderables.clear();
+
+	Texture *texture = label->getTexture();
+	label->colorBlue = 0;
+	node->alphaMod = 0xff;
+	layer->update(0.0f);
+	label->collectRenderables(renderables, layer->viewport);
+	ASSERT_EQ(1u, renderables.size());
+	EXPECT_EQ(0x00, renderables.front()->colorMod.b);
+	EXPECT_EQ(0xff, renderables.front()->colorMod.a);
+	EXPECT_EQ(texture, label->getTexture());
+	delete renderables.front();
+
+	delete window;
+}
+
+
+
+TEST(TextSprite, PlaceholderDeclutter){
+	/**
+	 * Labels too small to read are placed like any other label, so that
+	 * overlapping placeholders give way to each other.
+	 */
+	Window *window = new Window(100, 100, false);
+	Layer2D *layer = new Layer2D("text");
+	window->addLayerTop(layer);
+
+	ComponentSpriteText2D *labels[2];
+	for(int i = 0; i < 2; i++){
+		labels[i] = new ComponentSpriteText2D(window);
+		labels[i]->text = "Overlapping";
+		labels[i]->fontPath = FONT_PATH;
+		labels[i]->height = 0.02f; // 1 pixel
+		labels[i]->declutter = true;
+		labels[i]->labelPriority = i;
+		labels[i]->position.set(0.01f * i, 0.0f);
+		layer->getRootNode()->attachChild(labels[i]);
+	}
+	layer->update(0.0f);
+
+	std::list<Renderable*> renderables;
+	labels[0]->collectRenderables(renderables, layer->viewport);
+	labels[1]->collectRenderables(renderables, layer->viewport);
+	EXPECT_TRUE(renderables.empty());
+
+	layer->labelPlacer.place(renderables, window->getScreenHeight());
+	EXPECT_EQ(1, layer->labelPlacer.getPlacedCount());
+	EXPECT_EQ(1, layer->labelPlacer.getHiddenCount());
+	ASSERT_EQ(1u, renderables.size());
+	EXPECT_EQ("RenderableLine", renderables.front()->getType());
+	delete renderables.front();
+
+	delete window;
+}
@@ -0,0 +1,137 @@
+/*
+ * Unit Tests for virtualized text views
+ */
+
+#include <cstdio>
+#include <list>
+#include <gtest/gtest.h>
+
+#include "../src/ssg/ssg_test.h"
+#include "../src/ssg/renderable.h"
+
+
+using namespace ssg;
+
+
+static const char *FONT_PATH = "assets/font/LiberationSerif-Regular.ttf";
+
+
+
+TEST(TextView, Append){
+	/**
+	 * Appended text continues the last line until a newline ends it, and the
+	 * oldest lines are dropped beyond maxLines.
+	 */
+	ComponentTextView2D view(NULL);
+
+	view.appendText("first");
+	view.appendText(" line\nsecond\n");
+	EXPECT_EQ(2, view.getLineCount());
+	EXPECT_EQ("first line", view.getLine(0));
+	EXPECT_EQ("second", view.getLine(1));
+
+	// Lines appended on their own do not continue the last one
+	view.appendText("third");
+	view.appendLine("fourth");
+	view.appendText("\n\n");
+	EXPECT_EQ(6, view.getLineCount());
+	EXPECT_EQ("third", view.getLine(2));
+	EXPECT_EQ("fourth", view.getLine(3));
+	EXPECT_EQ("", view.getLine(4));
+	EXPECT_EQ("", view.getLine(6)); // Out of range
+
+	view.maxLines = 3;
+	view.appendLine("fifth");
+	EXPECT_EQ(3, view.getLineCount());
+	EXPECT_EQ("", view.getLine(0));
+	EXPECT_EQ("fifth", view.getLine(2));
+
+	view.setText("a\nb");
+	EXPECT_EQ(2, view.getLineCount());
+	EXPECT_EQ("b", view.getLine(1));
+}
+
+
+
+TEST(TextView, Scrolling){
+	/**
+	 * The view stays at the end of the text while it is followed, and keeps its
+	 * place otherwise, even as old lines are dropped.
+	 */
+	ComponentTextView2D view(NULL);
+	view.height = 1.0f;
+	view.lineHeight = 0.1f;
+	EXPECT_EQ(10, view.getVisibleLineCount());
+
+	for(int i = 0; i < 25; i++) view.appendLine("line");
+	EXPECT_EQ(15, view.getScrollPosition());
+	EXPECT_TRUE(view.isScrolledToEnd());
+
+	view.scrollBy(-5);
+	view.appendLine("line");
+	EXPECT_EQ(10, view.getScrollPosition());
+
+	view.scrollTo(100);
+	EXPECT_EQ(16, view.getScrollPosition());
+	view.scrollTo(-1);
+	EXPECT_EQ(0, view.getScrollPosition());
+
+	view.scrollTo(5);
+	view.maxLines = 20;
+	view.appendLine("line");
+	EXPECT_EQ(20, view.getLineCount());
+	EXPECT_EQ(0, view.getScrollPosition());
+
+	view.clear();
+	EXPECT_EQ(0, view.getLineCount());
+	EXPECT_EQ(0, view.getLaidOutLineCount());
+}
+
+
+
+TEST(TextView, Virtualization){
+	/**
+	 * However long the text, only the lines in view are laid out, and
+	 * scrolling by a line lays out just the line scrolled in.
+	 */
+	Window *window = new Window(100, 100, false);
+	Layer2D *layer = new Layer2D("text");
+	window->addLayerTop(layer);
+
+	ComponentTextView2D *view = new ComponentTextView2D(window);
+	view->fontPath = FONT_PATH;
+	view->height = 1.0f;
+	view->lineHeight = 0.05f;
+	layer->getRootNode()->attachChild(view);
+
+	char line[32];
+	for(int i = 0; i < 100000; i++){
+		snprintf(line, sizeof(line), "Line %d", i);
+		view->appendLine(line);
+	}
+	view->scrollTo(50000);
+	layer->update(0.0f);
+
+	int rows = view->getVisibleLineCount();
+	EXPECT_EQ(20, rows);
+
+	std::list<Renderable*> renderables;
+	view->collectRenderables(renderables, layer->viewport);
+	EXPECT_EQ(rows, view->getLaidOutLineCount());
+	EXPECT_EQ(rows, view->getLayoutCount());
+
+	// Drawing again lays out nothing
+	view->collectRenderables(renderables, layer->viewport);
+	EXPECT_EQ(rows, view->getLayoutCount());
+
+	view->scrollBy(1);
+	view->collectRenderables(renderables, layer->viewport);
+	EXPECT_EQ(rows, view->getLaidOutLineCount());
+	EXPECT_EQ(rows + 1, view->getLayoutCount());
+
+	while(!renderables.empty()){
+		delete renderables.front();
+		renderables.pop_front();
+	}
+	delete window;
+}
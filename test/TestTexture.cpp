@@ -144,3 +144,96 @@ TEST(Texture, SingleOwner){
 
 
 
+
+
+TEST(Texture, Handles){
+	/**
+	 * Texture handles keep their texture alive until the last one lets go, and
+	 * are nulled out when their texture is deleted manually.
+	 */
+	
+	Window *window = new Window(100, 100, false);
+	
+	bool record[2];
+	RecordTexture *first = new RecordTexture(window, record);
+	RecordTexture *second = new RecordTexture(window, record + 1);
+	
+	// Copies share the texture; the last one to go deletes it
+	{
+		TextureRef a(first);
+		TextureRef b(a);
+		TextureRef c;
+		c = b;
+		EXPECT_EQ(3, first->getReferenceCount());
+		
+		a.reset();
+		EXPECT_EQ(NULL, a.get());
+		EXPECT_EQ(2, first->getReferenceCount());
+		EXPECT_EQ(true, record[0]);
+	}
+	EXPECT_EQ(false, record[0]);
+	
+	// Handles and owners of a deleted texture let go of it
+	TextureRef d(second);
+	TextureRef e(second);
+	TextureCache *owner = new TextureCache();
+	owner->addTexture(second);
+	EXPECT_EQ(3, second->getReferenceCount());
+	
+	delete second;
+	EXPECT_EQ(false, record[1]);
+	EXPECT_EQ(NULL, d.get());
+	EXPECT_EQ(NULL, e.get());
+	EXPECT_EQ(0, owner->textureCount());
+	
+	delete owner;
+	delete window;
+}
+
+
+
+
+
+TEST(Texture, SharedRegistry){
+	/**
+	 * With sharing enabled, identical solid color textures are shared until
+	 * their last owner lets go of them.
+	 */
+	
+	Window *window = new Window(100, 100, false);
+	window->textureRegistry.sharingEnabled = true;
+	
+	Texture *a = Texture::createSolidColor(8, 8, window, 0xff, 0x00, 0x00, 0xff);
+	Texture *b = Texture::createSolidColor(8, 8, window, 0xff, 0x00, 0x00, 0xff);
+	Texture *c = Texture::createSolidColor(8, 8, window, 0x00, 0xff, 0x00, 0xff);
+	ASSERT_TRUE(a != NULL);
+	EXPECT_EQ(a, b);
+	EXPECT_NE(a, c);
+	EXPECT_EQ(2, window->textureRegistry.getTextureCount());
+	
+	// Freeing a shared texture removes it from the registry
+	TextureCache *owner = new TextureCache();
+	owner->addTexture(a);
+	owner->addTexture(b);
+	delete owner;
+	EXPECT_EQ(1, window->textureRegistry.getTextureCount());
+	
+	Texture *d = Texture::createSolidColor(8, 8, window, 0xff, 0x00, 0x00, 0xff);
+	EXPECT_EQ(2, window->textureRegistry.getTextureCount());
+	
+	// Keys differ in every part of the descriptor
+	EXPECT_NE(
+		TextureRegistry::textKey("ab", "c", 12, 0, 0, 0, 0xff),
+		TextureRegistry::textKey("b", "ac", 12, 0, 0, 0, 0xff)
+	);
+	EXPECT_NE(
+		TextureRegistry::solidKey(8, 8, 0, 0, 0, 0xff),
+		TextureRegistry::solidKey(8, 8, 0, 0, 0, 0xfe)
+	);
+	
+	delete c;
+	delete d;
+	EXPECT_EQ(0, window->textureRegistry.getTextureCount());
+	
+	delete window;
+}
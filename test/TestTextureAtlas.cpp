@@ -0,0 +1,72 @@
+/*
+ * Unit Tests for the skyline packer used by texture atlases
+ */
+
+#include <cstdio>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../src/ssg/ssg_test.h"
+
+
+using namespace ssg;
+
+
+static bool rects_overlap(const SDL_Rect &a, const SDL_Rect &b){
+	return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+
+
+TEST(SkylinePacker, NoOverlap){
+	/**
+	 * Packs rectangles of assorted sizes and checks that they stay inside the
+	 * bin and never overlap.
+	 */
+	SkylinePacker packer(128, 128);
+	std::vector<SDL_Rect> placed;
+
+	for(int i = 0; i < 64; i++){
+		int w = 4 + (i * 7) % 13;
+		int h = 4 + (i * 5) % 11;
+		SDL_Rect rect;
+		if(!packer.insert(w, h, rect)) continue;
+
+		EXPECT_EQ(w, rect.w);
+		EXPECT_EQ(h, rect.h);
+		EXPECT_GE(rect.x, 0);
+		EXPECT_GE(rect.y, 0);
+		EXPECT_LE(rect.x + rect.w, 128);
+		EXPECT_LE(rect.y + rect.h, 128);
+
+		for(unsigned int j = 0; j < placed.size(); j++){
+			EXPECT_FALSE(rects_overlap(rect, placed[j]));
+		}
+		placed.push_back(rect);
+	}
+
+	EXPECT_EQ(64, (int) placed.size());
+	EXPECT_GT(packer.getOccupancy(), 0.0f);
+	EXPECT_LE(packer.getOccupancy(), 1.0f);
+}
+
+
+TEST(SkylinePacker, Full){
+	/**
+	 * Equal squares should tile the bin exactly, after which nothing else fits.
+	 */
+	SkylinePacker packer(64, 64);
+	SDL_Rect rect;
+
+	for(int i = 0; i < 16; i++){
+		ASSERT_TRUE(packer.insert(16, 16, rect));
+	}
+	EXPECT_FLOAT_EQ(1.0f, packer.getOccupancy());
+	EXPECT_FALSE(packer.insert(1, 1, rect));
+
+	// Oversized and empty rectangles are always rejected
+	packer.clear();
+	EXPECT_FALSE(packer.insert(65, 1, rect));
+	EXPECT_FALSE(packer.insert(0, 10, rect));
+	EXPECT_TRUE(packer.insert(64, 64, rect));
+}
@@ -0,0 +1,82 @@
+/*
+ * Unit Tests for the texture loader
+ */
+
+#include <cstdio>
+#include <thread>
+#include <chrono>
+#include <gtest/gtest.h>
+
+#include "../src/ssg/ssg_test.h"
+
+
+using namespace ssg;
+
+
+
+TEST(TextureLoader, PngSize){
+	/**
+	 * Reads the dimensions of a test asset from its header.
+	 */
+	int w = -1;
+	int h = -1;
+	ASSERT_TRUE(read_png_size("assets/test/button.png", w, h));
+	EXPECT_EQ(256, w);
+	EXPECT_EQ(256, h);
+}
+
+
+TEST(TextureLoader, PngSizeInvalid){
+	/**
+	 * Files which are missing, truncated or not PNGs are rejected, and the
+	 * output arguments are left alone.
+	 */
+	int w = -1;
+	int h = -1;
+	EXPECT_FALSE(read_png_size("assets/test/does_not_exist.png", w, h));
+
+	const char *path = "test_loader_header.tmp";
+	FILE *file = fopen(path, "wb");
+	ASSERT_TRUE(file != NULL);
+	const unsigned char truncated[12] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n', 0, 0, 0, 13};
+	fwrite(truncated, 1, sizeof(truncated), file);
+	fclose(file);
+	EXPECT_FALSE(read_png_size(path, w, h));
+
+	file = fopen(path, "wb");
+	ASSERT_TRUE(file != NULL);
+	fputs("GIF89a, certainly not a PNG image", file);
+	fclose(file);
+	EXPECT_FALSE(read_png_size(path, w, h));
+
+	remove(path);
+	EXPECT_EQ(-1, w);
+	EXPECT_EQ(-1, h);
+}
+
+
+
+TEST(TextureLoader, ZeroBudget){
+	/**
+	 * One decoded image is uploaded per frame even without any budget, so that
+	 * loads cannot stall.
+	 */
+	Window *window = new Window(100, 100, false);
+	window->setTextureUploadBudget(0);
+	Texture *texture = Texture::createFromFileAsync("assets/test/Red.png", window);
+	ASSERT_TRUE(texture != NULL);
+	TextureLoader *loader = window->getTextureLoader();
+	ASSERT_TRUE(loader != NULL);
+
+	int completed = 0;
+	for(int i = 0; i < 1000 && completed == 0; i++){
+		completed = loader->processUploads(0);
+		if(completed == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	EXPECT_EQ(1, completed);
+	EXPECT_FALSE(texture->isPending());
+	EXPECT_EQ(0, window->getPendingTextureCount());
+
+	delete texture;
+	delete window;
+}
@@ -0,0 +1,146 @@
+/*
+ * Unit Tests for the SDL texture pool
+ */
+
+#include <list>
+#include <gtest/gtest.h>
+
+#include "../src/ssg/ssg_test.h"
+#include "../src/ssg/renderable.h"
+
+
+using namespace ssg;
+
+
+static const char *FONT_PATH = "assets/font/LiberationSerif-Regular.ttf";
+
+
+
+TEST(TexturePool, SizeClasses){
+	/**
+	 * Sizes are rounded up to the next size class, so that textures of similar
+	 * sizes share pooled textures.
+	 */
+	EXPECT_EQ(32, TexturePool::roundSize(0));
+	EXPECT_EQ(32, TexturePool::roundSize(1));
+	EXPECT_EQ(32, TexturePool::roundSize(32));
+	EXPECT_EQ(64, TexturePool::roundSize(33));
+	EXPECT_EQ(TexturePool::roundSize(50), TexturePool::roundSize(60));
+}
+
+
+
+TEST(TexturePool, EmptyPool){
+	/**
+	 * A new pool has nothing idle, and trimming it does nothing.
+	 */
+	TexturePool pool;
+	EXPECT_EQ(0, pool.getIdleCount());
+	EXPECT_EQ(0u, pool.getIdleBytes());
+	
+	pool.trim(0);
+	pool.setCapacity(0);
+	EXPECT_EQ(0u, pool.getCapacity());
+	EXPECT_EQ(0, pool.getReuseCount());
+}
+
+
+
+
+TEST(TexturePool, Reuse){
+	/**
+	 * Released textures are handed out again for sizes of the same size class,
+	 * without any modulation left by their last user; trimming frees the least
+	 * recently released first.
+	 */
+	Window *window = new Window(100, 100, false);
+	SDL_Renderer *renderer = window->getRenderer();
+	ASSERT_TRUE(renderer != NULL);
+	TexturePool &pool = window->texturePool;
+	Uint32 format = window->getFormat()->format;
+	int access = SDL_TEXTUREACCESS_STREAMING;
+	int reuseCount = pool.getReuseCount();
+
+	SDL_Texture *first = pool.acquire(renderer, 40, 20, format, access);
+	ASSERT_TRUE(first != NULL);
+	SDL_SetTextureColorMod(first, 0x10, 0x20, 0x30);
+	SDL_SetTextureAlphaMod(first, 0x40);
+	pool.release(first);
+	EXPECT_EQ(1, pool.getIdleCount());
+
+	SDL_Texture *second = pool.acquire(renderer, 50, 30, format, access);
+	EXPECT_EQ(first, second);
+	EXPECT_EQ(reuseCount + 1, pool.getReuseCount());
+	EXPECT_EQ(0, pool.getIdleCount());
+
+	Uint8 r, g, b, a;
+	SDL_GetTextureColorMod(second, &r, &g, &b);
+	SDL_GetTextureAlphaMod(second, &a);
+	EXPECT_EQ(0xff, r);
+	EXPECT_EQ(0xff, g);
+	EXPECT_EQ(0xff, b);
+	EXPECT_EQ(0xff, a);
+
+	// The large texture was released first, so it is freed first
+	SDL_Texture *large = pool.acquire(renderer, 100, 100, format, access);
+	ASSERT_TRUE(large != NULL);
+	pool.release(large);
+	pool.release(second);
+	size_t smallBytes = (size_t) 64 * 32 * SDL_BYTESPERPIXEL(format);
+	EXPECT_EQ(2, pool.getIdleCount());
+	EXPECT_GT(pool.getIdleBytes(), smallBytes);
+
+	pool.trim(smallBytes);
+	EXPECT_EQ(1, pool.getIdleCount());
+	EXPECT_EQ(smallBytes, pool.getIdleBytes());
+
+	pool.trim(0);
+	EXPECT_EQ(0, pool.getIdleCount());
+	EXPECT_EQ(0u, pool.getIdleBytes());
+
+	delete window;
+}
+
+
+
+TEST(TexturePool, TextReuse){
+	/**
+	 * Text rasterized to a texture takes the SDL texture of the text it
+	 * replaces, when its new text is of a similar size.
+	 */
+	Window *window = new Window(100, 100, false);
+	Layer2D *layer = new Layer2D("text");
+	window->addLayerTop(layer);
+
+	ComponentSpriteText2D *label = new ComponentSpriteText2D(window);
+	label->text = "10";
+	label->fontPath = FONT_PATH;
+	label->height = 0.2f;
+	label->levelOfDetail = false;
+	label->useGlyphCache = false;
+	layer->getRootNode()->attachChild(label);
+	layer->update(0.0f);
+
+	std::list<Renderable*> renderables;
+	label->collectRenderables(renderables, layer->viewport);
+	ASSERT_TRUE(label->getTexture() != NULL);
+	SDL_Texture *sdlTexture = label->getTexture()->getSdlTexture();
+	ASSERT_TRUE(sdlTexture != NULL);
+	while(!renderables.empty()){
+		delete renderables.front();
+		renderables.pop_front();
+	}
+
+	int reuseCount = window->texturePool.getReuseCount();
+	label->text = "11";
+	label->collectRenderables(renderables, layer->viewport);
+	ASSERT_TRUE(label->getTexture() != NULL);
+	EXPECT_EQ(sdlTexture, label->getTexture()->getSdlTexture());
+	EXPECT_EQ(reuseCount + 1, window->texturePool.getReuseCount());
+	while(!renderables.empty()){
+		delete renderables.front();
+		renderables.pop_front();
+	}
+
+	delete window;
+}
@@ -0,0 +1,72 @@
+/*
+ * Unit Tests for texture residency management
+ */
+
+#include <cstdio>
+#include <gtest/gtest.h>
+
+#include "../src/ssg/ssg_test.h"
+
+
+using namespace ssg;
+
+
+
+TEST(TextureResidency, LeastRecentlyUsed){
+	/**
+	 * Draws three textures under a budget of two, and checks that the least
+	 * recently drawn one is evicted and comes back when requested.
+	 */
+	Window *window = new Window(100, 100, false);
+	ResidencyManager &residency = window->textureResidency;
+	
+	Texture *a = Texture::createSolidColor(8, 8, window, 0xff, 0x00, 0x00, 0xff);
+	Texture *b = Texture::createSolidColor(8, 8, window, 0x00, 0xff, 0x00, 0xff);
+	Texture *c = Texture::createSolidColor(8, 8, window, 0x00, 0x00, 0xff, 0xff);
+	ASSERT_TRUE(a != NULL && b != NULL && c != NULL);
+	
+	// Nothing is tracked while disabled
+	residency.touch(a);
+	EXPECT_EQ(0, residency.getResidentCount());
+	
+	residency.setBudget(2 * a->getByteSize());
+	
+	residency.touch(a);
+	residency.endFrame();
+	residency.touch(b);
+	residency.touch(a);
+	residency.endFrame();
+	EXPECT_EQ(2, residency.getResidentCount());
+	
+	// b is now the least recently drawn
+	residency.touch(c);
+	residency.endFrame();
+	EXPECT_EQ(2, residency.getResidentCount());
+	EXPECT_EQ(1, residency.getEvictionCount());
+	EXPECT_TRUE(a->isLoaded());
+	EXPECT_FALSE(b->isLoaded());
+	EXPECT_TRUE(c->isLoaded());
+	
+	// Evicted textures are reloaded on request; unloaded ones are not
+	residency.request(b);
+	EXPECT_TRUE(b->isLoaded());
+	c->unload();
+	residency.request(c);
+	EXPECT_FALSE(c->isLoaded());
+	
+	// Textures drawn in the current frame are never evicted
+	residency.setBudget(1);
+	residency.touch(a);
+	residency.touch(b);
+	residency.endFrame();
+	EXPECT_TRUE(a->isLoaded());
+	EXPECT_TRUE(b->isLoaded());
+	
+	delete a;
+	delete b;
+	delete c;
+	EXPECT_EQ(0, residency.getResidentCount());
+	EXPECT_EQ((size_t) 0, residency.getResidentBytes());
+	
+	delete window;
+}
@@ -0,0 +1,113 @@
+/*
+ * Unit Tests for texture memory accounting
+ */
+
+#include <cstdio>
+#include <gtest/gtest.h>
+
+#include "../src/ssg/ssg_test.h"
+
+
+using namespace ssg;
+
+
+static TextureKindStats find_kind(std::string kind){
+	std::list<TextureKindStats> kinds = TextureStats::getStatsByKind();
+	for(const TextureKindStats &stats : kinds){
+		if(stats.kind == kind) return stats;
+	}
+	TextureKindStats empty = {kind, 0, 0, 0, 0};
+	return empty;
+}
+
+
+
+TEST(TextureStats, Totals){
+	/**
+	 * Checks the totals by kind and by owner as solid textures are created,
+	 * unloaded and deleted.
+	 */
+	Window *window = new Window(100, 100, false);
+	int baseCount = TextureStats::getTextureCount();
+	TextureKindStats base = find_kind("solid");
+	
+	Texture *a = Texture::createSolidColor(64, 64, window, 0xff, 0x00, 0x00, 0xff);
+	Texture *b = Texture::createSolidColor(64, 64, window, 0x00, 0xff, 0x00, 0xff);
+	ASSERT_TRUE(a != NULL && b != NULL);
+	EXPECT_EQ(baseCount + 2, TextureStats::getTextureCount());
+	
+	// Solid textures take the memory of their full size
+	EXPECT_GE(a->getByteSize(), (size_t) 64 * 64);
+	EXPECT_EQ("solid", a->getKind());
+	
+	b->unload();
+	TextureKindStats solid = find_kind("solid");
+	EXPECT_EQ(base.count + 2, solid.count);
+	EXPECT_EQ(base.loadedCount + 1, solid.loadedCount);
+	EXPECT_EQ(base.unloadedBytes + b->getByteSize(), solid.unloadedBytes);
+	
+	TextureCache *owner = new TextureCache();
+	owner->addTexture(a);
+	owner->addTexture(b);
+	EXPECT_EQ(a->getByteSize(), TextureStats::getLoadedBytesByOwner()[owner]);
+	
+	std::vector<Texture*> largest = TextureStats::getLargestTextures(1);
+	EXPECT_EQ(1, (int) largest.size());
+	
+	delete owner;
+	EXPECT_EQ(baseCount, TextureStats::getTextureCount());
+	
+	delete window;
+}
+
+
+TEST(TextureStats, ShortLived){
+	/**
+	 * Textures destroyed right after their creation are counted per frame.
+	 */
+	Window *window = new Window(100, 100, false);
+	TextureStats::frameEnded(window);
+	
+	Texture *kept = Texture::createSolidColor(4, 4, window, 0, 0, 0, 0xff);
+	for(int i = 0; i < 3; i++){
+		delete Texture::createSolidColor(4, 4, window, 0, 0, 0, 0xff);
+	}
+	TextureStats::frameEnded(window);
+	EXPECT_EQ(3, TextureStats::getShortLivedCount());
+	
+	TextureStats::frameEnded(window);
+	TextureStats::frameEnded(window);
+	delete kept;
+	TextureStats::frameEnded(window);
+	EXPECT_EQ(0, TextureStats::getShortLivedCount());
+	
+	delete window;
+}
+
+
+
+TEST(TextureStats, ShortLivedPerWindow){
+	/**
+	 * Frames of other windows neither age a window's textures nor reset its
+	 * counts.
+	 */
+	Window *churning = new Window(100, 100, false);
+	Window *idle = new Window(100, 100, false);
+
+	for(int frame = 0; frame < 3; frame++){
+		Texture *texture = Texture::createSolidColor(4, 4, churning, 0, 0, 0, 0xff);
+		TextureStats::frameEnded(idle);
+		TextureStats::frameEnded(idle);
+		delete texture;
+
+		TextureStats::frameEnded(churning);
+		TextureStats::frameEnded(idle);
+		EXPECT_EQ(1, TextureStats::getShortLivedCount(churning));
+		EXPECT_EQ(0, TextureStats::getShortLivedCount(idle));
+		EXPECT_EQ(1, TextureStats::getShortLivedCount());
+	}
+
+	delete churning;
+	delete idle;
+	EXPECT_EQ(0, TextureStats::getShortLivedCount());
+}